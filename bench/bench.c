@@ -0,0 +1,682 @@
+// Gerador de carga HTTP: T threads, cada uma com seu epoll e sua parte das
+// N conexões, pedindo GET em rodízio sobre uma lista de caminhos. Mede
+// requests/s, vazão e latência num histograma no estilo HDR (erro < 1,6%).
+//
+// Dois modos:
+//   - laço fechado (padrão): cada conexão manda o próximo request assim que
+//     a resposta anterior termina; mede a capacidade máxima.
+//   - taxa constante (-r R): os requests têm horário marcado (R/s no total,
+//     igualmente espaçados por conexão) e a latência conta a partir do
+//     horário marcado, não do envio. Sem isso, uma pausa do servidor atrasa
+//     os envios seguintes e some das medidas (coordinated omission). A
+//     latência de serviço (a partir do envio real) também é mostrada.
+//
+// Com --close, cada request usa uma conexão nova (Connection: close) e a
+// latência inclui o connect.
+//
+// Uso: make bench   (ou ./bench/bench [opções] http://host:porta/caminho [caminho...])
+
+#define _GNU_SOURCE
+#include "../client_files/net.h"
+#include "../client_files/url.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_PATHS   1024
+#define HEAD_MAX    8192        // linha de status + cabeçalhos da resposta
+#define RECV_CHUNK  65536
+#define MAX_EVENTS  256
+#define RETRY_NS    100000000ULL   // espera antes de reconectar após falha no connect
+
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+        "Uso: %s [opções] http://host:porta/caminho [caminho...]\n"
+        "\n"
+        "Opções:\n"
+        "  -c N        conexões abertas (padrão 64)\n"
+        "  -t N        threads (padrão 2)\n"
+        "  -d S        duração da medida em segundos (padrão 10)\n"
+        "  -w S        aquecimento antes da medida, em segundos (padrão 1)\n"
+        "  -r R        taxa constante de R requests/s no total (padrão: laço fechado)\n"
+        "  -f ARQ      caminhos adicionais, um por linha\n"
+        "  --close     uma conexão por request (padrão: keep-alive)\n",
+        prog);
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// -----------------------------------------------------------------------------
+// Histograma log-linear (HDR): valores < 128 ns exatos; acima, 64 faixas por
+// potência de 2 (erro relativo < 1,6%), até ~2^47 ns
+// -----------------------------------------------------------------------------
+
+#define H_SUB_BITS  7
+#define H_SUB       (1u << H_SUB_BITS)
+#define H_HALF      (H_SUB / 2)
+#define H_MAX_SHIFT 40
+#define H_BUCKETS   (H_SUB + H_MAX_SHIFT * H_HALF)
+
+typedef struct {
+    uint64_t count[H_BUCKETS];
+    uint64_t n, sum, min, max;
+} Hist;
+
+static unsigned hist_index(uint64_t v) {
+    if (v < H_SUB) return (unsigned)v;
+    unsigned shift = (unsigned)(63 - __builtin_clzll(v)) - (H_SUB_BITS - 1);
+    if (shift > H_MAX_SHIFT) return H_BUCKETS - 1;
+    return H_SUB + (shift - 1) * H_HALF + (unsigned)((v >> shift) - H_HALF);
+}
+
+// Maior valor que cai no balde `i` (convenção do HdrHistogram).
+static uint64_t hist_value(unsigned i) {
+    if (i < H_SUB) return i;
+    unsigned k = i - H_SUB;
+    unsigned shift = k / H_HALF + 1;
+    uint64_t low = (uint64_t)(k % H_HALF + H_HALF) << shift;
+    return low + ((uint64_t)1 << shift) - 1;
+}
+
+static void hist_record(Hist *h, uint64_t v) {
+    h->count[hist_index(v)]++;
+    if (h->n == 0 || v < h->min) h->min = v;
+    if (v > h->max) h->max = v;
+    h->n++;
+    h->sum += v;
+}
+
+static void hist_merge(Hist *dst, const Hist *src) {
+    if (src->n == 0) return;
+    for (unsigned i = 0; i < H_BUCKETS; i++) dst->count[i] += src->count[i];
+    if (dst->n == 0 || src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+    dst->n += src->n;
+    dst->sum += src->sum;
+}
+
+static uint64_t hist_percentile(const Hist *h, double q) {
+    if (h->n == 0) return 0;
+    uint64_t rank = (uint64_t)(q / 100.0 * (double)h->n + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < H_BUCKETS; i++) {
+        seen += h->count[i];
+        if (seen >= rank) {
+            uint64_t v = hist_value(i);
+            return v > h->max ? h->max : v;
+        }
+    }
+    return h->max;
+}
+
+// -----------------------------------------------------------------------------
+// Configuração (só lida pelas threads)
+// -----------------------------------------------------------------------------
+
+static struct sockaddr_storage g_addr;
+static socklen_t g_addrlen;
+static char     *g_req[MAX_PATHS];     // requests prontos, um por caminho
+static size_t    g_req_len[MAX_PATHS];
+static int       g_npaths;
+static int       g_conns = 64, g_threads = 2;
+static bool      g_close;
+static double    g_rate;               // requests/s no total (0 = laço fechado)
+static uint64_t  g_interval;           // ns entre requests de uma conexão (taxa constante)
+static uint64_t  g_start, g_warm_end, g_end;
+
+// -----------------------------------------------------------------------------
+// Conexões
+// -----------------------------------------------------------------------------
+
+typedef enum {
+    C_IDLE,
+    C_WAIT,         // esperando o horário marcado (ou a nova tentativa)
+    C_CONNECTING,
+    C_SENDING,
+    C_READING
+} ConnState;
+
+typedef enum {
+    RX_HEAD, RX_BODY, RX_UNTIL_EOF, RX_CHUNK_LINE, RX_CHUNK_DATA, RX_CHUNK_END, RX_TRAILER
+} RxState;
+
+typedef struct {
+    int       fd;
+    ConnState state;
+    uint32_t  events;       // interesse atual no epoll
+    unsigned  path;         // próximo caminho (rodízio)
+    size_t    sent;         // bytes do request já escritos
+    uint64_t  intended;     // horário marcado (taxa constante) ou do envio
+    uint64_t  started;      // envio real (ou connect, com --close)
+    uint64_t  wake_at;      // C_WAIT: quando começar
+    unsigned  served;       // respostas nesta conexão
+
+    // Resposta em curso
+    RxState   rx;
+    char      head[HEAD_MAX];
+    size_t    hlen;
+    uint64_t  left;
+    int       status;
+    bool      close_after;
+    bool      got_any;      // já chegou algum byte da resposta
+    char      line[64];     // linha de tamanho de chunk / trailer
+    size_t    llen;
+} BConn;
+
+typedef struct {
+    int       id;
+    int       efd;
+    BConn    *conns;
+    int       nconns;
+    int       first;        // índice global da 1ª conexão (espaçamento da taxa)
+    uint64_t  next_wake;    // menor wake_at entre as conexões em C_WAIT (0 = nenhuma)
+    pthread_t th;
+
+    // Resultados (só depois do aquecimento)
+    Hist      lat;          // corrigida (taxa constante) ou simples (laço fechado)
+    Hist      svc;          // a partir do envio real
+    uint64_t  done, bytes, status[6];
+    uint64_t  err_connect, err_read, reconnects;
+} Worker;
+
+static void start_request(Worker *w, BConn *c, uint64_t now);
+
+static void conn_events(Worker *w, BConn *c, uint32_t ev) {
+    if (c->events == ev) return;
+    struct epoll_event e = { .events = ev, .data.ptr = c };
+    (void)epoll_ctl(w->efd, EPOLL_CTL_MOD, c->fd, &e);
+    c->events = ev;
+}
+
+static void conn_drop(BConn *c) {
+    if (c->fd >= 0) close(c->fd);   // sai do epoll junto
+    c->fd = -1;
+    c->served = 0;
+}
+
+static bool conn_open(Worker *w, BConn *c) {
+    c->fd = socket(g_addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (c->fd < 0) return false;
+    int one = 1;
+    (void)setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(c->fd, (struct sockaddr *)&g_addr, g_addrlen) < 0 && errno != EINPROGRESS) {
+        conn_drop(c);
+        return false;
+    }
+    c->events = EPOLLOUT;
+    struct epoll_event e = { .events = c->events, .data.ptr = c };
+    if (epoll_ctl(w->efd, EPOLL_CTL_ADD, c->fd, &e) < 0) { conn_drop(c); return false; }
+    c->state = C_CONNECTING;
+    return true;
+}
+
+static void conn_wait(Worker *w, BConn *c, uint64_t at) {
+    c->state = C_WAIT;
+    c->wake_at = at;
+    if (!w->next_wake || at < w->next_wake) w->next_wake = at;
+}
+
+// Próximo request da conexão: já, ou no horário marcado.
+static void schedule_next(Worker *w, BConn *c, uint64_t now) {
+    c->path = (c->path + 1) % (unsigned)g_npaths;
+    if (!g_interval) { start_request(w, c, now); return; }
+    c->intended += g_interval;
+    if (c->intended <= now) start_request(w, c, now);   // atrasado: envia já
+    else conn_wait(w, c, c->intended);
+}
+
+// Falha de transporte: conta e tenta de novo mais tarde, numa conexão nova.
+static void conn_fail(Worker *w, BConn *c, uint64_t now, bool connecting) {
+    if (now >= g_warm_end) {
+        if (connecting) w->err_connect++; else w->err_read++;
+    }
+    conn_drop(c);
+    if (connecting) conn_wait(w, c, now + RETRY_NS);
+    else schedule_next(w, c, now);
+}
+
+static void try_send(Worker *w, BConn *c, uint64_t now) {
+    const char *req = g_req[c->path];
+    size_t len = g_req_len[c->path];
+    while (c->sent < len) {
+        ssize_t n = send(c->fd, req + c->sent, len - c->sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            conn_events(w, c, EPOLLOUT | EPOLLIN);
+            return;
+        }
+        if (n < 0) { conn_fail(w, c, now, false); return; }
+        c->sent += (size_t)n;
+    }
+    c->state = C_READING;
+    conn_events(w, c, EPOLLIN);
+}
+
+static void start_request(Worker *w, BConn *c, uint64_t now) {
+    if (!g_interval) c->intended = now;
+    c->started = now;
+    c->sent = 0;
+    c->rx = RX_HEAD;
+    c->hlen = c->llen = 0;
+    c->got_any = false;
+    if (c->fd < 0) {
+        if (!conn_open(w, c)) conn_fail(w, c, now, true);
+        return;   // envia quando o connect terminar
+    }
+    c->state = C_SENDING;
+    try_send(w, c, now);
+}
+
+// -----------------------------------------------------------------------------
+// Resposta
+// -----------------------------------------------------------------------------
+
+static bool header_is(const char *line, const char *name, const char **value) {
+    size_t n = strlen(name);
+    if (strncasecmp(line, name, n) != 0 || line[n] != ':') return false;
+    const char *v = line + n + 1;
+    while (*v == ' ' || *v == '\t') v++;
+    *value = v;
+    return true;
+}
+
+// Linha de status e cabeçalhos completos em c->head: decide como o corpo termina.
+static bool head_parse(BConn *c, size_t hend) {
+    c->head[hend - 2] = '\0';
+    if (strncmp(c->head, "HTTP/1.", 7) != 0) return false;
+    c->status = atoi(c->head + 9);
+    c->close_after = c->head[7] == '0';
+    bool chunked = false, has_len = false;
+
+    for (char *line = strstr(c->head, "\r\n"); line; ) {
+        line += 2;
+        char *eol = strstr(line, "\r\n");
+        if (eol) *eol = '\0';
+        const char *v;
+        if (header_is(line, "Content-Length", &v)) { c->left = strtoull(v, NULL, 10); has_len = true; }
+        else if (header_is(line, "Transfer-Encoding", &v)) chunked = strcasestr(v, "chunked") != NULL;
+        else if (header_is(line, "Connection", &v)) {
+            if (strcasestr(v, "close")) c->close_after = true;
+            else if (strcasestr(v, "keep-alive")) c->close_after = false;
+        }
+        line = eol;
+    }
+
+    if (c->status == 204 || c->status == 304 || (c->status >= 100 && c->status < 200)) {
+        c->rx = RX_BODY; c->left = 0;
+    } else if (chunked) {
+        c->rx = RX_CHUNK_LINE;
+    } else if (has_len) {
+        c->rx = RX_BODY;
+    } else {
+        c->rx = RX_UNTIL_EOF;
+        c->close_after = true;
+    }
+    return true;
+}
+
+// Consome bytes da resposta. Devolve false se ela é inválida; *done quando termina.
+static bool rx_feed(BConn *c, const char *p, size_t n, bool *done) {
+    size_t used = 0;
+    *done = false;
+    while (used < n && !*done) {
+        switch (c->rx) {
+        case RX_HEAD: {
+            size_t take = n - used;
+            if (take > HEAD_MAX - c->hlen) take = HEAD_MAX - c->hlen;
+            if (take == 0) return false;   // cabeçalhos grandes demais
+            size_t old = c->hlen;
+            memcpy(c->head + old, p + used, take);
+            c->hlen += take;
+            size_t from = old >= 3 ? old - 3 : 0;
+            char *e = (char *)memmem(c->head + from, c->hlen - from, "\r\n\r\n", 4);
+            if (!e) { used += take; break; }
+            size_t hend = (size_t)(e - c->head) + 4;
+            used += hend - old;
+            if (!head_parse(c, hend)) return false;
+            if (c->rx == RX_BODY && c->left == 0) *done = true;
+            break;
+        }
+        case RX_BODY:
+        case RX_CHUNK_DATA: {
+            size_t take = n - used;
+            if (take > c->left) take = (size_t)c->left;
+            used += take;
+            c->left -= take;
+            if (c->left == 0) {
+                if (c->rx == RX_BODY) *done = true;
+                else c->rx = RX_CHUNK_END;
+            }
+            break;
+        }
+        case RX_UNTIL_EOF:
+            used = n;
+            break;
+        case RX_CHUNK_LINE:
+        case RX_CHUNK_END:
+        case RX_TRAILER: {
+            const char *nl = memchr(p + used, '\n', n - used);
+            size_t take = nl ? (size_t)(nl - (p + used)) + 1 : n - used;
+            size_t room = sizeof(c->line) - 1 - c->llen;
+            memcpy(c->line + c->llen, p + used, take < room ? take : room);
+            c->llen += take < room ? take : room;
+            used += take;
+            if (!nl) break;
+            c->line[c->llen] = '\0';
+            bool empty = c->line[0] == '\r' || c->line[0] == '\n';
+            c->llen = 0;
+            if (c->rx == RX_CHUNK_END) {
+                c->rx = RX_CHUNK_LINE;
+            } else if (c->rx == RX_TRAILER) {
+                if (empty) *done = true;
+            } else {
+                char *end;
+                c->left = strtoull(c->line, &end, 16);
+                if (end == c->line) return false;
+                c->rx = c->left ? RX_CHUNK_DATA : RX_TRAILER;
+            }
+            break;
+        }
+        }
+    }
+    return true;
+}
+
+static void on_response(Worker *w, BConn *c, uint64_t now) {
+    c->served++;
+    if (now >= g_warm_end && now < g_end) {
+        w->done++;
+        hist_record(&w->lat, now - c->intended);
+        hist_record(&w->svc, now - c->started);
+        int cls = c->status / 100;
+        w->status[cls >= 1 && cls <= 5 ? cls : 0]++;
+    }
+    if (g_close || c->close_after) conn_drop(c);
+    c->state = C_IDLE;
+    schedule_next(w, c, now);
+}
+
+static void on_eof(Worker *w, BConn *c, uint64_t now) {
+    if (c->rx == RX_UNTIL_EOF) {
+        conn_drop(c);
+        on_response(w, c, now);
+        return;
+    }
+    // Keep-alive que o servidor fechou antes de ver o request: repete o mesmo
+    // request numa conexão nova, sem contar erro
+    if (!c->got_any && c->served > 0) {
+        if (now >= g_warm_end) w->reconnects++;
+        conn_drop(c);
+        uint64_t intended = c->intended;
+        start_request(w, c, now);
+        if (g_interval) c->intended = intended;
+        return;
+    }
+    conn_fail(w, c, now, false);
+}
+
+static void on_readable(Worker *w, BConn *c, uint64_t now, char *buf) {
+    for (;;) {
+        ssize_t n = recv(c->fd, buf, RECV_CHUNK, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n < 0) { conn_fail(w, c, now, false); return; }
+        if (n == 0) { on_eof(w, c, now); return; }
+
+        c->got_any = true;
+        if (now >= g_warm_end && now < g_end) w->bytes += (uint64_t)n;
+        bool done;
+        if (!rx_feed(c, buf, (size_t)n, &done)) { conn_fail(w, c, now, false); return; }
+        if (done) { on_response(w, c, now); return; }
+    }
+}
+
+static void on_event(Worker *w, BConn *c, uint32_t ev, uint64_t now, char *buf) {
+    if (c->state == C_CONNECTING) {
+        int err = 0;
+        socklen_t el = sizeof(err);
+        (void)getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &el);
+        if (err || (ev & (EPOLLERR | EPOLLHUP))) { conn_fail(w, c, now, true); return; }
+        if (!c->started) {
+            // Aberta antes da largada: espera o horário do 1º request
+            conn_events(w, c, EPOLLIN);
+            if (now < c->intended) conn_wait(w, c, c->intended);
+            else start_request(w, c, now);
+            return;
+        }
+        c->state = C_SENDING;
+        try_send(w, c, now);
+        return;
+    }
+    if (c->state == C_SENDING && (ev & EPOLLOUT)) { try_send(w, c, now); return; }
+    if (c->state == C_READING && (ev & (EPOLLIN | EPOLLHUP | EPOLLERR))) { on_readable(w, c, now, buf); return; }
+    if (c->state == C_WAIT && (ev & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+        // Servidor fechou a conexão ociosa: reabre no próximo request
+        conn_drop(c);
+    }
+}
+
+// epoll_wait com prazo em ns: na taxa constante, acordar até 1 ms atrasado
+// (resolução do epoll_wait) apareceria como latência do servidor.
+static int wait_events(int efd, struct epoll_event *ev, int max, uint64_t timeout_ns) {
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 35)
+    static bool no_pwait2;
+    if (!no_pwait2) {
+        struct timespec ts = { (time_t)(timeout_ns / 1000000000ULL), (long)(timeout_ns % 1000000000ULL) };
+        int n = epoll_pwait2(efd, ev, max, &ts, NULL);
+        if (n >= 0 || errno != ENOSYS) return n;
+        no_pwait2 = true;   // kernel < 5.11
+    }
+#endif
+    return epoll_wait(efd, ev, max, (int)((timeout_ns + 999999) / 1000000));
+}
+
+// Inicia as conexões cujo horário chegou e recalcula o próximo.
+static void wake_due(Worker *w, uint64_t now) {
+    w->next_wake = 0;
+    for (int i = 0; i < w->nconns; i++) {
+        BConn *c = &w->conns[i];
+        if (c->state != C_WAIT) continue;
+        if (c->wake_at <= now) start_request(w, c, now);
+        else if (!w->next_wake || c->wake_at < w->next_wake) w->next_wake = c->wake_at;
+    }
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = (Worker *)arg;
+    char *buf = (char *)malloc(RECV_CHUNK);
+    if (!buf) return NULL;
+    // Sem a folga padrão de 50 µs nos timers desta thread
+    (void)prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+
+    // Em keep-alive as conexões abrem antes da largada (o handshake fica fora da medida)
+    for (int i = 0; i < w->nconns; i++) {
+        BConn *c = &w->conns[i];
+        c->fd = -1;
+        c->path = (unsigned)(w->first + i) % (unsigned)g_npaths;
+        if (!g_close) (void)conn_open(w, c);
+    }
+
+    // Largada comum; na taxa constante, as conexões se espalham pelo intervalo
+    for (int i = 0; i < w->nconns; i++) {
+        BConn *c = &w->conns[i];
+        uint64_t at = g_start;
+        if (g_interval) at += g_interval * (uint64_t)(w->first + i) / (uint64_t)g_conns;
+        c->intended = at;
+        if (c->state == C_CONNECTING) continue;   // começa quando o connect terminar
+        conn_wait(w, c, at);
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    for (;;) {
+        uint64_t now = now_ns();
+        if (now >= g_end) break;
+        uint64_t timeout = 100000000ULL;
+        if (w->next_wake) {
+            uint64_t left = w->next_wake > now ? w->next_wake - now : 0;
+            if (left < timeout) timeout = left;
+        }
+        int n = wait_events(w->efd, events, MAX_EVENTS, timeout);
+        if (n < 0 && errno != EINTR) { perror("epoll_wait"); break; }
+
+        now = now_ns();
+        for (int i = 0; i < n; i++) on_event(w, (BConn *)events[i].data.ptr, events[i].events, now, buf);
+
+        if (w->next_wake && now >= w->next_wake) wake_due(w, now);
+    }
+    free(buf);
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Relatório
+// -----------------------------------------------------------------------------
+
+static void print_latency(const char *label, const Hist *h) {
+    static const double q[] = { 50, 90, 99, 99.9, 99.99 };
+    printf("  %-10s %9.1f", label, h->n ? (double)h->sum / (double)h->n / 1000.0 : 0.0);
+    for (size_t i = 0; i < sizeof(q) / sizeof(q[0]); i++)
+        printf(" %9.1f", (double)hist_percentile(h, q[i]) / 1000.0);
+    printf(" %9.1f\n", (double)h->max / 1000.0);
+}
+
+static bool add_path(const char *host_hdr, const char *path) {
+    if (g_npaths >= MAX_PATHS) { fprintf(stderr, "Caminhos demais (máx. %d)\n", MAX_PATHS); return false; }
+    if (path[0] != '/') { fprintf(stderr, "Caminho deve começar com /: %s\n", path); return false; }
+    int n = asprintf(&g_req[g_npaths], "GET %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: http-tools-bench\r\n%s\r\n",
+                     path, host_hdr, g_close ? "Connection: close\r\n" : "");
+    if (n < 0) return false;
+    g_req_len[g_npaths++] = (size_t)n;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    double duration = 10, warmup = 1;
+    const char *url = NULL, *list_file = NULL;
+    const char *extra[MAX_PATHS];
+    int nextra = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (!strcmp(a, "-h") || !strcmp(a, "--help")) { print_usage(argv[0]); return 0; }
+        else if (!strcmp(a, "-c") && i + 1 < argc) g_conns = atoi(argv[++i]);
+        else if (!strcmp(a, "-t") && i + 1 < argc) g_threads = atoi(argv[++i]);
+        else if (!strcmp(a, "-d") && i + 1 < argc) duration = atof(argv[++i]);
+        else if (!strcmp(a, "-w") && i + 1 < argc) warmup = atof(argv[++i]);
+        else if (!strcmp(a, "-r") && i + 1 < argc) g_rate = atof(argv[++i]);
+        else if (!strcmp(a, "-f") && i + 1 < argc) list_file = argv[++i];
+        else if (!strcmp(a, "--close")) g_close = true;
+        else if (a[0] == '-') { fprintf(stderr, "Opção desconhecida: %s\n", a); print_usage(argv[0]); return 1; }
+        else if (!url) url = a;
+        else if (nextra < MAX_PATHS) extra[nextra++] = a;
+    }
+    if (!url || g_conns <= 0 || g_threads <= 0 || duration <= 0 || warmup < 0 || g_rate < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (g_threads > g_conns) g_threads = g_conns;
+
+    char host[256], path[2048], host_hdr[300];
+    int port;
+    if (!parse_url(url, host, sizeof(host), &port, path, sizeof(path))) {
+        fprintf(stderr, "URL inválida: %s\n", url);
+        return 1;
+    }
+    if (tcp_resolve(host, port, &g_addr, &g_addrlen) < 0) return 1;
+    snprintf(host_hdr, sizeof(host_hdr), strchr(host, ':') ? "[%s]:%d" : "%s:%d", host, port);
+
+    if (!add_path(host_hdr, path)) return 1;
+    for (int i = 0; i < nextra; i++) if (!add_path(host_hdr, extra[i])) return 1;
+    if (list_file) {
+        FILE *f = fopen(list_file, "r");
+        if (!f) { perror(list_file); return 1; }
+        char line[2048];
+        while (fgets(line, sizeof(line), f)) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (!line[0] || line[0] == '#') continue;
+            if (!add_path(host_hdr, line)) { fclose(f); return 1; }
+        }
+        fclose(f);
+    }
+    if (g_rate > 0) g_interval = (uint64_t)(1e9 * (double)g_conns / g_rate);
+
+    printf("Alvo: %s:%d, %d caminho(s), %d conexões em %d threads, %s, %s\n",
+           host, port, g_npaths, g_conns, g_threads, g_close ? "uma conexão por request" : "keep-alive",
+           g_rate > 0 ? "taxa constante" : "laço fechado");
+    if (g_rate > 0) printf("Taxa alvo: %.0f req/s (%.1f por conexão)\n", g_rate, g_rate / g_conns);
+    printf("Duração: %.1fs de medida após %.1fs de aquecimento\n", duration, warmup);
+    fflush(stdout);
+
+    // 200 ms para as threads abrirem as conexões antes da largada
+    g_start    = now_ns() + 200000000ULL;
+    g_warm_end = g_start + (uint64_t)(warmup * 1e9);
+    g_end      = g_warm_end + (uint64_t)(duration * 1e9);
+
+    Worker *workers = (Worker *)calloc((size_t)g_threads, sizeof(Worker));
+    if (!workers) { perror("calloc"); return 1; }
+    int first = 0;
+    for (int t = 0; t < g_threads; t++) {
+        Worker *w = &workers[t];
+        w->id = t;
+        w->first = first;
+        w->nconns = g_conns / g_threads + (t < g_conns % g_threads);
+        first += w->nconns;
+        w->conns = (BConn *)calloc((size_t)w->nconns, sizeof(BConn));
+        w->efd = epoll_create1(EPOLL_CLOEXEC);
+        if (!w->conns || w->efd < 0) { perror("worker"); return 1; }
+        int err = pthread_create(&w->th, NULL, worker_main, w);
+        if (err) { fprintf(stderr, "pthread_create: %s\n", strerror(err)); return 1; }
+    }
+
+    Worker total;
+    memset(&total, 0, sizeof(total));
+    for (int t = 0; t < g_threads; t++) {
+        Worker *w = &workers[t];
+        pthread_join(w->th, NULL);
+        hist_merge(&total.lat, &w->lat);
+        hist_merge(&total.svc, &w->svc);
+        total.done += w->done;
+        total.bytes += w->bytes;
+        for (int k = 0; k < 6; k++) total.status[k] += w->status[k];
+        total.err_connect += w->err_connect;
+        total.err_read += w->err_read;
+        total.reconnects += w->reconnects;
+    }
+
+    printf("\nRequests: %llu em %.2fs = %.1f req/s\n",
+           (unsigned long long)total.done, duration, (double)total.done / duration);
+    printf("Vazão:    %.2f MB/s\n", (double)total.bytes / duration / (1024.0 * 1024.0));
+    printf("Status:   2xx %llu, 3xx %llu, 4xx %llu, 5xx %llu, outros %llu\n",
+           (unsigned long long)total.status[2], (unsigned long long)total.status[3],
+           (unsigned long long)total.status[4], (unsigned long long)total.status[5],
+           (unsigned long long)(total.status[0] + total.status[1]));
+    printf("Erros:    connect %llu, leitura %llu; reconexões keep-alive %llu\n",
+           (unsigned long long)total.err_connect, (unsigned long long)total.err_read,
+           (unsigned long long)total.reconnects);
+    printf("\nLatência (µs)     média       p50       p90       p99     p99.9    p99.99       máx\n");
+    if (g_rate > 0) {
+        print_latency("corrigida", &total.lat);
+        print_latency("serviço", &total.svc);
+    } else {
+        print_latency("", &total.lat);
+    }
+    return total.done > 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,404 @@
+// Microbenchmarks das funções do caminho quente (servidor e cliente) sobre
+// entradas realistas: caminhos longos, nomes cheios de %XX, nomes unicode.
+//
+// Cada caso roda em lotes calibrados para ~200 µs; de 21 lotes saem o
+// mínimo e a mediana por chamada, em ciclos de CPU (perf_event_open), com
+// recuo para o TSC e depois para ns (a unidade vai em "unit"). A tabela vai
+// para stderr e o JSON (um caso por linha, para diff entre commits) para
+// stdout.
+//
+// Uso: make microbench   (ou ./bench/microbench [filtro] > saida.json)
+
+#define _GNU_SOURCE
+#include "../server_files/fs.h"
+#include "../server_files/listing.h"
+#include "../server_files/request.h"
+#include "../server_files/scan.h"
+#include "../server_files/util.h"
+#include "../client_files/json_list.h"
+#include "../client_files/url.h"
+
+#include <linux/perf_event.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define REPS        21            // lotes por caso (mediana = 11º)
+#define BATCH_NS    200000.0      // duração alvo de um lote
+
+#define KEEP(p) __asm__ volatile("" : : "r"(p) : "memory")
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// -----------------------------------------------------------------------------
+// Contador: ciclos do núcleo (perf), senão TSC, senão ns. A escolha é feita
+// uma vez; todas as medidas de uma execução usam a mesma unidade.
+// -----------------------------------------------------------------------------
+
+enum { CNT_PERF, CNT_TSC, CNT_NS };
+
+static int         g_counter = CNT_NS;
+static int         g_perf_fd = -1;
+static const char *g_unit = "ns";
+
+static bool perf_read(uint64_t *v) {
+    return read(g_perf_fd, v, sizeof(*v)) == (ssize_t)sizeof(*v);
+}
+
+static void counter_init(void) {
+    struct perf_event_attr pe;
+    memset(&pe, 0, sizeof(pe));
+    pe.type = PERF_TYPE_HARDWARE;
+    pe.size = sizeof(pe);
+    pe.config = PERF_COUNT_HW_CPU_CYCLES;
+    pe.exclude_kernel = 1;
+    pe.exclude_hv = 1;
+    g_perf_fd = (int)syscall(SYS_perf_event_open, &pe, 0, -1, -1, 0);
+    uint64_t v;
+    if (g_perf_fd >= 0 && perf_read(&v)) {
+        g_counter = CNT_PERF;
+        g_unit = "cycles";
+        return;
+    }
+    if (g_perf_fd >= 0) { close(g_perf_fd); g_perf_fd = -1; }
+#if defined(__x86_64__) || defined(__i386__)
+    g_counter = CNT_TSC;
+    g_unit = "tsc";
+#endif
+}
+
+static uint64_t counter_read(void) {
+    switch (g_counter) {
+    case CNT_PERF: {
+        uint64_t v;
+        if (perf_read(&v)) return v;
+        // Trocar de contador no meio misturaria unidades num mesmo caso
+        fprintf(stderr, "microbench: leitura do contador perf falhou\n");
+        exit(1);
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    case CNT_TSC: {
+        unsigned aux;
+        _mm_lfence();
+        return __rdtscp(&aux);
+    }
+#endif
+    default:
+        return now_ns();
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Corpora
+// -----------------------------------------------------------------------------
+
+typedef struct { const char *name, *text; } Input;
+
+// Alvos como chegam no request (ainda codificados)
+static const Input k_targets[] = {
+    { "curto",    "/index.html" },
+    { "longo",    "/docs/projetos/2024/relatorios-trimestrais/financeiro/consolidado/anexos/"
+                  "planilhas/versao-final-revisada/aprovada-pela-diretoria/relatorio-q3.pdf" },
+    { "percent",  "/fotos/Captura%20de%20tela%202025-09-19%20091159%20%28c%C3%B3pia%29%20"
+                  "%5Bfinal%5D%20%26%20revis%C3%A3o.png" },
+    { "unicode",  "/%E6%96%87%E6%A1%A3/%E3%83%AC%E3%83%9D%E3%83%BC%E3%83%88/"
+                  "%E5%B9%B4%E6%AC%A1%E5%A0%B1%E5%91%8A%E6%9B%B8%202024.pdf" },
+};
+
+// Caminhos já decodificados, como chegam em fs_join_and_sanitize
+static const Input k_paths[] = {
+    { "curto",    "/index.html" },
+    { "longo",    "/docs/projetos/2024/relatorios-trimestrais/financeiro/consolidado/anexos/"
+                  "planilhas/versao-final-revisada/aprovada-pela-diretoria/relatorio-q3.pdf" },
+    { "pontos",   "//docs/./2024//./relatorios/././financeiro//./anexos/./relatorio.pdf" },
+    { "unicode",  "/música/ação e reação/relatório final — versão 2 (cópia).pdf" },
+};
+
+// Nomes de arquivo (um segmento)
+static const Input k_names[] = {
+    { "ascii",    "relatorio-final-2024.pdf" },
+    { "espacos",  "Captura de tela 2025-09-19 091159.png" },
+    { "unicode",  "relatório de ação — versão 2 (cópia) 文档.pdf" },
+    { "aspas",    "o \"melhor\" arquivo \\ de todos \"v2\".txt" },
+};
+
+static const char *const k_mime_names[] = {
+    "index.html", "app.js", "style.css", "foto.JPG", "relatorio.pdf", "dados.json",
+    "video.mp4", "arquivo.tar.gz", "fonte.woff2", "LEIA-ME", "imagem.webp", "planilha.xlsx",
+};
+#define N_MIME (sizeof(k_mime_names) / sizeof(k_mime_names[0]))
+
+static const char *const k_urls[] = {
+    "http://localhost:5050/",
+    "http://arquivos.exemplo.com.br:5050/docs/projetos/2024/relatorio-q3.pdf",
+    "http://[::1]:5050/fotos/Captura%20de%20tela%202025-09-19%20091159.png",
+};
+#define N_URLS (sizeof(k_urls) / sizeof(k_urls[0]))
+
+// Nomes de uma listagem realista: capturas, documentos com acento, alguns
+// com aspas e o index.html (que as listagens omitem).
+static char **make_listing(size_t n) {
+    static const char *const fmt[] = {
+        "Captura de tela 2025-09-%02zu %06zu.png", "relatório-%zu-versão-%zu.pdf",
+        "backup_%zu_%zu.tar.gz", "notas \"%zu\" (%zu).txt", "IMG_%04zu%04zu.JPG",
+    };
+    char **names = (char **)calloc(n, sizeof(char *));
+    if (!names) return NULL;
+    for (size_t i = 0; i < n; i++) {
+        char buf[128];
+        if (i == n / 2) snprintf(buf, sizeof(buf), "index.html");
+        else snprintf(buf, sizeof(buf), fmt[i % 5], i % 28 + 1, i * 7919 % 1000000);
+        names[i] = strdup(buf);
+        if (!names[i]) return NULL;
+    }
+    return names;
+}
+
+// -----------------------------------------------------------------------------
+// Casos: cada um executa `iters` chamadas da função medida
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    const char *text;
+    size_t      len;
+    char      **names;
+    size_t      nnames;
+    char       *buf;
+    size_t      cap;
+} Ctx;
+
+typedef void (*CaseFn)(Ctx *x, long iters);
+
+static void run_url_decode(Ctx *x, long iters) {
+    // Decodifica no lugar: cada chamada parte de uma cópia da entrada
+    for (long i = 0; i < iters; i++) {
+        memcpy(x->buf, x->text, x->len + 1);
+        util_url_decode(x->buf);
+        KEEP(x->buf);
+    }
+}
+
+static void run_join(Ctx *x, long iters) {
+    for (long i = 0; i < iters; i++) {
+        bool ok = fs_join_and_sanitize("/srv/http-tools/files", x->text, x->buf);
+        KEEP(ok);
+        KEEP(x->buf);
+    }
+}
+
+static void run_mime(Ctx *x, long iters) {
+    (void)x;
+    for (long i = 0; i < iters; i++) {
+        const char *t = util_mime_type(k_mime_names[(size_t)i % N_MIME]);
+        KEEP(t);
+    }
+}
+
+static void run_request_line(Ctx *x, long iters) {
+    static HttpRequest r;
+    ReqLimits lim = { .max_uri = 4096, .max_headers = REQ_MAX_HEADERS, .max_head = 8192 };
+    for (long i = 0; i < iters; i++) {
+        req_reset(&r);
+        ReqStatus st = req_parse(&r, x->buf, x->len, &lim);
+        KEEP(st);
+        KEEP(&r);
+    }
+}
+
+static void run_json_escape(Ctx *x, long iters) {
+    for (long i = 0; i < iters; i++) {
+        size_t n = listing_json_escape(x->buf, x->text);
+        KEEP(n);
+        KEEP(x->buf);
+    }
+}
+
+static void run_listing_json(Ctx *x, long iters) {
+    for (long i = 0; i < iters; i++) {
+        size_t len;
+        char *body = listing_serialize(x->names, x->nnames, LISTING_JSON, "/", &len);
+        KEEP(body);
+        free(body);
+    }
+}
+
+static void run_listing_html(Ctx *x, long iters) {
+    for (long i = 0; i < iters; i++) {
+        size_t len;
+        char *body = listing_serialize(x->names, x->nnames, LISTING_HTML, "fotos/2025", &len);
+        KEEP(body);
+        free(body);
+    }
+}
+
+static void run_url_encode(Ctx *x, long iters) {
+    for (long i = 0; i < iters; i++) {
+        url_encode_segment(x->text, x->buf, x->cap);
+        KEEP(x->buf);
+    }
+}
+
+static void run_parse_url(Ctx *x, long iters) {
+    char host[256], path[2048];
+    int port;
+    (void)x;
+    for (long i = 0; i < iters; i++) {
+        bool ok = parse_url(k_urls[(size_t)i % N_URLS], host, sizeof(host), &port, path, sizeof(path));
+        KEEP(ok);
+        KEEP(host);
+        KEEP(path);
+    }
+}
+
+static void run_parse_json_list(Ctx *x, long iters) {
+    static char items[1000][512];
+    for (long i = 0; i < iters; i++) {
+        size_t n = parse_json_list(x->text, items, 1000);
+        KEEP(n);
+        KEEP(items);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Medida
+// -----------------------------------------------------------------------------
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static const char *g_filter;
+static bool        g_first = true;
+
+static void measure(const char *name, CaseFn fn, Ctx *x, size_t bytes) {
+    if (g_filter && !strstr(name, g_filter)) return;
+
+    // Calibra: dobra as iterações até um lote passar de BATCH_NS / 4
+    long iters = 1;
+    for (;;) {
+        uint64_t t0 = now_ns();
+        fn(x, iters);
+        double el = (double)(now_ns() - t0);
+        if (el >= BATCH_NS / 4 || iters >= (1L << 30)) {
+            iters = (long)((double)iters * BATCH_NS / (el > 1 ? el : 1)) + 1;
+            break;
+        }
+        iters *= 2;
+    }
+
+    double cyc[REPS], ns[REPS];
+    fn(x, iters);   // aquecimento (caches, preditor)
+    for (int r = 0; r < REPS; r++) {
+        uint64_t t0 = now_ns();
+        uint64_t c0 = counter_read();
+        fn(x, iters);
+        uint64_t c1 = counter_read();
+        uint64_t t1 = now_ns();
+        cyc[r] = (double)(c1 - c0) / (double)iters;
+        ns[r] = (double)(t1 - t0) / (double)iters;
+    }
+    qsort(cyc, REPS, sizeof(double), cmp_double);
+    qsort(ns, REPS, sizeof(double), cmp_double);
+    double med = cyc[REPS / 2], nmed = ns[REPS / 2];
+
+    fprintf(stderr, "%-32s %7zu %11.1f %11.1f %9.1f", name, bytes, cyc[0], med, nmed);
+    if (bytes && med > 0) fprintf(stderr, " %7.2f", (double)bytes / med);
+    fprintf(stderr, "\n");
+
+    printf("%s\n    {\"name\": \"%s\", \"bytes\": %zu, \"iters\": %ld, \"min\": %.2f, \"median\": %.2f, \"ns_median\": %.2f}",
+           g_first ? "" : ",", name, bytes, iters, cyc[0], med, nmed);
+    g_first = false;
+}
+
+static void case_text(const char *group, const Input *in, CaseFn fn, Ctx *x) {
+    char name[96];
+    snprintf(name, sizeof(name), "%s/%s", group, in->name);
+    x->text = in->text;
+    x->len = strlen(in->text);
+    measure(name, fn, x, x->len);
+}
+
+static char *json_of(char **names, size_t n) {
+    size_t len;
+    return listing_serialize(names, n, LISTING_JSON, "/", &len);
+}
+
+int main(int argc, char **argv) {
+    g_filter = argc > 1 ? argv[1] : NULL;
+    counter_init();
+    scan_init();
+
+    // Fica na CPU atual: migrações entre núcleos sujam a medida
+    int cpu = sched_getcpu();
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        (void)sched_setaffinity(0, sizeof(set), &set);
+    }
+
+    static char buf[1 << 20];
+    Ctx x = { .buf = buf, .cap = sizeof(buf) };
+    char **names100 = make_listing(100), **names1000 = make_listing(1000);
+    if (!names100 || !names1000) { perror("make_listing"); return 1; }
+
+    fprintf(stderr, "contador: %s; parser: %s\n", g_unit, g_scan.name);
+    fprintf(stderr, "%-32s %7s %11s %11s %9s %7s\n", "caso", "bytes", "min", "mediana", "ns", "B/un");
+    printf("{\n  \"unit\": \"%s\",\n  \"scan\": \"%s\",\n  \"results\": [", g_unit, g_scan.name);
+
+    // Servidor
+    for (size_t i = 0; i < sizeof(k_targets) / sizeof(k_targets[0]); i++)
+        case_text("util_url_decode", &k_targets[i], run_url_decode, &x);
+    for (size_t i = 0; i < sizeof(k_paths) / sizeof(k_paths[0]); i++)
+        case_text("fs_join_and_sanitize", &k_paths[i], run_join, &x);
+    measure("util_mime_type/misto", run_mime, &x, 0);
+
+    for (size_t i = 0; i < sizeof(k_targets) / sizeof(k_targets[0]); i++) {
+        // Linha de request + Host, o mínimo de um request HTTP/1.1
+        static char req[4096];
+        int n = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: localhost:5050\r\n\r\n",
+                         k_targets[i].text);
+        char name[96];
+        snprintf(name, sizeof(name), "req_parse/%s", k_targets[i].name);
+        Ctx rx = { .buf = req, .len = (size_t)n };
+        measure(name, run_request_line, &rx, (size_t)n);
+    }
+
+    for (size_t i = 0; i < sizeof(k_names) / sizeof(k_names[0]); i++)
+        case_text("listing_json_escape", &k_names[i], run_json_escape, &x);
+
+    x.names = names100;  x.nnames = 100;
+    measure("listing_serialize/json-100", run_listing_json, &x, 0);
+    measure("listing_serialize/html-100", run_listing_html, &x, 0);
+    x.names = names1000; x.nnames = 1000;
+    measure("listing_serialize/json-1000", run_listing_json, &x, 0);
+    measure("listing_serialize/html-1000", run_listing_html, &x, 0);
+
+    // Cliente
+    for (size_t i = 0; i < sizeof(k_names) / sizeof(k_names[0]); i++)
+        case_text("url_encode_segment", &k_names[i], run_url_encode, &x);
+    measure("parse_url/misto", run_parse_url, &x, 0);
+
+    char *list100 = json_of(names100, 100), *list1000 = json_of(names1000, 1000);
+    if (!list100 || !list1000) { perror("listing_serialize"); return 1; }
+    Input l100 = { "100", list100 }, l1000 = { "1000", list1000 };
+    case_text("parse_json_list", &l100, run_parse_json_list, &x);
+    case_text("parse_json_list", &l1000, run_parse_json_list, &x);
+
+    printf("\n  ]\n}\n");
+    return 0;
+}
\ No newline at end of file
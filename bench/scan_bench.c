@@ -0,0 +1,153 @@
+// Microbenchmark do parser de requests: mede req_parse() com cada
+// implementação de busca de delimitadores (escalar, SSE4.2, AVX2) sobre
+// conjuntos de cabeçalhos típicos de navegador, e confere que todas devolvem
+// as mesmas posições em entradas aleatórias.
+//
+// Uso: make scan-bench   (ou ./bench/scan_bench [iterações])
+
+#define _GNU_SOURCE
+#include "../server_files/request.h"
+#include "../server_files/scan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    const char *name;
+    const char *req;
+} Corpus;
+
+static const Corpus k_corpus[] = {
+    { "chrome-documento",
+      "GET /docs/relatorio-2024.html?ref=menu HTTP/1.1\r\n"
+      "Host: arquivos.exemplo.com.br:5050\r\n"
+      "Connection: keep-alive\r\n"
+      "Cache-Control: max-age=0\r\n"
+      "sec-ch-ua: \"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\", \"Not-A.Brand\";v=\"99\"\r\n"
+      "sec-ch-ua-mobile: ?0\r\n"
+      "sec-ch-ua-platform: \"Windows\"\r\n"
+      "Upgrade-Insecure-Requests: 1\r\n"
+      "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+      "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,image/apng,*/*;q=0.8,application/signed-exchange;v=b3;q=0.7\r\n"
+      "Sec-Fetch-Site: same-origin\r\n"
+      "Sec-Fetch-Mode: navigate\r\n"
+      "Sec-Fetch-User: ?1\r\n"
+      "Sec-Fetch-Dest: document\r\n"
+      "Referer: http://arquivos.exemplo.com.br:5050/docs/\r\n"
+      "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+      "Accept-Language: pt-BR,pt;q=0.9,en-US;q=0.8,en;q=0.7\r\n"
+      "Cookie: _ga=GA1.1.1234567890.1700000000; _ga_ABCDEF1234=GS1.1.1700000000.5.1.1700000500.0.0.0; "
+      "sessao=9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08; tema=escuro; "
+      "preferencias=%7B%22ordem%22%3A%22nome%22%2C%22visao%22%3A%22grade%22%7D\r\n"
+      "If-None-Match: \"ce8019-16fc-18df293c8d4499ec\"\r\n"
+      "If-Modified-Since: Sat, 14 Dec 2024 17:28:06 GMT\r\n"
+      "\r\n" },
+    { "firefox-imagem",
+      "GET /fotos/Captura%20de%20tela%202025-09-19%20091159.png HTTP/1.1\r\n"
+      "Host: localhost:5050\r\n"
+      "User-Agent: Mozilla/5.0 (X11; Ubuntu; Linux x86_64; rv:125.0) Gecko/20100101 Firefox/125.0\r\n"
+      "Accept: image/avif,image/webp,*/*\r\n"
+      "Accept-Language: pt-BR,pt;q=0.8,en-US;q=0.5,en;q=0.3\r\n"
+      "Accept-Encoding: gzip, deflate, br\r\n"
+      "Connection: keep-alive\r\n"
+      "Referer: http://localhost:5050/\r\n"
+      "Sec-Fetch-Dest: image\r\n"
+      "Sec-Fetch-Mode: no-cors\r\n"
+      "Sec-Fetch-Site: same-origin\r\n"
+      "Priority: u=5, i\r\n"
+      "\r\n" },
+    { "xhr-listagem",
+      "GET /?list=1 HTTP/1.1\r\n"
+      "Host: localhost:5050\r\n"
+      "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) AppleWebKit/605.1.15 (KHTML, like Gecko) Version/17.4 Safari/605.1.15\r\n"
+      "Accept: */*\r\n"
+      "Accept-Language: pt-BR,pt;q=0.9\r\n"
+      "Accept-Encoding: gzip, deflate\r\n"
+      "Connection: keep-alive\r\n"
+      "Referer: http://localhost:5050/\r\n"
+      "\r\n" },
+    { "curl",
+      "GET /teste.txt HTTP/1.1\r\n"
+      "Host: localhost:5050\r\n"
+      "User-Agent: curl/8.5.0\r\n"
+      "Accept: */*\r\n"
+      "\r\n" },
+};
+#define NCORPUS (sizeof(k_corpus) / sizeof(k_corpus[0]))
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Confere as implementações entre si em buffers aleatórios (com viés para
+// bytes de texto), a partir de todos os deslocamentos.
+static int check_equivalence(const ScanImpl **impl, int n) {
+    static char buf[256];
+    unsigned seed = 12345;
+    int bad = 0;
+    for (int round = 0; round < 2000; round++) {
+        for (size_t i = 0; i < sizeof(buf); i++) {
+            seed = seed * 1103515245u + 12345u;
+            unsigned r = (seed >> 16) & 0xff;
+            buf[i] = (char)((r < 200) ? 'a' + r % 26 : r);
+        }
+        for (size_t off = 0; off < 64; off++) {
+            const char *p = buf + off, *end = buf + sizeof(buf) - (round % 40);
+            const char *t0 = impl[0]->tchar(p, end), *g0 = impl[0]->target(p, end),
+                       *v0 = impl[0]->value(p, end);
+            for (int k = 1; k < n; k++) {
+                if (impl[k]->tchar(p, end) != t0 || impl[k]->target(p, end) != g0 ||
+                    impl[k]->value(p, end) != v0) {
+                    if (bad++ < 5) fprintf(stderr, "divergência: %s (round %d, off %zu)\n",
+                                           impl[k]->name, round, off);
+                }
+            }
+        }
+    }
+    return bad;
+}
+
+int main(int argc, char **argv) {
+    long iters = argc > 1 ? atol(argv[1]) : 1000000;
+    const ScanImpl *impl[3];
+    int n = scan_available(impl, 3);
+
+    if (check_equivalence(impl, n)) return 1;
+
+    ReqLimits lim = { .max_uri = 4096, .max_headers = REQ_MAX_HEADERS, .max_head = 8192 };
+    static HttpRequest r;
+
+    printf("%-18s %6s", "corpus", "bytes");
+    for (int k = 0; k < n; k++) printf(" %13s", impl[k]->name);
+    printf("   (ns/request; ganho sobre escalar)\n");
+
+    for (size_t c = 0; c < NCORPUS; c++) {
+        const char *req = k_corpus[c].req;
+        size_t len = strlen(req);
+        printf("%-18s %6zu", k_corpus[c].name, len);
+        double base = 0;
+        for (int k = 0; k < n; k++) {
+            scan_select(impl[k]->name);
+            double best = 1e30;
+            for (int rep = 0; rep < 5; rep++) {
+                double t0 = now_s();
+                for (long i = 0; i < iters / 5; i++) {
+                    req_reset(&r);
+                    if (req_parse(&r, req, len, &lim) != REQ_DONE) { puts("falhou"); return 1; }
+                    __asm__ volatile("" : : "r"(&r) : "memory");
+                }
+                double ns = (now_s() - t0) * 1e9 / (double)(iters / 5);
+                if (ns < best) best = ns;
+            }
+            if (k == 0) base = best;
+            if (k == 0) printf(" %13.1f", best);
+            else        printf(" %7.1f %4.2fx", best, base / best);
+        }
+        printf("\n");
+    }
+    return 0;
+}
\ No newline at end of file
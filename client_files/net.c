@@ -32,6 +32,26 @@ int tcp_connect(const char *host, int port) {
     return fd; // -1 se falhou
 }
 
+int tcp_resolve(const char *host, int port, struct sockaddr_storage *out, socklen_t *outlen) {
+    char portstr[16];
+    snprintf(portstr, sizeof portstr, "%d", port);
+
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    int err = getaddrinfo(host, portstr, &hints, &res);
+    if (err) {
+        fprintf(stderr, "getaddrinfo: %s\n", gai_strerror(err));
+        return -1;
+    }
+    memcpy(out, res->ai_addr, res->ai_addrlen);
+    *outlen = res->ai_addrlen;
+    freeaddrinfo(res);
+    return 0;
+}
+
 ssize_t recv_line(int fd, char *buf, size_t max) {
     size_t i = 0;
     while (i + 1 < max) {
@@ -1,11 +1,16 @@
 #pragma once
 #include <sys/types.h>
+#include <sys/socket.h>
 
 // Conecta a host:port (IPv4/IPv6)
 int tcp_connect(const char *host, int port);
 
+// Resolve host:port uma vez (para quem abre muitas conexões ao mesmo destino).
+// Retorna 0 ou -1 em erro.
+int tcp_resolve(const char *host, int port, struct sockaddr_storage *out, socklen_t *outlen);
+
 // Lê uma linha (terminada em CRLF) do socket
 ssize_t recv_line(int fd, char *buf, size_t max);
 
 // Remove CRLF do fim da string (útil para Transfer-Encoding: chunked)
-void trim_crlf(char *s);
+void trim_crlf(char *s);
\ No newline at end of file
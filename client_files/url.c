@@ -32,17 +32,24 @@ bool parse_url(const char *url, char *host, size_t hostsz, int *port, char *path
     const char *slash   = strchr(p, '/');
     const char *hostend = slash ? slash : (url + strlen(url));
     const char *col     = memchr(p, ':', hostend - p);
+    const char *nameend = col ? col : hostend;
 
+    // IPv6 literal: http://[::1]:5050/
+    if (*p == '[') {
+        const char *rb = memchr(p, ']', hostend - p);
+        if (!rb) return false;
+        p++;
+        nameend = rb;
+        col = (rb + 1 < hostend && rb[1] == ':') ? rb + 1 : NULL;
+    }
+
+    size_t hn = (size_t)(nameend - p);
+    if (hn == 0 || hn >= hostsz) return false;
+    memcpy(host, p, hn); host[hn] = '\0';
     if (col) {
-        size_t hn = (size_t)(col - p);
-        if (hn == 0 || hn >= hostsz) return false;
-        memcpy(host, p, hn); host[hn] = '\0';
         *port = atoi(col + 1);
         if (*port <= 0 || *port > 65535) return false;
     } else {
-        size_t hn = (size_t)(hostend - p);
-        if (hn == 0 || hn >= hostsz) return false;
-        memcpy(host, p, hn); host[hn] = '\0';
         *port = 80;
     }
 
@@ -1,32 +1,162 @@
 #include "server_files/http.h"
 #include <stdio.h>   
 #include <stdlib.h> 
+#include <string.h>
 #include <sys/stat.h>
 
 static void print_usage(const char *prog) {
     fprintf(stderr,
-        "Uso: %s [<raiz>] [<porta>]\n"
+        "Uso: %s [opções] [<raiz>] [<porta>]\n"
+        "     %s [opções] --bundle <site.pack> [<porta>]\n"
         "Ex.: %s ./files 5050\n"
-        "Se omitidos: raiz=./files, porta=5050\n",
-        prog, prog);
+        "Se omitidos: raiz=./files, porta=5050\n"
+        "\n"
+        "Opções:\n"
+        "  --workers N            nº de workers (padrão: nº de CPUs online)\n"
+        "  --pin                  fixa cada worker em uma CPU\n"
+        "  --backlog N            fila de conexões pendentes (padrão 1024; limitada por somaxconn)\n"
+        "  --defer-accept S       TCP_DEFER_ACCEPT: acorda só quando o request chega (até S s; padrão 0)\n"
+        "  --fastopen N           TCP Fast Open com fila N (padrão 0 = desligado)\n"
+        "  --keepalive-timeout S  segundos ociosa antes de fechar (0 desliga keep-alive; padrão 5)\n"
+        "  --max-requests N       requests por conexão (0 = ilimitado; padrão 100)\n"
+        "  --header-timeout S     segundos para receber linha + cabeçalhos (padrão 10)\n"
+        "  --send-timeout S       janela do ritmo mínimo de envio em segundos (padrão 10)\n"
+        "  --min-send-rate B      bytes/s que o cliente deve consumir por janela (padrão 1024)\n"
+        "  --no-sendfile          envia arquivos com read/send em vez de sendfile/splice\n"
+        "  --mmap                 envia arquivos de janelas mmap (MADV_HUGEPAGE); cache em páginas de 2 MB\n"
+        "  --readahead KB         lê KB à frente do envio com WILLNEED (0 = padrão do kernel; padrão 2048)\n"
+        "  --drop-behind MB       tira do page cache o já enviado de trechos >= MB (0 desliga; padrão 256)\n"
+        "  --cache-mb N           orçamento do cache de arquivos em MB (0 desliga; padrão 64)\n"
+        "  --max-uri N            tamanho máximo do alvo do request (padrão 1024; acima: 414)\n"
+        "  --max-headers N        nº máximo de cabeçalhos (padrão e teto 64; acima: 431)\n"
+        "  --max-header-bytes N   linha + cabeçalhos em bytes (padrão e teto 8192; acima: 431)\n"
+        "  --mime-types FILE      arquivo mime.types com tipos extras (prevalecem sobre os padrão)\n"
+        "  --bundle FILE          serve o pacote gerado por tools/pack (mmap) em vez de uma raiz\n"
+        "  --io=epoll|uring       laço de eventos (padrão epoll; uring cai para epoll se indisponível)\n"
+        "  --access-log FILE      log de acesso em FILE (\"-\" = stdout), gravado por thread própria\n"
+        "  --log-format F         common, combined (padrão) ou json\n"
+        "  --stats[=/CAMINHO]     métricas em /__stats (ou no caminho dado); ?format=json para JSON\n",
+        prog, prog, prog);
 }
 
 int main(int argc, char **argv) {
-    const char *root = (argc >= 2) ? argv[1] : "./files";
-    int port = (argc >= 3) ? atoi(argv[2]) : 5050;
+    HttpConfig cfg = {
+        .root = "./files", .port = 5050, .workers = 0, .pin_cpus = false, .backlog = 1024,
+        .keepalive_timeout = 5, .max_requests = 100, .cache_mb = 64,
+        .readahead_kb = 2048, .drop_behind_mb = 256,
+        .header_timeout = 10, .send_timeout = 10, .min_send_rate = 1024,
+        .max_uri = 1024, .max_headers = 64, .max_header_bytes = 8192,
+    };
+    int npos = 0;
 
-    if (argc >= 2 && (argv[1][0] == '-' && argv[1][1] == 'h')) {
-        print_usage(argv[0]);
-        return 0;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (a[0] == '-' && a[1] == 'h') {
+            print_usage(argv[0]);
+            return 0;
+        } else if (!strcmp(a, "--workers") && i + 1 < argc) {
+            cfg.workers = atoi(argv[++i]);
+            if (cfg.workers <= 0) {
+                fprintf(stderr, "Nº de workers inválido: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (!strcmp(a, "--pin")) {
+            cfg.pin_cpus = true;
+        } else if (!strcmp(a, "--backlog") && i + 1 < argc) {
+            cfg.backlog = atoi(argv[++i]);
+            if (cfg.backlog <= 0) {
+                fprintf(stderr, "Backlog inválido: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (!strcmp(a, "--defer-accept") && i + 1 < argc) {
+            cfg.defer_accept = atoi(argv[++i]);
+            if (cfg.defer_accept < 0) cfg.defer_accept = 0;
+        } else if (!strcmp(a, "--fastopen") && i + 1 < argc) {
+            cfg.fastopen = atoi(argv[++i]);
+            if (cfg.fastopen < 0) cfg.fastopen = 0;
+        } else if (!strcmp(a, "--keepalive-timeout") && i + 1 < argc) {
+            cfg.keepalive_timeout = atoi(argv[++i]);
+        } else if (!strcmp(a, "--max-requests") && i + 1 < argc) {
+            cfg.max_requests = atoi(argv[++i]);
+        } else if (!strcmp(a, "--header-timeout") && i + 1 < argc) {
+            cfg.header_timeout = atoi(argv[++i]);
+            if (cfg.header_timeout <= 0) {
+                fprintf(stderr, "Prazo de cabeçalhos inválido: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (!strcmp(a, "--send-timeout") && i + 1 < argc) {
+            cfg.send_timeout = atoi(argv[++i]);
+            if (cfg.send_timeout <= 0) {
+                fprintf(stderr, "Janela de envio inválida: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (!strcmp(a, "--min-send-rate") && i + 1 < argc) {
+            cfg.min_send_rate = atoi(argv[++i]);
+            if (cfg.min_send_rate < 0) cfg.min_send_rate = 0;
+        } else if (!strcmp(a, "--no-sendfile")) {
+            cfg.no_sendfile = true;
+        } else if (!strcmp(a, "--mmap")) {
+            cfg.use_mmap = true;
+        } else if (!strcmp(a, "--readahead") && i + 1 < argc) {
+            cfg.readahead_kb = atoi(argv[++i]);
+            if (cfg.readahead_kb < 0) cfg.readahead_kb = 0;
+        } else if (!strcmp(a, "--drop-behind") && i + 1 < argc) {
+            cfg.drop_behind_mb = atoi(argv[++i]);
+            if (cfg.drop_behind_mb < 0) cfg.drop_behind_mb = 0;
+        } else if (!strcmp(a, "--cache-mb") && i + 1 < argc) {
+            cfg.cache_mb = atoi(argv[++i]);
+            if (cfg.cache_mb < 0) cfg.cache_mb = 0;
+        } else if (!strcmp(a, "--max-uri") && i + 1 < argc) {
+            cfg.max_uri = atoi(argv[++i]);
+        } else if (!strcmp(a, "--max-headers") && i + 1 < argc) {
+            cfg.max_headers = atoi(argv[++i]);
+        } else if (!strcmp(a, "--max-header-bytes") && i + 1 < argc) {
+            cfg.max_header_bytes = atoi(argv[++i]);
+        } else if (!strcmp(a, "--mime-types") && i + 1 < argc) {
+            cfg.mime_types = argv[++i];
+        } else if (!strcmp(a, "--bundle") && i + 1 < argc) {
+            cfg.bundle = argv[++i];
+        } else if (!strcmp(a, "--io=uring") || !strcmp(a, "--io=epoll")) {
+            cfg.io_uring = !strcmp(a + 5, "uring");
+        } else if (!strcmp(a, "--access-log") && i + 1 < argc) {
+            cfg.access_log = argv[++i];
+        } else if (!strcmp(a, "--log-format") && i + 1 < argc) {
+            cfg.log_format = argv[++i];
+        } else if (!strcmp(a, "--stats")) {
+            cfg.stats_path = "/__stats";
+        } else if (!strncmp(a, "--stats=", 8)) {
+            cfg.stats_path = a + 8;
+            if (cfg.stats_path[0] != '/') {
+                fprintf(stderr, "Caminho de métricas inválido (deve começar com /): %s\n", cfg.stats_path);
+                return 1;
+            }
+        } else if (a[0] == '-' && a[1] == '-') {
+            fprintf(stderr, "Opção desconhecida: %s\n", a);
+            print_usage(argv[0]);
+            return 1;
+        } else if (npos == 0) {
+            cfg.root = a; npos++;
+        } else if (npos == 1) {
+            cfg.port = atoi(a); npos++;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Com --bundle não há raiz: o único posicional é a porta
+    if (cfg.bundle && npos == 1) {
+        cfg.port = atoi(cfg.root);
+        cfg.root = "./files";
     }
 
-    if (port <= 0 || port > 65535) {
-        fprintf(stderr, "Porta inválida: %d\n", port);
+    if (cfg.port <= 0 || cfg.port > 65535) {
+        fprintf(stderr, "Porta inválida: %d\n", cfg.port);
         print_usage(argv[0]);
         return 1;
     }
 
-    printf("Raiz servida: %s\n", root);
-    printf("Porta: %d\n", port);
-    return http_run(root, port);
+    printf("Raiz servida: %s\n", cfg.bundle ? cfg.bundle : cfg.root);
+    printf("Porta: %d\n", cfg.port);
+    return http_run(&cfg);
 }
\ No newline at end of file
@@ -0,0 +1,237 @@
+// Log de acesso fora do caminho de atendimento.
+//
+// Um worker nunca escreve em disco: ao terminar um request ele preenche um
+// registro num anel próprio, pré-alocado, e publica o índice com um store de
+// release. A thread de escrita percorre os anéis, formata o que encontrou
+// num buffer de 64 KB e o grava com write(2) grandes; quando não há nada,
+// dorme LOG_IDLE_MS. Se o disco não acompanhar e um anel encher, o worker
+// descarta o registro e só soma um contador: a latência do atendimento não
+// depende do log.
+
+#define _GNU_SOURCE
+#include "accesslog.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define LOG_RING_SIZE 2048          // registros por worker (potência de 2)
+#define LOG_BUF       (64 * 1024)   // lote de escrita
+#define LOG_LINE_MAX  4096          // pior caso de uma linha formatada (tudo escapado)
+#define LOG_IDLE_MS   10            // espera da thread quando os anéis estão vazios
+
+// Índices só crescem; produtor e consumidor ficam em linhas de cache próprias.
+struct LogRing {
+    _Alignas(64) uint64_t head;   // próximo a consumir (thread de escrita)
+    _Alignas(64) uint64_t tail;   // próximo a produzir (worker)
+    uint64_t   head_seen;         // cópia de head vista pelo produtor
+    uint64_t   dropped;           // só o produtor escreve
+    LogRecord *slots;
+};
+
+static LogRing  *g_rings;
+static int       g_nrings;
+static int       g_fd = -1;
+static LogFormat g_fmt;
+
+bool accesslog_parse_format(const char *name, LogFormat *out) {
+    if (!strcmp(name, "common"))   { *out = LOG_COMMON;   return true; }
+    if (!strcmp(name, "combined")) { *out = LOG_COMBINED; return true; }
+    if (!strcmp(name, "json"))     { *out = LOG_JSON;     return true; }
+    return false;
+}
+
+bool accesslog_enabled(void) {
+    return g_fd >= 0;
+}
+
+LogRing *accesslog_ring(int i) {
+    return g_rings && i < g_nrings ? &g_rings[i] : NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Produtor (worker)
+// -----------------------------------------------------------------------------
+
+LogRecord *accesslog_begin(LogRing *r) {
+    uint64_t tail = r->tail;
+    if (tail - r->head_seen >= LOG_RING_SIZE) {
+        r->head_seen = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        if (tail - r->head_seen >= LOG_RING_SIZE) {
+            __atomic_store_n(&r->dropped, r->dropped + 1, __ATOMIC_RELAXED);
+            return NULL;
+        }
+    }
+    return &r->slots[tail & (LOG_RING_SIZE - 1)];
+}
+
+void accesslog_commit(LogRing *r) {
+    __atomic_store_n(&r->tail, r->tail + 1, __ATOMIC_RELEASE);
+}
+
+// -----------------------------------------------------------------------------
+// Formatação (thread de escrita)
+// -----------------------------------------------------------------------------
+
+// Campo entre aspas no estilo do nginx: aspas, barra e bytes não imprimíveis
+// viram \xHH.
+static size_t put_clf(char *o, const char *s) {
+    if (!*s) { o[0] = '-'; return 1; }
+    size_t n = 0;
+    for (; *s; s++) {
+        unsigned char ch = (unsigned char)*s;
+        if (ch < 0x20 || ch >= 0x7f || ch == '"' || ch == '\\')
+            n += (size_t)sprintf(o + n, "\\x%02X", ch);
+        else
+            o[n++] = (char)ch;
+    }
+    return n;
+}
+
+static size_t put_json(char *o, const char *s) {
+    size_t n = 0;
+    o[n++] = '"';
+    for (; *s; s++) {
+        unsigned char ch = (unsigned char)*s;
+        if (ch == '"' || ch == '\\') { o[n++] = '\\'; o[n++] = (char)ch; }
+        else if (ch < 0x20)          n += (size_t)sprintf(o + n, "\\u%04x", ch);
+        else                         o[n++] = (char)ch;
+    }
+    o[n++] = '"';
+    return n;
+}
+
+static size_t format_record(char *o, const LogRecord *rec) {
+    struct tm tm;
+    size_t n = 0;
+    if (g_fmt == LOG_JSON) {
+        gmtime_r(&rec->when.tv_sec, &tm);
+        n += strftime(o, 32, "{\"time\":\"%Y-%m-%dT%H:%M:%S", &tm);
+        n += (size_t)sprintf(o + n, ".%03ldZ\",\"remote\":", rec->when.tv_nsec / 1000000);
+        n += put_json(o + n, rec->peer);
+        n += (size_t)sprintf(o + n, ",\"method\":");
+        n += put_json(o + n, rec->method);
+        n += (size_t)sprintf(o + n, ",\"target\":");
+        n += put_json(o + n, rec->target);
+        n += (size_t)sprintf(o + n, ",\"protocol\":");
+        n += put_json(o + n, rec->version);
+        n += (size_t)sprintf(o + n, ",\"status\":%d,\"bytes\":%llu,\"referer\":",
+                             rec->status, (unsigned long long)rec->bytes);
+        n += put_json(o + n, rec->referer);
+        n += (size_t)sprintf(o + n, ",\"user_agent\":");
+        n += put_json(o + n, rec->agent);
+        o[n++] = '}';
+        o[n++] = '\n';
+        return n;
+    }
+
+    // host - - [10/Oct/2000:13:55:36 -0700] "GET / HTTP/1.1" 200 2326
+    localtime_r(&rec->when.tv_sec, &tm);
+    n += put_clf(o, rec->peer);
+    n += strftime(o + n, 40, " - - [%d/%b/%Y:%H:%M:%S %z] \"", &tm);
+    if (rec->method[0]) {
+        n += put_clf(o + n, rec->method);
+        o[n++] = ' ';
+        n += put_clf(o + n, rec->target);
+        if (rec->version[0]) { o[n++] = ' '; n += put_clf(o + n, rec->version); }
+    } else {
+        o[n++] = '-';
+    }
+    n += (size_t)sprintf(o + n, "\" %d %llu", rec->status, (unsigned long long)rec->bytes);
+    if (g_fmt == LOG_COMBINED) {
+        o[n++] = ' '; o[n++] = '"';
+        n += put_clf(o + n, rec->referer);
+        o[n++] = '"'; o[n++] = ' '; o[n++] = '"';
+        n += put_clf(o + n, rec->agent);
+        o[n++] = '"';
+    }
+    o[n++] = '\n';
+    return n;
+}
+
+static void write_all(const char *p, size_t len) {
+    while (len > 0) {
+        ssize_t w = write(g_fd, p, len);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return;   // disco cheio etc.: perde o lote, o servidor segue
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+}
+
+static void *writer_main(void *arg) {
+    (void)arg;
+    char *buf = (char *)malloc(LOG_BUF);
+    if (!buf) return NULL;
+    size_t len = 0;
+
+    for (;;) {
+        bool any = false;
+        for (int i = 0; i < g_nrings; i++) {
+            LogRing *r = &g_rings[i];
+            uint64_t head = r->head;
+            uint64_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+            for (; head != tail; head++) {
+                if (LOG_BUF - len < LOG_LINE_MAX) { write_all(buf, len); len = 0; }
+                len += format_record(buf + len, &r->slots[head & (LOG_RING_SIZE - 1)]);
+                any = true;
+            }
+            // Libera os registros já copiados para o buffer
+            __atomic_store_n(&r->head, head, __ATOMIC_RELEASE);
+        }
+        if (len > 0) { write_all(buf, len); len = 0; }
+        if (!any) {
+            struct timespec ts = { 0, LOG_IDLE_MS * 1000000L };
+            nanosleep(&ts, NULL);
+        }
+    }
+    return NULL;
+}
+
+bool accesslog_init(const char *path, LogFormat fmt, int nrings) {
+    int fd = !strcmp(path, "-") ? STDOUT_FILENO
+                                : open(path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    g_rings = (LogRing *)aligned_alloc(64, (size_t)nrings * sizeof(LogRing));
+    if (!g_rings) { if (fd != STDOUT_FILENO) close(fd); return false; }
+    memset(g_rings, 0, (size_t)nrings * sizeof(LogRing));
+    for (int i = 0; i < nrings; i++) {
+        g_rings[i].slots = (LogRecord *)calloc(LOG_RING_SIZE, sizeof(LogRecord));
+        if (!g_rings[i].slots) goto fail;
+    }
+    g_nrings = nrings;
+    g_fmt = fmt;
+    g_fd = fd;
+
+    pthread_t th;
+    if (pthread_create(&th, NULL, writer_main, NULL) != 0) {
+        g_fd = -1;
+        g_nrings = 0;
+        goto fail;
+    }
+    pthread_detach(th);
+    return true;
+
+fail:
+    // Anéis ainda não alocados estão zerados (free(NULL))
+    for (int i = 0; i < nrings; i++) free(g_rings[i].slots);
+    free(g_rings);
+    g_rings = NULL;
+    if (fd != STDOUT_FILENO) close(fd);
+    return false;
+}
+
+void accesslog_stats(AccessLogStats *out) {
+    out->written = out->dropped = 0;
+    for (int i = 0; i < g_nrings; i++) {
+        out->written += __atomic_load_n(&g_rings[i].head, __ATOMIC_RELAXED);
+        out->dropped += __atomic_load_n(&g_rings[i].dropped, __ATOMIC_RELAXED);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+// server_files/accesslog.h
+// Log de acesso assíncrono: cada worker grava registros de tamanho fixo num
+// anel próprio (um produtor, um consumidor) e uma thread de escrita os
+// formata e grava em lotes. Anel cheio = registro descartado e contado.
+#ifndef ACCESSLOG_H
+#define ACCESSLOG_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+typedef enum {
+    LOG_COMMON,      // Common Log Format
+    LOG_COMBINED,    // CLF + Referer e User-Agent
+    LOG_JSON         // um objeto JSON por linha
+} LogFormat;
+
+#define LOG_PEER_MAX    48
+#define LOG_METHOD_MAX  16
+#define LOG_TARGET_MAX  256
+#define LOG_HEADER_MAX  128   // Referer e User-Agent
+
+// Campos truncados no limite; vazios saem como "-" nos formatos CLF.
+typedef struct {
+    struct timespec when;              // CLOCK_REALTIME
+    uint64_t bytes;                    // tamanho da resposta (cabeçalhos + corpo)
+    int      status;
+    char     peer[LOG_PEER_MAX];
+    char     method[LOG_METHOD_MAX];
+    char     target[LOG_TARGET_MAX];
+    char     version[12];              // "HTTP/1.1" (vazio se não houve)
+    char     referer[LOG_HEADER_MAX];
+    char     agent[LOG_HEADER_MAX];
+} LogRecord;
+
+typedef struct LogRing LogRing;
+
+typedef struct {
+    uint64_t written, dropped;
+} AccessLogStats;
+
+bool accesslog_parse_format(const char *name, LogFormat *out);
+
+// Abre `path` ("-" = stdout) para acréscimo, cria `nrings` anéis e sobe a
+// thread de escrita.
+bool accesslog_init(const char *path, LogFormat fmt, int nrings);
+bool accesslog_enabled(void);
+
+// Anel do worker `i` (NULL com o log desligado).
+LogRing *accesslog_ring(int i);
+
+// Reserva o próximo registro do anel para ser preenchido no lugar; NULL se o
+// anel está cheio (o descarte já foi contado). accesslog_commit publica.
+LogRecord *accesslog_begin(LogRing *r);
+void       accesslog_commit(LogRing *r);
+
+void accesslog_stats(AccessLogStats *out);
+
+#endif
\ No newline at end of file
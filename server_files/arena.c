@@ -0,0 +1,197 @@
+// Arenas e pools de objetos.
+//
+// Uma arena é uma lista de blocos; alocar é avançar um índice no bloco
+// corrente, e liberar é zerar os índices de todos de uma vez. Cada conexão
+// tem a sua e a zera quando a fila de saída esvazia, então os segmentos da
+// resposta, o caminho do request e corpos montados na hora não passam pelo
+// malloc. Os blocos sobreviventes ao reset (até ARENA_KEEP) servem o request
+// seguinte da mesma conexão keep-alive.
+//
+// As pools guardam objetos de tamanho fixo (Conn, estado do io_uring) em
+// lâminas com uma lista livre; abrir e fechar conexões só toca o heap quando
+// a pool passa do maior número de conexões simultâneas já visto.
+
+#include "arena.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALIGN 16   // alinhamento de toda alocação (>= max_align_t)
+
+struct ArenaChunk {
+    ArenaChunk *next;
+    size_t      cap, used;
+    _Alignas(ALIGN) char data[];
+};
+
+static ArenaStats g_stats;
+
+static void *heap_alloc(size_t n) {
+    void *p = malloc(n);
+    if (p) {
+        __atomic_fetch_add(&g_stats.heap_allocs, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&g_stats.heap_bytes, n, __ATOMIC_RELAXED);
+    }
+    return p;
+}
+
+static void heap_free(void *p, size_t n) {
+    free(p);
+    __atomic_fetch_add(&g_stats.heap_frees, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&g_stats.heap_bytes, n, __ATOMIC_RELAXED);
+}
+
+static size_t round_up(size_t n) {
+    return (n + ALIGN - 1) & ~(size_t)(ALIGN - 1);
+}
+
+// -----------------------------------------------------------------------------
+// Arena
+// -----------------------------------------------------------------------------
+
+// Bloco com ao menos `n` livres: o menor que sirva entre os guardados pelo
+// último reset (um pedido pequeno não ocupa o bloco de um corpo grande), senão
+// um novo, maior que o padrão se o pedido não couber nele.
+static ArenaChunk *chunk_take(Arena *a, size_t n) {
+    ArenaChunk **best = NULL;
+    for (ArenaChunk **pp = &a->spare; *pp; pp = &(*pp)->next) {
+        if ((*pp)->cap >= n && (!best || (*pp)->cap < (*best)->cap)) best = pp;
+    }
+    if (best) {
+        ArenaChunk *k = *best;
+        *best = k->next;
+        return k;
+    }
+    size_t cap = n > ARENA_CHUNK ? n : ARENA_CHUNK;
+    ArenaChunk *k = (ArenaChunk *)heap_alloc(sizeof(*k) + cap);
+    if (!k) return NULL;
+    k->cap = cap;
+    return k;
+}
+
+void *arena_alloc(Arena *a, size_t n) {
+    n = round_up(n ? n : 1);
+    ArenaChunk *k = a->head;
+    if (!k || k->cap - k->used < n) {
+        k = chunk_take(a, n);
+        if (!k) return NULL;
+        k->used = 0;
+        k->next = a->head;
+        a->head = k;
+    }
+    char *p = k->data + k->used;
+    k->used += n;
+    a->last = p;
+    return p;
+}
+
+void *arena_grow(Arena *a, void *p, size_t old, size_t n) {
+    if (!p) return arena_alloc(a, n);
+    if (n <= old) return p;
+    ArenaChunk *k = a->head;
+    size_t at = (size_t)((char *)p - k->data);
+    if (p == a->last && at + n <= k->cap) {
+        k->used = at + round_up(n);
+        return p;
+    }
+    void *q = arena_alloc(a, n);
+    if (q) memcpy(q, p, old);
+    return q;
+}
+
+char *arena_strndup(Arena *a, const char *s, size_t n) {
+    char *p = (char *)arena_alloc(a, n + 1);
+    if (!p) return NULL;
+    memcpy(p, s, n);
+    p[n] = '\0';
+    return p;
+}
+
+char *arena_printf(Arena *a, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n < 0) return NULL;
+
+    char *p = (char *)arena_alloc(a, (size_t)n + 1);
+    if (!p) return NULL;
+    va_start(ap, fmt);
+    vsnprintf(p, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    return p;
+}
+
+void arena_reset(Arena *a) {
+    ArenaChunk *k = a->head;
+    if (!k) return;
+    // Junta os em uso aos de reserva e fica com o que couber em ARENA_KEEP
+    while (k->next) k = k->next;
+    k->next = a->spare;
+    k = a->head;
+    a->head = a->spare = NULL;
+    a->last = NULL;
+
+    size_t kept = 0;
+    while (k) {
+        ArenaChunk *next = k->next;
+        if (kept + k->cap <= ARENA_KEEP) {
+            kept += k->cap;
+            k->used = 0;
+            k->next = a->spare;
+            a->spare = k;
+        } else {
+            heap_free(k, sizeof(*k) + k->cap);
+        }
+        k = next;
+    }
+}
+
+void arena_free(Arena *a) {
+    arena_reset(a);
+    for (ArenaChunk *k = a->spare, *next; k; k = next) {
+        next = k->next;
+        heap_free(k, sizeof(*k) + k->cap);
+    }
+    a->spare = NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Pool
+// -----------------------------------------------------------------------------
+
+void *pool_get(Pool *p) {
+    size_t size = round_up(p->size);
+    if (!p->free) {
+        // Lâmina nova: todos os objetos dela entram na lista livre
+        unsigned n = p->per_slab ? p->per_slab : 1;
+        char *slab = (char *)heap_alloc(size * n);
+        if (!slab) return NULL;
+        for (unsigned i = n; i-- > 0;) {
+            void **obj = (void **)(slab + (size_t)i * size);
+            *obj = p->free;
+            p->free = obj;
+        }
+    }
+    void **obj = (void **)p->free;
+    p->free = *obj;
+    memset(obj, 0, p->size);
+    __atomic_fetch_add(&g_stats.pool_objs, 1, __ATOMIC_RELAXED);
+    return obj;
+}
+
+void pool_put(Pool *p, void *obj) {
+    if (!obj) return;
+    *(void **)obj = p->free;
+    p->free = obj;
+    __atomic_fetch_sub(&g_stats.pool_objs, 1, __ATOMIC_RELAXED);
+}
+
+void arena_stats(ArenaStats *out) {
+    out->heap_allocs = __atomic_load_n(&g_stats.heap_allocs, __ATOMIC_RELAXED);
+    out->heap_frees  = __atomic_load_n(&g_stats.heap_frees, __ATOMIC_RELAXED);
+    out->heap_bytes  = __atomic_load_n(&g_stats.heap_bytes, __ATOMIC_RELAXED);
+    out->pool_objs   = __atomic_load_n(&g_stats.pool_objs, __ATOMIC_RELAXED);
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+// server_files/arena.h
+// Memória de rascunho sem malloc no caminho quente: arenas (alocação por
+// incremento, liberadas de uma vez) para o que vive só durante uma resposta,
+// e pools de objetos de tamanho fixo em lâminas (slabs) para as conexões.
+#ifndef ARENA_H
+#define ARENA_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARENA_CHUNK (16 * 1024)   // tamanho padrão de um bloco da arena
+#define ARENA_KEEP  (256 * 1024)  // blocos guardados por arena_reset (leitor de diretório + página de listagem)
+
+typedef struct ArenaChunk ArenaChunk;
+
+// Zerada = vazia (nenhum bloco ainda).
+typedef struct {
+    ArenaChunk *head;    // blocos em uso, o corrente primeiro
+    ArenaChunk *spare;   // blocos devolvidos por arena_reset, prontos para reuso
+    char       *last;    // última alocação (arena_grow cresce essa no lugar)
+} Arena;
+
+// Memória alinhada para qualquer tipo, válida até o próximo arena_reset.
+// NULL só se faltar memória para um bloco novo.
+void *arena_alloc(Arena *a, size_t n);
+
+// Como realloc: a última alocação cresce no próprio bloco quando cabe;
+// senão copia para um espaço novo (o antigo só volta no reset).
+void *arena_grow(Arena *a, void *p, size_t old, size_t n);
+
+char *arena_strndup(Arena *a, const char *s, size_t n);
+char *arena_printf(Arena *a, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+// Descarta tudo de uma vez; guarda até ARENA_KEEP bytes de blocos para as
+// próximas alocações e devolve o resto ao sistema.
+void arena_reset(Arena *a);
+void arena_free(Arena *a);
+
+// Pool de objetos de `size` bytes, alocados `per_slab` por vez e nunca
+// devolvidos ao sistema (a pool fica no pico de uso). Sem trava: cada pool
+// pertence a uma thread.
+typedef struct {
+    size_t    size;
+    unsigned  per_slab;
+    void     *free;      // lista livre (o próprio objeto guarda o próximo)
+} Pool;
+
+#define POOL_INIT(type, n) { .size = sizeof(type), .per_slab = (n) }
+
+void *pool_get(Pool *p);   // zerado, como calloc
+void  pool_put(Pool *p, void *obj);
+
+// Contadores globais de idas ao heap por arenas e pools. Em regime, com as
+// conexões já abertas, heap_allocs para de crescer.
+typedef struct {
+    uint64_t heap_allocs, heap_frees;
+    size_t   heap_bytes;   // blocos e lâminas em uso agora
+    uint64_t pool_objs;    // objetos entregues pelas pools, ainda em uso
+} ArenaStats;
+
+void arena_stats(ArenaStats *out);
+
+#endif
\ No newline at end of file
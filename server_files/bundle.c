@@ -0,0 +1,271 @@
+// Pacote de site mapeado em memória (--bundle).
+//
+// O arquivo inteiro é mapeado só para leitura e nunca mais muda: uma troca
+// de versão é gerar o pacote novo ao lado e renomeá-lo por cima (rename é
+// atômico), depois reiniciar o servidor, que só lê o índice para subir. Os
+// workers leem o mapeamento sem locks; um request custa uma busca binária
+// na tabela e o envio, direto das páginas do pacote.
+
+#define _GNU_SOURCE
+#include "bundle.h"
+#include "listing.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char      *g_map;     // pacote inteiro (NULL = desligado)
+static size_t           g_size;
+static const PackEntry *g_ents;
+static uint32_t         g_count;
+static const char      *g_strs;
+static uint64_t         g_strs_len;
+
+typedef struct {
+    char     *rel;
+    BundleDir d;
+} DirSlot;
+
+static DirSlot *g_dirs;    // ordenados por rel
+static size_t   g_ndirs;
+
+bool bundle_enabled(void) {
+    return g_map != NULL;
+}
+
+size_t bundle_count(void) {
+    return g_count;
+}
+
+const char *bundle_str(uint32_t off) {
+    return g_strs + off;
+}
+
+const char *bundle_data(const PackBlob *b) {
+    return g_map + b->off;
+}
+
+// -----------------------------------------------------------------------------
+// Abertura: tudo que um request vai ler é conferido aqui, uma vez
+// -----------------------------------------------------------------------------
+
+static bool str_ok(uint32_t off) {
+    return off < g_strs_len && memchr(g_strs + off, '\0', g_strs_len - off) != NULL;
+}
+
+static bool entry_ok(const PackEntry *e) {
+    if (!str_ok(e->path) || !str_ok(e->ctype)) return false;
+    if (!memchr(e->etag, '\0', sizeof(e->etag)) ||
+        !memchr(e->last_modified, '\0', sizeof(e->last_modified))) return false;
+    if (!(e->variants & (1u << PACK_IDENTITY))) return false;
+    for (int v = 0; v < PACK_VARIANTS; v++) {
+        if (!(e->variants & (1u << v))) continue;
+        const PackBlob *b = &e->body[v];
+        if (b->off > g_size || b->len > g_size - b->off) return false;
+    }
+    return true;
+}
+
+// madvise exige início alinhado à página.
+static void willneed(const void *p, size_t len) {
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t a = (uintptr_t)p & ~(page - 1);
+    (void)madvise((void *)a, len + ((uintptr_t)p - a), MADV_WILLNEED);
+}
+
+static bool build_dirs(void);
+static void free_dirs(void);
+
+static bool fail(const char *file, const char *why) {
+    fprintf(stderr, "pacote %s: %s\n", file, why);
+    free_dirs();
+    if (g_map) munmap((void *)g_map, g_size);
+    g_map = NULL;
+    return false;
+}
+
+bool bundle_open(const char *file) {
+    int fd = open(file, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        if (fd >= 0) close(fd);
+        return fail(file, strerror(errno));
+    }
+    if ((size_t)st.st_size < sizeof(PackHeader)) { close(fd); return fail(file, "curto demais"); }
+
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return fail(file, strerror(errno));
+    g_map = (const char *)p;
+    g_size = (size_t)st.st_size;
+
+    const PackHeader *h = (const PackHeader *)p;
+    if (memcmp(h->magic, PACK_MAGIC, sizeof(h->magic)) != 0) return fail(file, "não é um pacote");
+    if (h->version != PACK_VERSION) return fail(file, "versão desconhecida");
+    if (h->size != g_size) return fail(file, "tamanho não confere (truncado?)");
+    if (h->entries % _Alignof(PackEntry) != 0 || h->entries > g_size ||
+        (uint64_t)h->count * sizeof(PackEntry) > g_size - h->entries ||
+        h->strings > g_size || h->strings_len > g_size - h->strings || h->strings_len == 0)
+        return fail(file, "índice fora do arquivo");
+
+    g_ents = (const PackEntry *)(g_map + h->entries);
+    g_count = h->count;
+    g_strs = g_map + h->strings;
+    g_strs_len = h->strings_len;
+
+    // Índice e strings são lidos em todo request: já vão para a memória.
+    // Os corpos entram sob demanda, pelo readahead do kernel.
+    willneed(g_ents, (size_t)g_count * sizeof(PackEntry));
+    willneed(g_strs, g_strs_len);
+
+    for (uint32_t i = 0; i < g_count; i++) {
+        if (!entry_ok(&g_ents[i])) return fail(file, "entrada corrompida");
+        if (i > 0 && strcmp(bundle_str(g_ents[i - 1].path), bundle_str(g_ents[i].path)) >= 0)
+            return fail(file, "tabela de caminhos fora de ordem");
+    }
+    if (!build_dirs()) return fail(file, "sem memória para as listagens");
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Busca
+// -----------------------------------------------------------------------------
+
+// Primeira entrada com caminho >= `key` (comparando só os `n` primeiros bytes
+// dele quando `prefix`).
+static uint32_t lower_bound(const char *key, size_t n, bool prefix) {
+    uint32_t lo = 0, hi = g_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        const char *p = bundle_str(g_ents[mid].path);
+        int cmp = prefix ? strncmp(p, key, n) : strcmp(p, key);
+        if (cmp < 0) lo = mid + 1;
+        else         hi = mid;
+    }
+    return lo;
+}
+
+const PackEntry *bundle_find(const char *rel) {
+    if (!g_map || !*rel) return NULL;
+    uint32_t i = lower_bound(rel, 0, false);
+    return (i < g_count && !strcmp(bundle_str(g_ents[i].path), rel)) ? &g_ents[i] : NULL;
+}
+
+long bundle_list(const char *rel, const char **names, size_t *lens, size_t max) {
+    if (!g_map) return -1;
+
+    // Prefixo "rel/" (vazio na raiz); as entradas com ele são contíguas
+    char pre[4096];
+    size_t pl = strlen(rel);
+    if (pl + 2 > sizeof(pre)) return -1;
+    memcpy(pre, rel, pl);
+    if (pl) pre[pl++] = '/';
+    pre[pl] = '\0';
+
+    long total = 0;
+    const char *last = NULL;
+    size_t last_len = 0;
+    for (uint32_t i = lower_bound(pre, pl, true); i < g_count; i++) {
+        const char *p = bundle_str(g_ents[i].path);
+        if (strncmp(p, pre, pl) != 0) break;
+        const char *name = p + pl;
+        const char *slash = strchr(name, '/');
+        size_t len = slash ? (size_t)(slash - name) : strlen(name);
+        // Arquivos do mesmo subdiretório são vizinhos: repetição só com o anterior
+        if (last && len == last_len && !memcmp(name, last, len)) continue;
+        if ((size_t)total < max) { names[total] = name; lens[total] = len; }
+        total++;
+        last = name;
+        last_len = len;
+    }
+    return total > 0 ? total : -1;
+}
+// -----------------------------------------------------------------------------
+// Listagens: serializadas uma vez, na abertura
+// -----------------------------------------------------------------------------
+
+static int cmp_dir(const void *a, const void *b) {
+    return strcmp(((const DirSlot *)a)->rel, ((const DirSlot *)b)->rel);
+}
+
+const BundleDir *bundle_dir(const char *rel) {
+    DirSlot key = { .rel = (char *)rel };
+    DirSlot *s = g_ndirs ? (DirSlot *)bsearch(&key, g_dirs, g_ndirs, sizeof(DirSlot), cmp_dir) : NULL;
+    return s ? &s->d : NULL;
+}
+
+static void free_dirs(void) {
+    for (size_t i = 0; i < g_ndirs; i++) {
+        free(g_dirs[i].rel);
+        free(g_dirs[i].d.html);
+        free(g_dirs[i].d.json);
+    }
+    free(g_dirs);
+    g_dirs = NULL;
+    g_ndirs = 0;
+}
+
+// Serializa as listagens do diretório formado pelos `n` primeiros bytes de `p`.
+static bool add_dir(const char *p, size_t n, size_t *cap) {
+    if (g_ndirs == *cap) {
+        size_t nc = *cap ? *cap * 2 : 64;
+        DirSlot *v = (DirSlot *)realloc(g_dirs, nc * sizeof(*v));
+        if (!v) return false;
+        g_dirs = v;
+        *cap = nc;
+    }
+    DirSlot *s = &g_dirs[g_ndirs];
+    memset(s, 0, sizeof(*s));
+    s->rel = strndup(p, n);
+    if (!s->rel) return false;
+    g_ndirs++;   // a partir daqui free_dirs() solta o que houver
+
+    long k = bundle_list(s->rel, NULL, NULL, 0);
+    if (k < 0) k = 0;
+    const char **v = (const char **)malloc(((size_t)k + 1) * sizeof(*v));
+    size_t *lens = (size_t *)malloc(((size_t)k + 1) * sizeof(*lens));
+    char **names = (char **)calloc((size_t)k + 1, sizeof(*names));
+    char *url = (char *)malloc(n + 2);
+    bool ok = v && lens && names && url;
+    if (ok) {
+        bundle_list(s->rel, v, lens, (size_t)k);
+        for (long i = 0; i < k && ok; i++) ok = (names[i] = strndup(v[i], lens[i])) != NULL;
+    }
+    if (ok) {
+        url[0] = '/';
+        memcpy(url + 1, p, n);
+        url[n + 1] = '\0';
+        s->d.html = listing_serialize(names, (size_t)k, LISTING_HTML, url, &s->d.html_len);
+        s->d.json = listing_serialize(names, (size_t)k, LISTING_JSON, "", &s->d.json_len);
+        ok = s->d.html && s->d.json;
+    }
+    if (names) for (long i = 0; i < k; i++) free(names[i]);
+    free(names);
+    free(lens);
+    free(v);
+    free(url);
+    return ok;
+}
+
+// Todo prefixo "dir/" de um caminho é diretório. As entradas com o mesmo
+// prefixo são vizinhas na tabela, então ele é novo só na primeira delas.
+static bool build_dirs(void) {
+    size_t cap = 0;
+    if (!add_dir("", 0, &cap)) return false;
+    for (uint32_t i = 0; i < g_count; i++) {
+        const char *p = bundle_str(g_ents[i].path);
+        const char *prev = i > 0 ? bundle_str(g_ents[i - 1].path) : NULL;
+        for (const char *s = strchr(p, '/'); s; s = strchr(s + 1, '/')) {
+            size_t n = (size_t)(s - p);
+            if (prev && !strncmp(prev, p, n + 1)) continue;
+            if (!add_dir(p, n, &cap)) return false;
+        }
+    }
+    qsort(g_dirs, g_ndirs, sizeof(DirSlot), cmp_dir);
+    return true;
+}
\ No newline at end of file
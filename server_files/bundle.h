@@ -0,0 +1,75 @@
+// server_files/bundle.h
+// Pacote de site (--bundle): a raiz inteira compilada por tools/pack num só
+// arquivo, mapeado na partida. Uma tabela de caminhos ordenada resolve cada
+// request por busca binária, sem tocar no sistema de arquivos; tipo, ETag,
+// Last-Modified e as variantes pré-comprimidas já vêm prontos.
+//
+// Formato (inteiros na ordem de bytes da máquina que gerou o pacote):
+//   PackHeader | PackEntry[count] (ordenadas por caminho) | strings | corpos
+#ifndef BUNDLE_H
+#define BUNDLE_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PACK_MAGIC   "HTPACK\r\n"   // 8 bytes, sem NUL
+#define PACK_VERSION 1
+
+// Representações de um arquivo; PackEntry.variants tem o bit 1u << PACK_*
+// de cada uma presente (a identidade está sempre).
+enum { PACK_IDENTITY, PACK_GZIP, PACK_BR, PACK_VARIANTS };
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t count;           // nº de entradas
+    uint64_t entries;         // deslocamento de PackEntry[count]
+    uint64_t strings;         // tabela de strings terminadas em NUL
+    uint64_t strings_len;
+    uint64_t size;            // tamanho total (detecta pacote truncado)
+} PackHeader;
+
+typedef struct {
+    uint64_t off, len;        // no pacote
+} PackBlob;
+
+typedef struct {
+    uint32_t path;            // na tabela de strings: relativo à raiz, sem "/" inicial
+    uint32_t ctype;           // Content-Type a servir
+    uint32_t variants;
+    uint32_t reserved;
+    int64_t  mtime;
+    char     etag[24];        // "\"<hash do conteúdo>\"", terminado em NUL
+    char     last_modified[32];
+    PackBlob body[PACK_VARIANTS];
+} PackEntry;
+
+// Mapeia e confere o pacote (limites de cada entrada e ordem da tabela).
+// false com a mensagem já impressa.
+bool bundle_open(const char *file);
+bool bundle_enabled(void);
+size_t bundle_count(void);
+
+// Entrada do caminho `rel` (sem "/" inicial; "" = raiz) ou NULL.
+const PackEntry *bundle_find(const char *rel);
+const char *bundle_str(uint32_t off);
+const char *bundle_data(const PackBlob *b);
+
+// Nomes imediatamente sob o diretório `rel` (arquivos e subdiretórios, em
+// ordem, sem repetição), gravados em `names` até `max`. Devolve o total,
+// que pode passar de `max`, ou -1 se `rel` não é diretório do pacote. Os
+// nomes apontam para dentro do pacote e terminam em `lens[i]` bytes (sem NUL).
+long bundle_list(const char *rel, const char **names, size_t *lens, size_t max);
+
+// Listagens prontas de um diretório do pacote, feitas em bundle_open(): o
+// pacote não muda, então servem todos os requests sem serializar de novo.
+// Os links do HTML partem de "/<rel>".
+typedef struct {
+    char  *html, *json;
+    size_t html_len, json_len;
+} BundleDir;
+
+// Diretório `rel` (sem "/" inicial; "" = raiz) ou NULL.
+const BundleDir *bundle_dir(const char *rel);
+
+#endif
\ No newline at end of file
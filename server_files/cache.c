@@ -0,0 +1,469 @@
+// Cache de respostas prontas em memória.
+//
+// Tabela hash (encadeada) + lista LRU, protegidas por um mutex curto: o lock
+// só cobre busca/inserção e o ajuste da LRU; o envio usa a entrada fora dele,
+// segurando uma referência. Entradas removidas (LRU ou inotify) só são
+// liberadas quando a última conexão que as envia termina.
+//
+// Invalidação: cada diretório com arquivo em cache ganha um watch de inotify;
+// uma thread dedicada lê os eventos e remove as entradas afetadas. Os mesmos
+// eventos são repassados a um ouvinte opcional (cache de listagens).
+//
+// Com --mmap, corpos a partir de 2 MB ficam em memória anônima alinhada e
+// marcada com MADV_HUGEPAGE: uma entrada de 4 MB ocupa duas entradas de TLB
+// em vez de mil ao ser copiada para o socket.
+
+#define _GNU_SOURCE
+#include "cache.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define CACHE_MIN_BUCKETS 1024
+#define CACHE_MAX_ENTRY   (4u << 20)   // maior corpo aceito (limitado a budget/4)
+#define HUGE_SIZE         (2u << 20)   // página grande (x86-64/arm64 com páginas de 4 KB)
+#define WATCH_MASK (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | \
+                    IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+
+// Diretório observado: watch descriptor -> caminho.
+typedef struct Watch {
+    int   wd;
+    char *dir;
+} Watch;
+
+static struct {
+    bool             on;
+    size_t           budget, bytes, entries;
+    CacheEntry     **buckets;
+    size_t           nbuckets;           // potência de 2
+    CacheEntry      *lru_head, *lru_tail;
+    pthread_mutex_t  mu;
+
+    int              ifd;                // inotify
+    Watch           *watches;
+    size_t           nwatches, capwatches;
+    uint64_t         epoch;              // incrementa a cada evento (atômico)
+    CacheDirListener listener;
+
+    uint64_t         hits, misses, inserts, evictions, invalidations;  // atômicos
+} g_cache = { .mu = PTHREAD_MUTEX_INITIALIZER, .ifd = -1 };
+
+static bool g_huge;   // cache_set_hugepages (fixo depois da partida)
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+// FNV-1a 64 bits.
+static uint64_t hash_key(const char *s) {
+    uint64_t h = 1469598103934665603ULL;
+    while (*s) { h ^= (unsigned char)*s++; h *= 1099511628211ULL; }
+    return h;
+}
+
+static size_t entry_cost(const CacheEntry *e) {
+    return sizeof(*e) + strlen(e->key) + 1 + e->hdr_len + e->body_len;
+}
+
+static void entry_free(CacheEntry *e) {
+    free(e->key);
+    cache_free_data(e->data, e->hdr_len + e->body_len);
+    free(e);
+}
+
+static void lru_unlink(CacheEntry *e) {
+    if (e->lprev) e->lprev->lnext = e->lnext; else g_cache.lru_head = e->lnext;
+    if (e->lnext) e->lnext->lprev = e->lprev; else g_cache.lru_tail = e->lprev;
+    e->lprev = e->lnext = NULL;
+}
+
+static void lru_push_front(CacheEntry *e) {
+    e->lprev = NULL;
+    e->lnext = g_cache.lru_head;
+    if (g_cache.lru_head) g_cache.lru_head->lprev = e; else g_cache.lru_tail = e;
+    g_cache.lru_head = e;
+}
+
+static CacheEntry **bucket_of(uint64_t h) {
+    return &g_cache.buckets[h & (g_cache.nbuckets - 1)];
+}
+
+// Tira a entrada da tabela e da LRU (lock segurado) e solta a referência da
+// tabela; quem ainda estiver enviando mantém a memória viva.
+static void entry_remove_locked(CacheEntry *e) {
+    CacheEntry **pp = bucket_of(e->hash);
+    while (*pp && *pp != e) pp = &(*pp)->hnext;
+    if (*pp) *pp = e->hnext;
+    lru_unlink(e);
+    e->linked = false;
+    g_cache.bytes -= entry_cost(e);
+    g_cache.entries--;
+    cache_release(e);
+}
+
+static CacheEntry *lookup_locked(const char *key, uint64_t h) {
+    for (CacheEntry *e = *bucket_of(h); e; e = e->hnext)
+        if (e->hash == h && !strcmp(e->key, key)) return e;
+    return NULL;
+}
+
+// Dobra a tabela quando a carga passa de 1 entrada por bucket.
+static void maybe_grow_locked(void) {
+    if (g_cache.entries < g_cache.nbuckets) return;
+    size_t n = g_cache.nbuckets * 2;
+    CacheEntry **nb = (CacheEntry **)calloc(n, sizeof(*nb));
+    if (!nb) return;
+    for (size_t i = 0; i < g_cache.nbuckets; i++) {
+        CacheEntry *e = g_cache.buckets[i];
+        while (e) {
+            CacheEntry *next = e->hnext;
+            CacheEntry **b = &nb[e->hash & (n - 1)];
+            e->hnext = *b; *b = e;
+            e = next;
+        }
+    }
+    free(g_cache.buckets);
+    g_cache.buckets = nb;
+    g_cache.nbuckets = n;
+}
+
+// -----------------------------------------------------------------------------
+// Invalidação (inotify)
+// -----------------------------------------------------------------------------
+
+static const char *watch_dir_of(int wd) {
+    for (size_t i = 0; i < g_cache.nwatches; i++)
+        if (g_cache.watches[i].wd == wd) return g_cache.watches[i].dir;
+    return NULL;
+}
+
+static void watch_forget_locked(int wd) {
+    for (size_t i = 0; i < g_cache.nwatches; i++) {
+        if (g_cache.watches[i].wd == wd) {
+            free(g_cache.watches[i].dir);
+            g_cache.watches[i] = g_cache.watches[--g_cache.nwatches];
+            return;
+        }
+    }
+}
+
+// Remove todas as entradas cujo caminho começa por `dir/` (ou todas, se NULL).
+static void invalidate_prefix_locked(const char *dir) {
+    size_t dl = dir ? strlen(dir) : 0;
+    CacheEntry *e = g_cache.lru_head;
+    while (e) {
+        CacheEntry *next = e->lnext;
+        if (!dir || (!strncmp(e->key, dir, dl) && e->key[dl] == '/')) {
+            entry_remove_locked(e);
+            __atomic_fetch_add(&g_cache.invalidations, 1, __ATOMIC_RELAXED);
+        }
+        e = next;
+    }
+}
+
+static void invalidate_key_locked(const char *key) {
+    CacheEntry *e = lookup_locked(key, hash_key(key));
+    if (e) {
+        entry_remove_locked(e);
+        __atomic_fetch_add(&g_cache.invalidations, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Remove o arquivo e todas as suas variantes comprimidas.
+static void invalidate_file_locked(const char *path) {
+    invalidate_key_locked(path);
+    char vkey[PATH_MAX + 16];
+    for (unsigned enc = 1; enc <= CACHE_VARIANT_MAX; enc++) {
+        snprintf(vkey, sizeof(vkey), "%s" CACHE_VARIANT_FMT, path, enc);
+        invalidate_key_locked(vkey);
+    }
+}
+
+static void handle_event(const struct inotify_event *ev) {
+    char dir_copy[PATH_MAX];
+    const char *ldir = NULL;      // diretório repassado ao ouvinte
+
+    pthread_mutex_lock(&g_cache.mu);
+    __atomic_fetch_add(&g_cache.epoch, 1, __ATOMIC_RELEASE);
+
+    const char *wdir = watch_dir_of(ev->wd);
+    if (wdir && snprintf(dir_copy, sizeof(dir_copy), "%s", wdir) < (int)sizeof(dir_copy))
+        ldir = dir_copy;
+
+    if (ev->mask & IN_Q_OVERFLOW) {
+        // Eventos perdidos: não há como saber o que mudou
+        invalidate_prefix_locked(NULL);
+    } else if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+        const char *dir = watch_dir_of(ev->wd);
+        if (dir) invalidate_prefix_locked(dir);
+        if (ev->mask & IN_IGNORED) watch_forget_locked(ev->wd);
+    } else if (ev->len > 0) {
+        const char *dir = watch_dir_of(ev->wd);
+        if (dir) {
+            char path[PATH_MAX];
+            snprintf(path, sizeof(path), "%s/%s", dir, ev->name);
+            invalidate_file_locked(path);
+
+            // Irmão pré-comprimido: as variantes do original ficam velhas
+            size_t pl = strlen(path);
+            if (pl > 3 && (!strcmp(path + pl - 3, ".gz") || !strcmp(path + pl - 3, ".br"))) {
+                path[pl - 3] = '\0';
+                invalidate_file_locked(path);
+                path[pl - 3] = '.';
+            }
+            // Um subdiretório renomeado/removido leva junto o que estava sob ele
+            if (ev->mask & (IN_ISDIR)) invalidate_prefix_locked(path);
+        }
+    }
+    CacheDirListener fn = g_cache.listener;
+    pthread_mutex_unlock(&g_cache.mu);
+
+    // Fora do lock: o ouvinte tem o próprio mutex. A época já avançou, então
+    // quem inserir depois dela (cache_epoch) verá este evento aplicado.
+    if (!fn) return;
+    if (ev->mask & IN_Q_OVERFLOW) fn(NULL, NULL, ev->mask);
+    else if (ldir) fn(ldir, ev->len ? ev->name : NULL, ev->mask);
+}
+
+static void *watch_thread(void *arg) {
+    (void)arg;
+    char buf[64 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t n = read(g_cache.ifd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) { perror("inotify read"); break; }
+        for (char *p = buf; p < buf + n; ) {
+            const struct inotify_event *ev = (const struct inotify_event *)p;
+            handle_event(ev);
+            p += sizeof(*ev) + ev->len;
+        }
+    }
+    return NULL;
+}
+
+// Observa os primeiros `dl` bytes de `path` como diretório (lock segurado).
+// Idempotente; devolve o caminho sob o qual os eventos serão reportados.
+static const char *watch_dir_locked(const char *path, size_t dl) {
+    for (size_t i = 0; i < g_cache.nwatches; i++) {
+        const char *d = g_cache.watches[i].dir;
+        if (strlen(d) == dl && !strncmp(d, path, dl)) return d;
+    }
+
+    char dir[PATH_MAX];
+    if (dl >= sizeof(dir)) return NULL;
+    memcpy(dir, path, dl); dir[dl] = '\0';
+
+    int wd = inotify_add_watch(g_cache.ifd, dir, WATCH_MASK);
+    if (wd < 0) return NULL;
+
+    // inotify devolve o mesmo wd para o mesmo inode (ex.: outro caminho)
+    const char *known = watch_dir_of(wd);
+    if (known) return known;
+
+    if (g_cache.nwatches == g_cache.capwatches) {
+        size_t cap = g_cache.capwatches ? g_cache.capwatches * 2 : 16;
+        Watch *tmp = (Watch *)realloc(g_cache.watches, cap * sizeof(*tmp));
+        if (!tmp) { inotify_rm_watch(g_cache.ifd, wd); return NULL; }
+        g_cache.watches = tmp; g_cache.capwatches = cap;
+    }
+    g_cache.watches[g_cache.nwatches].wd = wd;
+    g_cache.watches[g_cache.nwatches].dir = strdup(dir);
+    if (!g_cache.watches[g_cache.nwatches].dir) { inotify_rm_watch(g_cache.ifd, wd); return NULL; }
+    return g_cache.watches[g_cache.nwatches++].dir;
+}
+
+// Observa o diretório pai de `key` (lock segurado).
+static bool watch_parent_locked(const char *key) {
+    const char *slash = strrchr(key, '/');
+    if (!slash || slash == key) return false;
+    return watch_dir_locked(key, (size_t)(slash - key)) != NULL;
+}
+
+// -----------------------------------------------------------------------------
+// API
+// -----------------------------------------------------------------------------
+
+bool cache_init(size_t budget) {
+    if (budget == 0) return true;
+
+    g_cache.ifd = inotify_init1(IN_CLOEXEC);
+    if (g_cache.ifd < 0) { perror("inotify_init1"); return false; }
+
+    g_cache.nbuckets = CACHE_MIN_BUCKETS;
+    g_cache.buckets = (CacheEntry **)calloc(g_cache.nbuckets, sizeof(*g_cache.buckets));
+    if (!g_cache.buckets) { close(g_cache.ifd); return false; }
+
+    pthread_t th;
+    int err = pthread_create(&th, NULL, watch_thread, NULL);
+    if (err) {
+        fprintf(stderr, "pthread_create: %s\n", strerror(err));
+        free(g_cache.buckets); close(g_cache.ifd);
+        return false;
+    }
+    pthread_detach(th);
+
+    g_cache.budget = budget;
+    g_cache.on = true;
+    return true;
+}
+
+bool cache_enabled(void) {
+    return g_cache.on;
+}
+
+void cache_set_hugepages(bool on) {
+    g_huge = on;
+}
+
+static size_t huge_round(size_t n) {
+    return (n + HUGE_SIZE - 1) & ~(size_t)(HUGE_SIZE - 1);
+}
+
+// O tamanho decide de onde veio o bloco, então quem libera só precisa dele.
+char *cache_alloc(size_t n) {
+    if (!g_huge || n < HUGE_SIZE) return (char *)malloc(n ? n : 1);
+
+    // Mapeia uma página a mais e apara as pontas para alinhar a 2 MB
+    size_t len = huge_round(n);
+    char *p = (char *)mmap(NULL, len + HUGE_SIZE, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+    char *a = (char *)(((uintptr_t)p + HUGE_SIZE - 1) & ~(uintptr_t)(HUGE_SIZE - 1));
+    if (a > p) munmap(p, (size_t)(a - p));
+    munmap(a + len, (size_t)(p + HUGE_SIZE - a));
+    (void)madvise(a, len, MADV_HUGEPAGE);   // EINVAL sem THP: fica em páginas normais
+    return a;
+}
+
+void cache_free_data(char *data, size_t n) {
+    if (!data) return;
+    if (!g_huge || n < HUGE_SIZE) free(data);
+    else munmap(data, huge_round(n));
+}
+
+size_t cache_max_body(void) {
+    size_t m = g_cache.budget / 4;
+    return m < CACHE_MAX_ENTRY ? m : CACHE_MAX_ENTRY;
+}
+
+CacheEntry *cache_get(const char *key) {
+    if (!g_cache.on) return NULL;
+    uint64_t h = hash_key(key);
+
+    pthread_mutex_lock(&g_cache.mu);
+    CacheEntry *e = lookup_locked(key, h);
+    if (e) {
+        if (g_cache.lru_head != e) { lru_unlink(e); lru_push_front(e); }
+        __atomic_fetch_add(&e->refs, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&g_cache.mu);
+
+    if (e) __atomic_fetch_add(&g_cache.hits, 1, __ATOMIC_RELAXED);
+    return e;
+}
+
+void cache_note_miss(void) {
+    __atomic_fetch_add(&g_cache.misses, 1, __ATOMIC_RELAXED);
+}
+
+// Referência extra (ex.: mais de um trecho da mesma entrada na fila).
+void cache_retain(CacheEntry *e) {
+    __atomic_fetch_add(&e->refs, 1, __ATOMIC_RELAXED);
+}
+
+// Assinatura genérica (void *) para servir de callback de segmento.
+void cache_release(void *entry) {
+    CacheEntry *e = (CacheEntry *)entry;
+    if (__atomic_sub_fetch(&e->refs, 1, __ATOMIC_ACQ_REL) == 0) entry_free(e);
+}
+
+bool cache_begin(const char *key, uint64_t *epoch) {
+    if (!g_cache.on) return false;
+    pthread_mutex_lock(&g_cache.mu);
+    bool ok = watch_parent_locked(key);
+    *epoch = __atomic_load_n(&g_cache.epoch, __ATOMIC_ACQUIRE);
+    pthread_mutex_unlock(&g_cache.mu);
+    return ok;
+}
+
+bool cache_watch_dir(const char *dir, uint64_t *epoch) {
+    if (!g_cache.on) return false;
+    pthread_mutex_lock(&g_cache.mu);
+    const char *d = watch_dir_locked(dir, strlen(dir));
+    // Mesmo inode já observado por outro caminho: os eventos chegariam com
+    // um nome que o chamador não reconheceria
+    bool ok = d && !strcmp(d, dir);
+    *epoch = __atomic_load_n(&g_cache.epoch, __ATOMIC_ACQUIRE);
+    pthread_mutex_unlock(&g_cache.mu);
+    return ok;
+}
+
+uint64_t cache_epoch(void) {
+    return __atomic_load_n(&g_cache.epoch, __ATOMIC_ACQUIRE);
+}
+
+void cache_set_dir_listener(CacheDirListener fn) {
+    pthread_mutex_lock(&g_cache.mu);
+    g_cache.listener = fn;
+    pthread_mutex_unlock(&g_cache.mu);
+}
+
+CacheEntry *cache_insert(const char *key, char *data, size_t hdr_len, size_t body_len,
+                         uint64_t epoch) {
+    CacheEntry *e = (CacheEntry *)calloc(1, sizeof(*e));
+    if (!e || !(e->key = strdup(key))) { free(e); cache_free_data(data, hdr_len + body_len); return NULL; }
+    e->hash = hash_key(key);
+    e->data = data;
+    e->hdr_len = hdr_len;
+    e->body_len = body_len;
+    e->refs = 1;   // referência do chamador
+
+    size_t cost = entry_cost(e);
+    if (!g_cache.on) return e;   // cache desligado: a entrada serve só este request
+    pthread_mutex_lock(&g_cache.mu);
+    if (cost > g_cache.budget || __atomic_load_n(&g_cache.epoch, __ATOMIC_ACQUIRE) != epoch) {
+        // Não cabe ou algo mudou durante a leitura: serve uma vez e descarta
+        pthread_mutex_unlock(&g_cache.mu);
+        return e;
+    }
+
+    CacheEntry *old = lookup_locked(key, e->hash);
+    if (old) entry_remove_locked(old);
+    while (g_cache.bytes + cost > g_cache.budget && g_cache.lru_tail) {
+        entry_remove_locked(g_cache.lru_tail);
+        __atomic_fetch_add(&g_cache.evictions, 1, __ATOMIC_RELAXED);
+    }
+
+    CacheEntry **b = bucket_of(e->hash);
+    e->hnext = *b; *b = e;
+    lru_push_front(e);
+    e->linked = true;
+    e->refs++;     // referência da tabela
+    g_cache.bytes += cost;
+    g_cache.entries++;
+    maybe_grow_locked();
+    pthread_mutex_unlock(&g_cache.mu);
+
+    __atomic_fetch_add(&g_cache.inserts, 1, __ATOMIC_RELAXED);
+    return e;
+}
+
+void cache_stats(CacheStats *out) {
+    out->hits          = __atomic_load_n(&g_cache.hits, __ATOMIC_RELAXED);
+    out->misses        = __atomic_load_n(&g_cache.misses, __ATOMIC_RELAXED);
+    out->inserts       = __atomic_load_n(&g_cache.inserts, __ATOMIC_RELAXED);
+    out->evictions     = __atomic_load_n(&g_cache.evictions, __ATOMIC_RELAXED);
+    out->invalidations = __atomic_load_n(&g_cache.invalidations, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&g_cache.mu);
+    out->entries = g_cache.entries;
+    out->bytes   = g_cache.bytes;
+    out->budget  = g_cache.budget;
+    pthread_mutex_unlock(&g_cache.mu);
+}
\ No newline at end of file
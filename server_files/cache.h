@@ -0,0 +1,86 @@
+// server_files/cache.h
+// Cache em memória de respostas prontas (cabeçalhos + corpo), chaveado pelo
+// caminho resolvido. Compartilhado entre workers; LRU com orçamento de bytes
+// e invalidação por inotify.
+#ifndef CACHE_H
+#define CACHE_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "util.h"
+
+typedef struct CacheEntry {
+    struct CacheEntry *hnext;          // cadeia do bucket
+    struct CacheEntry *lprev, *lnext;  // LRU (cabeça = mais recente)
+    char     *key;
+    uint64_t  hash;
+    char     *data;                    // cabeçalhos (sem Connection) + corpo
+    size_t    hdr_len, body_len;
+    Validators val;                    // para responder 304 sem tocar no disco
+    const char *ctype;                 // Content-Type (string estática)
+    const char *encoding;              // Content-Encoding (estática; NULL = identidade)
+    bool      vary;                    // depende de Accept-Encoding
+    int       refs;                    // tabela + conexões enviando (atômico)
+    bool      linked;                  // ainda está na tabela
+} CacheEntry;
+
+// Representações comprimidas de um arquivo ficam sob "<caminho>//enc<N>",
+// N = máscara ENC_* aceita pelo cliente. Caminhos resolvidos nunca contêm
+// "//", então a chave não colide com arquivo algum; a invalidação de um
+// arquivo (ou de seus irmãos .gz/.br) remove também essas variantes.
+#define CACHE_VARIANT_FMT "//enc%u"
+#define CACHE_VARIANT_MAX 3u
+
+typedef struct {
+    uint64_t hits, misses, inserts, evictions, invalidations;
+    size_t   entries, bytes, budget;
+} CacheStats;
+
+// Liga o cache com `budget` bytes (0 = desligado) e sobe a thread de inotify.
+bool cache_init(size_t budget);
+bool cache_enabled(void);
+
+// Maior corpo aceito no cache.
+size_t cache_max_body(void);
+
+// Memória dos dados de uma entrada (cabeçalhos + corpo), a única aceita por
+// cache_insert. Com páginas grandes ligadas (--mmap, antes de servir), blocos
+// a partir de 2 MB vêm de mmap com MADV_HUGEPAGE; cache_free_data precisa do
+// mesmo tamanho pedido.
+void  cache_set_hugepages(bool on);
+char *cache_alloc(size_t n);
+void  cache_free_data(char *data, size_t n);
+
+// Busca: devolve a entrada com uma referência (liberar com cache_release).
+// Acertos são contados aqui; a falta é contada uma vez por request pelo
+// chamador (que pode tentar mais de uma chave) com cache_note_miss().
+CacheEntry *cache_get(const char *key);
+void cache_note_miss(void);
+void cache_retain(CacheEntry *e);
+void cache_release(void *entry);
+
+// Inserção em duas fases: cache_begin() garante o watch do diretório e
+// devolve a época atual; cache_insert() descarta a entrada se algum evento
+// de inotify chegou entre as duas (o arquivo pode ter mudado durante a leitura).
+// `data` (de cache_alloc) passa a pertencer ao cache; a entrada volta com uma
+// referência.
+bool cache_begin(const char *key, uint64_t *epoch);
+CacheEntry *cache_insert(const char *key, char *data, size_t hdr_len, size_t body_len,
+                         uint64_t epoch);
+
+// Observa o próprio diretório `dir` (para quem guarda algo derivado dele,
+// como listagens) e devolve a época atual; cache_epoch() diferente depois
+// indica que algum evento chegou no meio.
+bool cache_watch_dir(const char *dir, uint64_t *epoch);
+uint64_t cache_epoch(void);
+
+// Ouvinte dos eventos de inotify, chamado na thread do watcher depois da
+// invalidação: `dir` é o diretório observado, `name` a entrada afetada (NULL
+// em eventos do próprio diretório) e `mask` a máscara IN_*. dir == NULL
+// (IN_Q_OVERFLOW) significa que eventos foram perdidos.
+typedef void (*CacheDirListener)(const char *dir, const char *name, uint32_t mask);
+void cache_set_dir_listener(CacheDirListener fn);
+
+void cache_stats(CacheStats *out);
+
+#endif
\ No newline at end of file
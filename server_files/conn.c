@@ -0,0 +1,566 @@
+// Conexões não bloqueantes: fila de saída em segmentos (memória/arquivo) e
+// envio parcial. Quem monta a resposta só enfileira; o laço de eventos chama
+// conn_flush() sempre que o socket aceitar mais bytes.
+//
+// Trechos de arquivo saem sem cópia para o espaço de usuário: sendfile(2)
+// por padrão; se o sistema de arquivos não suportar, splice(2) passando por
+// um pipe da conexão; e, em último caso (ou com --no-sendfile), pread/send.
+// Com --mmap, o arquivo é mapeado em janelas alinhadas a 2 MB com
+// MADV_HUGEPAGE e enviado com send() direto do mapeamento.
+//
+// Trechos maiores que a janela de readahead levam dicas ao kernel:
+// SEQUENTIAL ao enfileirar (dobra o readahead do arquivo) e, durante o envio,
+// WILLNEED da próxima janela, para que um disco frio leia à frente do socket.
+// Trechos a partir de --drop-behind soltam do page cache, com DONTNEED, o que
+// já foi enviado: um download de vários GB não expulsa os arquivos quentes.
+//
+// Segmentos de memória consecutivos (cabeçalhos, corpos copiados ou por
+// referência, respostas em pipeline) saem juntos num único sendmsg com
+// iovecs. Se ainda há algo depois deles, vão com MSG_MORE, e o kernel junta
+// os cabeçalhos aos primeiros bytes do arquivo em vez de mandar um segmento
+// TCP pequeno só com eles; respostas com vários trechos de arquivo (multipart)
+// ficam sob TCP_CORK até a fila esvaziar.
+//
+// Os segmentos e os bytes copiados vêm da arena da conexão, zerada sempre
+// que a fila esvazia (resposta enviada, ou antes de pedir mais ao produtor):
+// em regime, montar e enviar uma resposta não chama malloc. Os objetos Conn
+// vêm de uma pool por worker.
+
+#define _GNU_SOURCE
+#include "conn.h"
+#include "stats.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define SEG_MIN_CAP  1024         // capacidade inicial de um segmento de memória
+#define FILE_CHUNK   (16 * 1024)  // bloco de leitura ao enviar arquivos (modo cópia)
+#define ZC_CHUNK     (1 << 20)    // máximo por chamada de sendfile/splice
+#define HINT_MIN     (256 * 1024) // trechos menores não recebem dicas de page cache
+#define IOV_BATCH    64           // segmentos de memória por sendmsg
+#define MAP_ALIGN    (2 << 20)    // janelas mmap alinhadas a página grande
+#define MAP_WINDOW   (64 << 20)   // tamanho máximo de uma janela mmap
+#define DROP_LAG     (16 << 20)   // DONTNEED só do que ficou esta distância para trás
+
+// Caminho de envio de arquivos; um segmento pode rebaixar o seu se o
+// sistema de arquivos recusar sendfile, splice ou mmap (EINVAL/ENOSYS/ENODEV).
+enum { FMODE_SENDFILE = 0, FMODE_SPLICE = 1, FMODE_COPY = 2, FMODE_MMAP = 3 };
+static int g_file_mode = FMODE_SENDFILE;
+
+static size_t g_readahead;     // janela de WILLNEED (0 = só SEQUENTIAL)
+static off_t  g_drop_behind;   // trechos a partir daqui soltam o que já saiu (0 = nunca)
+
+void conn_set_zero_copy(bool on) {
+    g_file_mode = on ? FMODE_SENDFILE : FMODE_COPY;
+}
+
+void conn_set_mmap(bool on) {
+    if (on) g_file_mode = FMODE_MMAP;
+}
+
+void conn_set_file_hints(size_t readahead, off_t drop_behind) {
+    g_readahead = readahead;
+    g_drop_behind = drop_behind;
+}
+
+// -----------------------------------------------------------------------------
+// Helpers de segmento
+// -----------------------------------------------------------------------------
+
+static Seg *seg_push(Conn *c, SegKind kind) {
+    Seg *s = (Seg *)arena_alloc(&c->arena, sizeof(*s));
+    if (!s) return NULL;
+    memset(s, 0, sizeof(*s));
+    s->kind = kind;
+    s->ffd = -1;
+    s->fmode = (unsigned char)g_file_mode;
+    s->ra_end = s->drop_from = -1;
+    if (c->out_tail) c->out_tail->next = s; else c->out_head = s;
+    c->out_tail = s;
+    return s;
+}
+
+// A memória do segmento fica na arena; aqui só se soltam os recursos.
+static void seg_free(Seg *s) {
+    if (s->map) munmap(s->map, s->map_len);
+    if (s->kind == SEG_FILE && s->ffd >= 0) {
+        // O resto enviado também sai do page cache (páginas ainda presas ao
+        // socket o kernel pula)
+        if (s->drop_from >= 0 && s->foff > s->drop_from)
+            (void)posix_fadvise(s->ffd, s->drop_from, s->foff - s->drop_from, POSIX_FADV_DONTNEED);
+        close(s->ffd);
+    }
+    if (s->kind == SEG_REF && s->release) s->release(s->owner);
+}
+
+// Tira o primeiro segmento da fila.
+static void seg_pop(Conn *c) {
+    Seg *s = c->out_head;
+    c->out_head = s->next;
+    if (!c->out_head) c->out_tail = NULL;
+    seg_free(s);
+}
+
+// Garante ao menos `need` bytes livres no último segmento de memória.
+static Seg *seg_mem_reserve(Conn *c, size_t need) {
+    Seg *s = c->out_tail;
+    if (!s || s->kind != SEG_MEM) {
+        s = seg_push(c, SEG_MEM);
+        if (!s) return NULL;
+    }
+    if (s->len + need > s->cap) {
+        size_t novo = s->cap ? s->cap * 2 : SEG_MIN_CAP;
+        while (novo < s->len + need) novo *= 2;
+        char *tmp = (char *)arena_grow(&c->arena, s->data, s->len, novo);
+        if (!tmp) return NULL;
+        s->data = tmp; s->cap = novo;
+    }
+    return s;
+}
+
+// -----------------------------------------------------------------------------
+// Ciclo de vida
+// -----------------------------------------------------------------------------
+
+// Pool de conexões do worker (cada conexão nasce e morre na mesma thread).
+static __thread Pool g_conn_pool = POOL_INIT(Conn, 8);
+
+Conn *conn_new(int fd) {
+    Conn *c = (Conn *)pool_get(&g_conn_pool);
+    if (!c) return NULL;
+    c->fd = fd;
+    c->state = CONN_READING;
+    c->pipe_fd[0] = c->pipe_fd[1] = -1;
+    req_reset(&c->rq);
+    stats_conn_opened();
+    return c;
+}
+
+static void producer_end(Conn *c) {
+    if (c->produce_free) c->produce_free(c->produce_ctx);
+    c->produce = NULL;
+    c->produce_free = NULL;
+    c->produce_ctx = NULL;
+}
+
+void conn_free(Conn *c) {
+    if (!c) return;
+    producer_end(c);
+    Seg *s = c->out_head;
+    while (s) { Seg *n = s->next; seg_free(s); s = n; }
+    if (c->pipe_fd[0] >= 0) { close(c->pipe_fd[0]); close(c->pipe_fd[1]); }
+    if (c->fd >= 0) close(c->fd);
+    if (c->io_free) c->io_free(c->io);
+    arena_free(&c->arena);
+    pool_put(&g_conn_pool, c);
+    stats_conn_closed();
+}
+
+// -----------------------------------------------------------------------------
+// Enfileiramento
+// -----------------------------------------------------------------------------
+
+void conn_out_write(Conn *c, const void *data, size_t len) {
+    if (len == 0) return;
+    Seg *s = seg_mem_reserve(c, len);
+    if (!s) { c->state = CONN_CLOSING; return; }
+    memcpy(s->data + s->len, data, len);
+    s->len += len;
+}
+
+void conn_out_printf(Conn *c, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n <= 0) return;
+
+    Seg *s = seg_mem_reserve(c, (size_t)n + 1);
+    if (!s) { c->state = CONN_CLOSING; return; }
+    va_start(ap, fmt);
+    vsnprintf(s->data + s->len, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    s->len += (size_t)n;
+}
+
+// Envia `data` sem copiar; `release(owner)` é chamado quando terminar (ou
+// se a conexão cair antes). Sem `release`, `data` precisa viver até a fila
+// esvaziar (memória de conn_scratch).
+void conn_out_ref(Conn *c, const void *data, size_t len, void (*release)(void *), void *owner) {
+    Seg *s = seg_push(c, SEG_REF);
+    if (!s) {
+        if (release) release(owner);
+        c->state = CONN_CLOSING;
+        return;
+    }
+    s->data = (char *)data;
+    s->len = len;
+    s->release = release;
+    s->owner = owner;
+}
+
+// Assume a posse de `ffd`: ele é fechado quando o trecho terminar de ser enviado.
+void conn_out_file(Conn *c, int ffd, off_t off, off_t len) {
+    Seg *s = seg_push(c, SEG_FILE);
+    if (!s) { close(ffd); c->state = CONN_CLOSING; return; }
+    s->ffd  = ffd;
+    s->foff = off;
+    s->fend = off + len;
+    // Trechos que cabem no readahead padrão dispensam as dicas (e a syscall)
+    if ((size_t)len > g_readahead && len > HINT_MIN) {
+        (void)posix_fadvise(ffd, off, len, POSIX_FADV_SEQUENTIAL);
+        s->ra_end = off;
+        if (g_drop_behind > 0 && len >= g_drop_behind) s->drop_from = off;
+    }
+}
+
+void *conn_scratch(Conn *c, size_t n) {
+    return arena_alloc(&c->arena, n);
+}
+
+bool conn_out_pending(const Conn *c) {
+    return c->out_head != NULL || c->produce != NULL;
+}
+
+ConnMark conn_out_mark(const Conn *c) {
+    ConnMark m = { c->out_tail, c->out_tail ? c->out_tail->len : 0 };
+    return m;
+}
+
+size_t conn_out_size(const Conn *c, ConnMark m) {
+    const Seg *s = m.tail ? m.tail : c->out_head;
+    size_t n = 0;
+    for (; s; s = s->next) {
+        if (s->kind == SEG_FILE) n += (size_t)(s->fend - s->foff);
+        else                     n += s->len - (s == m.tail ? m.len : s->off);
+    }
+    return n;
+}
+
+// A linha de status é sempre copiada (conn_out_write/printf), então está num
+// segmento de memória: o final do antigo último ou o primeiro depois dele.
+int conn_out_status(const Conn *c, ConnMark m) {
+    const Seg *s = c->out_head;
+    size_t off = 0;
+    if (m.tail) {
+        s = m.tail;
+        off = m.len;
+        if (off == s->len) { s = s->next; off = 0; }
+    }
+    if (!s || s->kind != SEG_MEM || s->len - off < 12) return 0;
+    const char *p = s->data + off;
+    if (memcmp(p, "HTTP/1.", 7) != 0 || p[8] != ' ') return 0;
+    int code = 0;
+    for (int i = 9; i < 12; i++) {
+        if (p[i] < '0' || p[i] > '9') return 0;
+        code = code * 10 + (p[i] - '0');
+    }
+    return code;
+}
+
+void conn_set_producer(Conn *c, ConnProduceFn fn, void (*free_ctx)(void *), void *ctx) {
+    producer_end(c);
+    c->produce = fn;
+    c->produce_free = free_ctx;
+    c->produce_ctx = ctx;
+}
+
+bool conn_streaming(const Conn *c) {
+    return c->produce != NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Envio
+// -----------------------------------------------------------------------------
+
+// Resultado comum para erros de envio: EAGAIN = esperar EPOLLOUT, resto = falha.
+static int send_errno(void) {
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+}
+
+// TCP_CORK segura segmentos incompletos até ser desligado (ou 200 ms).
+static void set_cork(Conn *c, bool on) {
+    int v = on;
+    if (setsockopt(c->fd, IPPROTO_TCP, TCP_CORK, &v, sizeof(v)) == 0) c->corked = on;
+}
+
+static bool zc_unsupported(void) {
+    return errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP;
+}
+
+// sendfile(2): o kernel copia do page cache direto para o socket. O offset
+// é atualizado pelo próprio kernel com o que foi aceito.
+static int flush_sendfile(Conn *c, Seg *s) {
+    while (s->foff < s->fend) {
+        off_t left = s->fend - s->foff;
+        size_t want = left > ZC_CHUNK ? ZC_CHUNK : (size_t)left;
+        ssize_t w = sendfile(c->fd, s->ffd, &s->foff, want);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (zc_unsupported()) { s->fmode = FMODE_SPLICE; return 2; }
+            return send_errno();
+        }
+        if (w == 0) return -1;   // arquivo encolheu
+        c->bytes_out += (size_t)w;
+        stats_count_bytes((size_t)w);
+        conn_file_advise(s);
+    }
+    return 1;
+}
+
+bool conn_pipe(Conn *c) {
+    return c->pipe_fd[0] >= 0 || pipe2(c->pipe_fd, O_NONBLOCK | O_CLOEXEC) == 0;
+}
+
+// splice(2): arquivo -> pipe -> socket, sem passar pelo espaço de usuário.
+// Bytes que já estão no pipe (c->pipe_len) saem antes de puxar mais arquivo.
+static int flush_splice(Conn *c, Seg *s) {
+    if (!conn_pipe(c)) {
+        s->fmode = FMODE_COPY;
+        return 2;
+    }
+    while (s->foff < s->fend || c->pipe_len > 0) {
+        if (c->pipe_len == 0) {
+            off_t left = s->fend - s->foff;
+            size_t want = left > ZC_CHUNK ? ZC_CHUNK : (size_t)left;
+            ssize_t r = splice(s->ffd, &s->foff, c->pipe_fd[1], NULL, want, SPLICE_F_MOVE);
+            if (r < 0) {
+                if (errno == EINTR) continue;
+                if (zc_unsupported()) { s->fmode = FMODE_COPY; return 2; }
+                return -1;
+            }
+            if (r == 0) return -1;
+            c->pipe_len = (size_t)r;
+            conn_file_advise(s);
+        }
+        unsigned more = (s->foff < s->fend || s->next) ? SPLICE_F_MORE : 0;
+        ssize_t w = splice(c->pipe_fd[0], NULL, c->fd, NULL, c->pipe_len,
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK | more);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return send_errno();
+        }
+        c->pipe_len -= (size_t)w;
+        c->bytes_out += (size_t)w;
+        stats_count_bytes((size_t)w);
+    }
+    return 1;
+}
+
+// Envia um trecho de arquivo com pread()/send(); o offset só avança pelo que
+// o socket realmente aceitou, então um envio parcial é retomado do ponto exato.
+static int flush_copy(Conn *c, Seg *s) {
+    char buf[FILE_CHUNK];
+    while (s->foff < s->fend) {
+        size_t want = sizeof(buf);
+        if ((off_t)want > s->fend - s->foff) want = (size_t)(s->fend - s->foff);
+        ssize_t n = pread(s->ffd, buf, want, s->foff);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;   // arquivo encolheu ou erro de leitura
+
+        int more = (s->foff + n < s->fend || s->next) ? MSG_MORE : 0;
+        ssize_t w = send(c->fd, buf, (size_t)n, MSG_NOSIGNAL | more);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return send_errno();
+        }
+        s->foff += w;
+        c->bytes_out += (size_t)w;
+        stats_count_bytes((size_t)w);
+        if (w < n) return 0;     // socket cheio: retoma quando houver EPOLLOUT
+        conn_file_advise(s);
+    }
+    return 1;
+}
+
+// mmap: send() direto de uma janela do arquivo mapeada com MADV_HUGEPAGE (em
+// sistemas de arquivos com folios grandes o page cache entra em páginas de
+// 2 MB e o mapeamento também). Se o arquivo encolher, send() devolve EFAULT
+// em vez de SIGBUS, e a conexão cai como nos outros caminhos.
+static int flush_mmap(Conn *c, Seg *s) {
+    while (s->foff < s->fend) {
+        if (!s->map || s->foff >= s->map_off + (off_t)s->map_len) {
+            if (s->map) { munmap(s->map, s->map_len); s->map = NULL; }
+            off_t base = s->foff & ~(off_t)(MAP_ALIGN - 1);
+            off_t left = s->fend - base;
+            size_t len = left > MAP_WINDOW ? MAP_WINDOW : (size_t)left;
+            void *p = mmap(NULL, len, PROT_READ, MAP_SHARED, s->ffd, base);
+            if (p == MAP_FAILED) {
+                if (errno == ENODEV || zc_unsupported()) { s->fmode = FMODE_COPY; return 2; }
+                return -1;
+            }
+            (void)madvise(p, len, MADV_HUGEPAGE);
+            (void)madvise(p, len, MADV_SEQUENTIAL);
+            s->map = (char *)p;
+            s->map_off = base;
+            s->map_len = len;
+        }
+        size_t want = (size_t)(s->map_off + (off_t)s->map_len - s->foff);
+        if (want > ZC_CHUNK) want = ZC_CHUNK;
+        int more = (s->foff + (off_t)want < s->fend || s->next) ? MSG_MORE : 0;
+        ssize_t w = send(c->fd, s->map + (s->foff - s->map_off), want, MSG_NOSIGNAL | more);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return send_errno();
+        }
+        s->foff += w;
+        c->bytes_out += (size_t)w;
+        stats_count_bytes((size_t)w);
+        if ((size_t)w < want) return 0;
+        conn_file_advise(s);
+    }
+    return 1;
+}
+
+void conn_file_advise(Seg *s) {
+    if (s->ra_end < 0) return;
+    // Próxima janela quando metade da anterior já saiu
+    if (g_readahead > 0 && s->ra_end < s->fend && s->ra_end - s->foff < (off_t)g_readahead / 2) {
+        off_t from = s->ra_end > s->foff ? s->ra_end : s->foff;
+        off_t to = s->foff + (off_t)g_readahead;
+        if (to > s->fend) to = s->fend;
+        (void)posix_fadvise(s->ffd, from, to - from, POSIX_FADV_WILLNEED);
+        s->ra_end = to;
+    }
+    // Atrás do envio, com folga para o que ainda está no buffer do socket;
+    // páginas mapeadas o kernel não solta, então só até a janela mmap atual
+    if (s->drop_from >= 0 && s->foff - s->drop_from >= 2 * DROP_LAG) {
+        off_t to = s->foff - DROP_LAG;
+        if (s->map && to > s->map_off) to = s->map_off;
+        if (to <= s->drop_from) return;
+        (void)posix_fadvise(s->ffd, s->drop_from, to - s->drop_from, POSIX_FADV_DONTNEED);
+        s->drop_from = to;
+    }
+}
+
+// Aponta iov para os segmentos de memória do início da fila (até `max`).
+// Devolve quantos e, em *stop, o primeiro segmento que ficou de fora.
+static int mem_iov(Conn *c, struct iovec *iov, int max, size_t *total, Seg **stop) {
+    int n = 0;
+    Seg *s = c->out_head;
+    *total = 0;
+    for (; s && s->kind != SEG_FILE && n < max; s = s->next) {
+        if (s->off == s->len) continue;
+        iov[n].iov_base = s->data + s->off;
+        iov[n].iov_len = s->len - s->off;
+        *total += iov[n].iov_len;
+        n++;
+    }
+    *stop = s;
+    return n;
+}
+
+void conn_out_advance(Conn *c, size_t n) {
+    c->bytes_out += n;
+    stats_count_bytes(n);
+    while (c->out_head && c->out_head->kind != SEG_FILE) {
+        Seg *s = c->out_head;
+        size_t left = s->len - s->off;
+        if (n < left) { s->off += n; return; }
+        n -= left;
+        seg_pop(c);
+    }
+}
+
+// Envia os segmentos de memória do início da fila (até IOV_BATCH) num único
+// sendmsg e descarta os que saíram inteiros. MSG_MORE quando algo vem depois.
+static int flush_mem(Conn *c) {
+    struct iovec iov[IOV_BATCH];
+    size_t total;
+    Seg *stop;
+    int n = mem_iov(c, iov, IOV_BATCH, &total, &stop);
+
+    size_t done = 0;
+    if (n > 0) {
+        struct msghdr mh = { .msg_iov = iov, .msg_iovlen = (size_t)n };
+        ssize_t w;
+        do {
+            w = sendmsg(c->fd, &mh, MSG_NOSIGNAL | (stop ? MSG_MORE : 0));
+        } while (w < 0 && errno == EINTR);
+        if (w < 0) return send_errno();
+        done = (size_t)w;
+    }
+    conn_out_advance(c, done);
+    return done == total ? 1 : 0;   // parcial: socket cheio
+}
+
+// Escolhe o caminho do segmento; 2 = o caminho rebaixou o modo, tentar de novo.
+static int flush_file(Conn *c, Seg *s) {
+    int r;
+    conn_file_advise(s);
+    do {
+        switch (s->fmode) {
+        case FMODE_SENDFILE: r = flush_sendfile(c, s); break;
+        case FMODE_SPLICE:   r = flush_splice(c, s);   break;
+        case FMODE_MMAP:     r = flush_mmap(c, s);     break;
+        default:             r = flush_copy(c, s);     break;
+        }
+    } while (r == 2);
+    return r;
+}
+
+int conn_flush(Conn *c) {
+    for (;;) {
+        while (c->out_head) {
+            Seg *s = c->out_head;
+            if (s->kind != SEG_FILE) {
+                int r = flush_mem(c);
+                if (r <= 0) return r;
+                continue;
+            }
+            // Mais de um trecho a seguir (multipart): junta tudo até o fim
+            if (s->next && !c->corked) set_cork(c, true);
+            int r = flush_file(c, s);
+            if (r <= 0) return r;
+            seg_pop(c);
+        }
+        if (c->corked) set_cork(c, false);
+        arena_reset(&c->arena);
+        if (!c->produce) return 1;
+
+        // Fila vazia: pede o próximo pedaço ao produtor
+        int r = c->produce(c, c->produce_ctx);
+        if (r <= 0) {
+            producer_end(c);
+            if (r < 0) return -1;
+        }
+    }
+}
+
+ConnOut conn_out_next(Conn *c, struct iovec *iov, int max, int *n, bool *more) {
+    for (;;) {
+        Seg *s = c->out_head;
+        if (!s) {
+            arena_reset(&c->arena);
+            if (!c->produce) return CONN_OUT_DONE;
+            int r = c->produce(c, c->produce_ctx);
+            if (r <= 0) {
+                producer_end(c);
+                if (r < 0) return CONN_OUT_ERROR;
+            }
+            continue;
+        }
+        if (s->kind != SEG_FILE) {
+            size_t total;
+            Seg *stop;
+            *n = mem_iov(c, iov, max, &total, &stop);
+            if (*n == 0) { conn_out_advance(c, 0); continue; }   // só segmentos vazios
+            *more = stop != NULL;
+            return CONN_OUT_MEM;
+        }
+        if (s->foff >= s->fend && c->pipe_len == 0) { seg_pop(c); continue; }
+        *more = s->next != NULL;
+        return CONN_OUT_FILE;
+    }
+}
\ No newline at end of file
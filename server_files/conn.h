@@ -0,0 +1,156 @@
+// server_files/conn.h
+// Estado por conexão: buffer de leitura, fase do parsing e fila de saída.
+#ifndef CONN_H
+#define CONN_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "arena.h"
+#include "request.h"
+#include "timer.h"
+
+#define CONN_RECV_BUF 8192   // tamanho máximo de um request (linha + cabeçalhos)
+
+// Um pedaço da resposta pendente: bytes em memória (próprios ou emprestados
+// de um dono com contagem de referências) ou trecho de arquivo.
+typedef enum { SEG_MEM, SEG_REF, SEG_FILE } SegKind;
+
+typedef struct Seg {
+    struct Seg *next;
+    SegKind kind;
+    char   *data;            // SEG_MEM/SEG_REF: bytes (SEG_MEM: na arena da conexão)
+    size_t  len, cap, off;   // SEG_MEM/SEG_REF: usado, capacidade, já enviado
+    void  (*release)(void *);// SEG_REF: solta a referência em `owner` (ou NULL)
+    void   *owner;
+    int     ffd;             // SEG_FILE: descritor (fechado ao consumir)
+    off_t   foff, fend;      // SEG_FILE: próximo byte a enviar e fim exclusivo
+    unsigned char fmode;     // SEG_FILE: sendfile, splice, mmap ou cópia (ver conn.c)
+    off_t   ra_end;          // SEG_FILE: fim do WILLNEED já pedido (-1 = sem dicas)
+    off_t   drop_from;       // SEG_FILE: início do que ainda não saiu do page cache (-1 = não descarta)
+    char   *map;             // SEG_FILE (mmap): janela mapeada do arquivo
+    off_t   map_off;         //   offset da janela no arquivo
+    size_t  map_len;
+} Seg;
+
+typedef enum {
+    CONN_READING,   // acumulando bytes até "\r\n\r\n" (ou ociosa entre requests)
+    CONN_WRITING,   // resposta montada, drenando a fila de saída
+    CONN_CLOSING    // fila drenada (ou erro): fechar
+} ConnState;
+
+struct Conn;
+
+// Produtor de corpo sob demanda (respostas geradas aos poucos, de tamanho
+// desconhecido): chamado por conn_flush() sempre que a fila esvazia. Enfileira
+// mais bytes e devolve 1 se ainda há o que produzir, 0 no fim, -1 em erro.
+typedef int (*ConnProduceFn)(struct Conn *c, void *ctx);
+
+typedef struct Conn {
+    int          fd;
+    ConnState    state;
+    char         in[CONN_RECV_BUF + 1];
+    size_t       in_len;
+    HttpRequest  rq;            // parser do request corrente (retomado a cada leitura)
+    const HttpRequest *req;     // request em atendimento (== &rq) ou NULL
+    Seg         *out_head, *out_tail;
+    int          pipe_fd[2];    // pipe para splice (criado sob demanda)
+    size_t       pipe_len;      // bytes já no pipe, ainda não enviados
+    bool         corked;        // TCP_CORK ligado (resposta com vários trechos de arquivo)
+    ConnProduceFn produce;      // produtor ativo (ou NULL)
+    void        (*produce_free)(void *);
+    void         *produce_ctx;
+    void         *io;           // estado do backend io_uring
+    void        (*io_free)(void *);   // libera `io` em conn_free
+    Arena         arena;        // rascunho da resposta em curso (ver conn.c)
+
+    // Métricas (--stats): ns no parser do request corrente e instante em que
+    // a fila de saída deixou de estar vazia (0 = vazia)
+    uint64_t     parse_ns;
+    uint64_t     queued_at;
+    char         peer[48];      // endereço do cliente (só com --access-log)
+
+    // Keep-alive
+    bool         keep_alive;    // resposta atual mantém a conexão aberta
+    bool         peer_closed;   // cliente já encerrou o lado de escrita
+    bool         want_out;      // registrada no epoll para EPOLLOUT
+    unsigned     requests;      // requests já atendidos nesta conexão
+
+    // Prazos (ver http.c): cabeçalho, ociosidade ou ritmo de envio
+    Timer        timer;         // na roda do worker
+    unsigned char deadline;     // qual prazo está armado
+    uint64_t     bytes_out;     // bytes já entregues ao socket
+    uint64_t     bytes_mark;    // bytes_out no início da janela de envio
+} Conn;
+
+// Liga/desliga sendfile/splice para arquivos (desligado = pread/send).
+void  conn_set_zero_copy(bool on);
+// Envia arquivos com send() a partir de janelas mmap com MADV_HUGEPAGE.
+void  conn_set_mmap(bool on);
+// Dicas de page cache para trechos de arquivo: WILLNEED de `readahead` bytes
+// à frente do envio (0 = só SEQUENTIAL) e DONTNEED atrás dele nos trechos de
+// pelo menos `drop_behind` bytes (0 = nunca).
+void  conn_set_file_hints(size_t readahead, off_t drop_behind);
+
+Conn *conn_new(int fd);
+void  conn_free(Conn *c);
+
+// Fila de saída (nada é enviado aqui; quem envia é conn_flush).
+void conn_out_write(Conn *c, const void *data, size_t len);
+void conn_out_printf(Conn *c, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+void conn_out_ref(Conn *c, const void *data, size_t len, void (*release)(void *), void *owner);
+// Memória de rascunho da conexão, válida até a fila de saída esvaziar: o
+// caminho do request, corpos montados na hora (enviados com conn_out_ref sem
+// `release`). NULL se faltar memória.
+void *conn_scratch(Conn *c, size_t n);
+void conn_out_file(Conn *c, int ffd, off_t off, off_t len);
+bool conn_out_pending(const Conn *c);
+
+// Posição do fim da fila; depois de enfileirar uma resposta, conn_out_status
+// lê o código da linha de status que começa ali (0 se não houver).
+typedef struct {
+    Seg   *tail;
+    size_t len;
+} ConnMark;
+
+ConnMark conn_out_mark(const Conn *c);
+int      conn_out_status(const Conn *c, ConnMark m);
+// Bytes enfileirados depois da marca (produtores ainda não chamados ficam de fora).
+size_t   conn_out_size(const Conn *c, ConnMark m);
+
+// Instala um produtor para o restante da resposta; `free_ctx` é chamado ao
+// fim (ou ao fechar a conexão). Enquanto ele estiver ativo, nenhum request
+// seguinte do pipeline é atendido (conn_streaming).
+void conn_set_producer(Conn *c, ConnProduceFn fn, void (*free_ctx)(void *), void *ctx);
+bool conn_streaming(const Conn *c);
+
+// Envia o que der sem bloquear: 1 = resposta inteira enviada, 0 = socket
+// cheio, -1 = erro.
+int conn_flush(Conn *c);
+
+// -----------------------------------------------------------------------------
+// Envio assíncrono (backend io_uring): em vez de conn_flush, o backend pede
+// o próximo passo, submete a operação e informa o resultado.
+// -----------------------------------------------------------------------------
+typedef enum {
+    CONN_OUT_DONE,    // fila vazia e sem produtor: resposta inteira enviada
+    CONN_OUT_MEM,     // iov[0..*n) com segmentos de memória do início da fila
+    CONN_OUT_FILE,    // c->out_head é um trecho de arquivo (ver c->pipe_len)
+    CONN_OUT_ERROR
+} ConnOut;
+
+// `*more`: há algo depois deste passo (para MSG_MORE/SPLICE_F_MORE).
+ConnOut conn_out_next(Conn *c, struct iovec *iov, int max, int *n, bool *more);
+
+// Descarta `n` bytes já enviados dos segmentos de memória do início.
+void conn_out_advance(Conn *c, size_t n);
+
+// Pipe da conexão para splice (criado sob demanda); false se não der.
+bool conn_pipe(Conn *c);
+
+// Renova as dicas de page cache do trecho de arquivo `s` (antes de cada envio).
+void conn_file_advise(Seg *s);
+
+#endif
\ No newline at end of file
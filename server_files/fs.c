@@ -1,251 +1,876 @@
 // Responsável por mapear URL -> caminho no disco e responder:
-// - arquivo regular  -> envia arquivo (com Content-Type básico)
+// - arquivo regular  -> envia arquivo (com Content-Type básico), inteiro ou
+//                       por faixas (Range), ou 304 se o cliente já o tem
 // - diretório        -> tenta <dir>/index.html; senão, lista conteúdo
 // - inexistente/outro-> 404 simples
-
+//
+// A raiz é aberta uma vez (fs_init) e todo caminho de request é aberto
+// relativo a ela com openat2(RESOLVE_BENEATH | RESOLVE_NO_MAGICLINKS): o
+// kernel recusa qualquer resolução que saia da raiz, inclusive por links
+// simbólicos. Em kernels sem openat2 (< 5.6), o caminho é percorrido
+// componente a componente com O_NOFOLLOW. O descritor aberto e um único
+// fstat valem para todas as decisões do request.
+//
+// Com --bundle, a mesma decisão é tomada sobre o pacote mapeado (bundle.h):
+// arquivo, index.html do diretório ou listagem, sem nenhuma chamada de
+// sistema além do envio.
+
+#define _GNU_SOURCE
 #include "fs.h"
+#include "bundle.h"
+#include "cache.h"
+#include "gzip.h"
+#include "listing.h"
 #include "util.h"
 
-#include <dirent.h>         
+#include <errno.h>
 #include <fcntl.h>          
 #include <limits.h>         
+#include <linux/openat2.h>
 #include <stdbool.h>        
 #include <stdio.h>          
 #include <stdlib.h>         
 #include <string.h>         
 #include <strings.h>        
 #include <sys/socket.h>     
+#include <sys/random.h>
 #include <sys/stat.h>       
+#include <sys/syscall.h>
+#include <time.h>
 #include <unistd.h>         
 
+#define CACHE_COPY_MAX (16 * 1024)         // corpos até aqui são copiados na fila
+#define COMPRESS_MIN   256                // abaixo disso gzip não compensa
+#define COMPRESS_MAX   (4 * 1024 * 1024)  // maior arquivo comprimido na hora
+
+// Flags de abertura dos alvos: O_NONBLOCK para um FIFO sob a raiz não travar
+// o worker (arquivos regulares ignoram a flag).
+#define OPEN_FLAGS (O_RDONLY | O_NONBLOCK | O_CLOEXEC)
+
+static int    g_root_fd = -1;   // raiz aberta com O_PATH
+static size_t g_root_len;       // comprimento da raiz nos caminhos montados
+static bool   g_openat2;        // o kernel tem openat2
+
 // -----------------------------------------------------------------------------
-// Helpers
+// Resolução sob a raiz
 // -----------------------------------------------------------------------------
 
-// Acrescenta texto em um buffer crescendo com realloc (retorna false em OOM).
-static bool buf_append(char **pbuf, size_t *cap, size_t *len, const char *src) {
-    size_t need = strlen(src);
-    if (*len + need + 1 > *cap) {
-        size_t novo = (*cap ? *cap * 2 : 4096);
-        while (novo < *len + need + 1) novo *= 2;
-        char *tmp = (char *)realloc(*pbuf, novo);
-        if (!tmp) return false;
-        *pbuf = tmp; *cap = novo;
-    }
-    memcpy(*pbuf + *len, src, need + 1);
-    *len += need;
+// Raiz sem barra final ("/" vira ""), como fs_join_and_sanitize a usa.
+static size_t root_len(const char *root) {
+    size_t n = strlen(root);
+    while (n > 0 && root[n - 1] == '/') n--;
+    return n;
+}
+
+static long sys_openat2(int dfd, const char *path, int flags) {
+    struct open_how how = {
+        .flags   = (uint64_t)flags,
+        .resolve = RESOLVE_BENEATH | RESOLVE_NO_MAGICLINKS,
+    };
+    return syscall(SYS_openat2, dfd, path, &how, sizeof(how));
+}
+
+bool fs_init(const char *root) {
+    g_root_fd = open(root, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (g_root_fd < 0) return false;
+    g_root_len = root_len(root);
+
+    long fd = sys_openat2(g_root_fd, ".", O_PATH | O_CLOEXEC);
+    g_openat2 = fd >= 0 || errno != ENOSYS;
+    if (fd >= 0) close((int)fd);
     return true;
 }
 
-// JSON-escape simples para nomes (aspas e barra invertida).
-static void json_escape_into(char *dst, const char *src) {
-    // Assume que dst tem espaço suficiente (chamaremos com sobra).
-    while (*src) {
-        unsigned char c = (unsigned char)*src++;
-        if (c == '\\' || c == '\"') { *dst++ = '\\'; *dst++ = (char)c; }
-        else { *dst++ = (char)c; }
+bool fs_has_openat2(void) {
+    return g_openat2;
+}
+
+// Sem openat2: um openat por componente, todos com O_NOFOLLOW. Nenhum link
+// simbólico é seguido (mais restrito que RESOLVE_BENEATH, mas igualmente
+// seguro); ".." já foi recusado em fs_join_and_sanitize.
+static int open_walk(const char *rel, int flags) {
+    char comp[NAME_MAX + 1];
+    int dfd = g_root_fd;
+    for (;;) {
+        const char *slash = strchrnul(rel, '/');
+        size_t len = (size_t)(slash - rel);
+        int fd = -1;
+        if (len <= NAME_MAX) {
+            memcpy(comp, rel, len);
+            comp[len] = '\0';
+            int f = *slash ? (O_PATH | O_DIRECTORY | O_CLOEXEC) : flags;
+            fd = openat(dfd, comp, f | O_NOFOLLOW);
+        } else {
+            errno = ENAMETOOLONG;
+        }
+        if (dfd != g_root_fd) close(dfd);
+        if (fd < 0 || !*slash) return fd;
+        dfd = fd;
+        rel = slash + 1;
     }
-    *dst = '\0';
+}
+
+// Abre um caminho montado por fs_join_and_sanitize (raiz + "/" + relativo)
+// sem deixar a resolução escapar da raiz. -1 (errno) se não existe ou escapa.
+static int open_beneath(const char *fs_path, int flags) {
+    const char *rel = fs_path + g_root_len;
+    while (*rel == '/') rel++;
+    if (!*rel) rel = ".";
+    if (!g_openat2) return open_walk(rel, flags);
+    long fd;
+    do {
+        fd = sys_openat2(g_root_fd, rel, flags);
+    } while (fd < 0 && errno == EINTR);
+    return (int)fd;
+}
+
+// Abre e confere que é arquivo regular; -1 caso contrário.
+static int open_regular(const char *fs_path, struct stat *st) {
+    int f = open_beneath(fs_path, OPEN_FLAGS);
+    if (f < 0) return -1;
+    if (fstat(f, st) < 0 || !S_ISREG(st->st_mode)) { close(f); return -1; }
+    return f;
 }
 
 // -----------------------------------------------------------------------------
-// Listagem HTML (fallback quando não existe index.html).
+// Helpers
 // -----------------------------------------------------------------------------
-static void send_dir_listing(int fd, const char *url_path, const char *fs_dir) {
-    DIR *d = opendir(fs_dir);
-    if (!d) { util_send_404(fd); return; }
 
-    size_t cap = 4096, len = 0;
-    char *body = (char *)malloc(cap);
-    if (!body) { closedir(d); return; }
+// Envia um corpo de listagem pronto. Corpos pequenos são copiados; os
+// grandes vão por referência até o envio terminar.
+static void send_listing(Conn *c, const char *ctype, ListingBody *b) {
+    conn_out_printf(c,
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: %s\r\n"
+        "Content-Length: %zu\r\n"
+        "%s"
+        "Vary: Accept-Encoding\r\n",
+        ctype, b->len, b->gzip ? "Content-Encoding: gzip\r\n" : "");
+    util_end_headers(c);
+    if (b->len <= CACHE_COPY_MAX) {
+        conn_out_write(c, b->data, b->len);
+        listing_release(b);
+    } else {
+        conn_out_ref(c, b->data, b->len, listing_release, b);
+    }
+}
 
-    len += snprintf(body + len, cap - len,
-        "<!doctype html><meta charset='utf-8'>"
-        "<title>Index of %s</title><h1>Index of %s</h1><ul>",
-        url_path, url_path);
+// -----------------------------------------------------------------------------
+// Corpo de um arquivo: vem do cache (memória) ou de um descritor aberto.
+// -----------------------------------------------------------------------------
 
-    struct dirent *ent;
-    while ((ent = readdir(d)) != NULL) {
-        // oculta ".", ".." e "index.html"
-        if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, "..")) continue;
-        if (!strcasecmp(ent->d_name, "index.html")) continue;
+typedef struct {
+    CacheEntry *e;    // != NULL: corpo em e->data + e->hdr_len
+    const char *mem;  // != NULL: corpo no pacote mapeado (vive até o fim)
+    int         fd;   // senão: arquivo aberto (fechado pelo chamador)
+} BodySrc;
+
+// Enfileira [off, off+len) do corpo. Trechos pequenos do cache são copiados
+// (saem no mesmo send dos cabeçalhos); os grandes vão por referência, sem
+// cópia, e a entrada fica viva até o envio terminar. Do disco, cada trecho
+// ganha seu próprio descritor para seguir pelo caminho zero-copy.
+static void emit_body(Conn *c, const BodySrc *src, off_t off, off_t len) {
+    if (len <= 0) return;
+    if (src->e) {
+        const char *body = src->e->data + src->e->hdr_len;
+        if (len <= CACHE_COPY_MAX) {
+            conn_out_write(c, body + off, (size_t)len);
+        } else {
+            cache_retain(src->e);
+            conn_out_ref(c, body + off, (size_t)len, cache_release, src->e);
+        }
+        return;
+    }
+    if (src->mem) {
+        if (len <= CACHE_COPY_MAX) conn_out_write(c, src->mem + off, (size_t)len);
+        else                       conn_out_ref(c, src->mem + off, (size_t)len, NULL, NULL);
+        return;
+    }
+    int f = dup(src->fd);
+    if (f < 0) { c->state = CONN_CLOSING; return; }
+    conn_out_file(c, f, off, len);
+}
 
-        char item[PATH_MAX];
-        snprintf(item, sizeof(item), "%s/%s",
-                 (*url_path ? url_path : ""), ent->d_name);
+// Cabeçalhos de uma representação negociada; "" para a identidade sem Vary.
+static int format_encoding(char *buf, size_t cap, const char *encoding, bool vary) {
+    int n = snprintf(buf, cap, "%s%s%s%s",
+                     encoding ? "Content-Encoding: " : "", encoding ? encoding : "",
+                     encoding ? "\r\n" : "", vary ? "Vary: Accept-Encoding\r\n" : "");
+    return (n < 0 || (size_t)n >= cap) ? -1 : n;
+}
 
-        // reserva espaço (64 de folga p/ tags)
-        size_t need = strlen(ent->d_name) + strlen(item) + 64;
-        if (len + need >= cap) {
-            size_t novo = cap * 2;
-            if (novo < len + need + 1024) novo = len + need + 1024;
-            char *tmp = (char *)realloc(body, novo);
-            if (!tmp) { free(body); closedir(d); return; }
-            body = tmp; cap = novo;
-        }
+// Sufixo da fronteira do multipart. Ela não pode aparecer no conteúdo das
+// partes (RFC 2046 §5.1.1), e o conteúdo é um arquivo qualquer: em vez de um
+// contador visível, 64 bits de splitmix64 sobre uma semente sorteada uma vez
+// por thread (getrandom) mais o contador.
+static uint64_t boundary_next(void) {
+    static __thread uint64_t seed, seq;
+    if (!seed && getrandom(&seed, sizeof(seed), 0) != (ssize_t)sizeof(seed)) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        seed = ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec ^ (uint64_t)(uintptr_t)&seq;
+    }
+    uint64_t z = seed + ++seq * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
 
-        len += snprintf(body + len, cap - len,
-                        "<li><a href=\"/%s\">%s</a></li>", item, ent->d_name);
+// 206 com uma faixa ou multipart/byteranges com várias (RFC 9110 §14.6).
+// As faixas são da representação escolhida (`encoding`, NULL = identidade):
+// com uma só, o Content-Encoding vai na resposta; no multipart, vai em cada
+// parte, já que o corpo multipart em si não está codificado.
+static void send_ranges(Conn *c, const BodySrc *src, const char *ctype, off_t size,
+                        const Validators *val, const char *encoding, bool vary,
+                        const ByteRange *r, int n) {
+    char hdr[512];
+    int vl = util_format_file_headers(hdr, sizeof(hdr), val);
+    if (vl < 0) { c->state = CONN_CLOSING; return; }
+
+    if (n == 1) {
+        off_t len = r[0].last - r[0].first + 1;
+        int el = format_encoding(hdr + vl, sizeof(hdr) - (size_t)vl, encoding, vary);
+        if (el < 0) { c->state = CONN_CLOSING; return; }
+        conn_out_printf(c,
+            "HTTP/1.1 206 Partial Content\r\n"
+            "Content-Type: %s\r\n"
+            "Content-Length: %lld\r\n"
+            "Content-Range: bytes %lld-%lld/%lld\r\n",
+            ctype, (long long)len, (long long)r[0].first, (long long)r[0].last, (long long)size);
+        conn_out_write(c, hdr, (size_t)(vl + el));
+        util_end_headers(c);
+        emit_body(c, src, r[0].first, len);
+        return;
     }
-    closedir(d);
 
-    if (len + 6 >= cap) {
-        char *tmp = (char *)realloc(body, cap + 16);
-        if (!tmp) { free(body); return; }
-        body = tmp; cap += 16;
+    // Fronteira única por resposta; o tamanho total precisa ser conhecido
+    // antes, então os cabeçalhos de cada parte são formatados duas vezes.
+    char boundary[40];
+    snprintf(boundary, sizeof(boundary), "httptoolsc%016llx",
+             (unsigned long long)boundary_next());
+
+    char part[512];
+    off_t total = 0;
+    for (int i = 0; i < n; i++) {
+        int pl = snprintf(part, sizeof(part),
+            "\r\n--%s\r\nContent-Type: %s\r\n%s%s%sContent-Range: bytes %lld-%lld/%lld\r\n\r\n",
+            boundary, ctype, encoding ? "Content-Encoding: " : "", encoding ? encoding : "",
+            encoding ? "\r\n" : "", (long long)r[i].first, (long long)r[i].last, (long long)size);
+        total += pl + (r[i].last - r[i].first + 1);
+    }
+    total += (off_t)strlen(boundary) + 8;   // "\r\n--" B "--\r\n"
+
+    conn_out_printf(c,
+        "HTTP/1.1 206 Partial Content\r\n"
+        "Content-Type: multipart/byteranges; boundary=%s\r\n"
+        "Content-Length: %lld\r\n"
+        "%s",
+        boundary, (long long)total, vary ? "Vary: Accept-Encoding\r\n" : "");
+    conn_out_write(c, hdr, (size_t)vl);
+    util_end_headers(c);
+
+    for (int i = 0; i < n; i++) {
+        conn_out_printf(c,
+            "\r\n--%s\r\nContent-Type: %s\r\n%s%s%sContent-Range: bytes %lld-%lld/%lld\r\n\r\n",
+            boundary, ctype, encoding ? "Content-Encoding: " : "", encoding ? encoding : "",
+            encoding ? "\r\n" : "", (long long)r[i].first, (long long)r[i].last, (long long)size);
+        emit_body(c, src, r[i].first, r[i].last - r[i].first + 1);
     }
-    len += snprintf(body + len, cap - len, "</ul>");
+    conn_out_printf(c, "\r\n--%s--\r\n", boundary);
+}
 
-    util_send_headers(fd, "200 OK", "text/html; charset=utf-8", (long)len);
-    (void)send(fd, body, len, 0);
-    free(body);
+// 416: nenhuma faixa cabe no arquivo; informa o tamanho atual.
+static void send_416(Conn *c, off_t size) {
+    conn_out_printf(c,
+        "HTTP/1.1 416 Range Not Satisfiable\r\n"
+        "Content-Range: bytes */%lld\r\n"
+        "Content-Length: 0\r\n",
+        (long long)size);
+    util_end_headers(c);
+}
+
+// Decide entre 304, 206/416 e 200 para um arquivo (do cache ou do disco).
+// `hdr200` são os cabeçalhos já prontos da resposta completa (sem Connection);
+// `encoding` e `vary` descrevem a representação, para as demais respostas.
+static void respond_file(Conn *c, const BodySrc *src, const char *ctype, off_t size,
+                         const Validators *val, const char *encoding, bool vary,
+                         const char *hdr200, size_t hdr200_len) {
+    if (util_not_modified(c->req, val)) {
+        util_send_304(c, val, vary);
+        return;
+    }
+
+    ByteRange r[RANGES_MAX];
+    int n = util_parse_ranges(c->req, size, val, r, RANGES_MAX);
+    if (n < 0) { send_416(c, size); return; }
+    if (n > 0) { send_ranges(c, src, ctype, size, val, encoding, vary, r, n); return; }
+
+    conn_out_write(c, hdr200, hdr200_len);
+    util_end_headers(c);
+    emit_body(c, src, 0, size);
+}
+
+// Resposta a partir de uma entrada do cache (consome a referência recebida).
+static void send_cached(Conn *c, CacheEntry *e) {
+    BodySrc src = { .e = e, .mem = NULL, .fd = -1 };
+    respond_file(c, &src, e->ctype, (off_t)e->body_len, &e->val, e->encoding, e->vary,
+                 e->data, e->hdr_len);
+    cache_release(e);
+}
+
+// Cabeçalhos da resposta 200 de um arquivo (sem Connection). `encoding` é o
+// Content-Encoding da representação (NULL = identidade) e `vary` indica que
+// a resposta depende de Accept-Encoding.
+static int format_file_200(char *buf, size_t cap, const char *ctype, off_t size,
+                           const Validators *val, const char *encoding, bool vary) {
+    int hl = util_format_headers(buf, cap, "200 OK", ctype, (long)size);
+    if (hl < 0) return -1;
+    int el = format_encoding(buf + hl, cap - (size_t)hl, encoding, vary);
+    if (el < 0) return -1;
+    hl += el;
+    int vl = util_format_file_headers(buf + hl, cap - (size_t)hl, val);
+    return (vl < 0) ? -1 : hl + vl;
+}
+
+// Lê `size` bytes do descritor a partir do início para `dst`.
+static bool read_all(int f, char *dst, size_t size) {
+    size_t got = 0;
+    while (got < size) {
+        ssize_t n = pread(f, dst + got, size - got, (off_t)got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;   // arquivo mudou de tamanho
+        got += (size_t)n;
+    }
+    return true;
+}
+
+// Monta uma entrada (cabeçalhos + corpo) e a entrega ao cache sob `key`.
+// `body` é copiado; com o cache desligado a entrada serve só este request.
+static CacheEntry *make_entry(const char *key, const char *hdr, size_t hl,
+                              const char *body, size_t body_len, const char *ctype,
+                              const Validators *val, const char *encoding, bool vary,
+                              uint64_t epoch) {
+    char *data = cache_alloc(hl + body_len);
+    if (!data) return NULL;
+    memcpy(data, hdr, hl);
+    memcpy(data + hl, body, body_len);
+    CacheEntry *e = cache_insert(key, data, hl, body_len, epoch);
+    if (e) { e->val = *val; e->ctype = ctype; e->encoding = encoding; e->vary = vary; }
+    return e;
+}
+
+// Lê o arquivo inteiro para uma entrada nova (cabeçalhos + corpo).
+static CacheEntry *load_into_cache(const char *key, int f, off_t size, const char *ctype,
+                                   const Validators *val, const char *encoding, bool vary,
+                                   uint64_t epoch) {
+    char hdr[512];
+    int hl = format_file_200(hdr, sizeof(hdr), ctype, size, val, encoding, vary);
+    if (hl < 0) return NULL;
+
+    size_t body_len = (size_t)size;
+    char *data = cache_alloc((size_t)hl + body_len);
+    if (!data) return NULL;
+    memcpy(data, hdr, (size_t)hl);
+    if (!read_all(f, data + hl, body_len)) { cache_free_data(data, (size_t)hl + body_len); return NULL; }
+
+    CacheEntry *e = cache_insert(key, data, (size_t)hl, body_len, epoch);
+    if (e) { e->val = *val; e->ctype = ctype; e->encoding = encoding; e->vary = vary; }
+    return e;
+}
+
+// a é anterior a b (segundos, depois nanossegundos).
+static bool mtime_before(const struct timespec *a, const struct timespec *b) {
+    return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
 }
 
 // -----------------------------------------------------------------------------
-// Envia arquivo usando loop read()/send() (simples e portátil).
+// Representação comprimida de um arquivo para um cliente com Accept-Encoding
+// `enc`, em ordem de preferência:
+//   1) irmão pré-comprimido "<arquivo>.br" / "<arquivo>.gz", se não for mais
+//      antigo que o original;
+//   2) gzip feito aqui, se o cliente aceita gzip;
+//   3) o próprio arquivo (com Vary), para não refazer essa busca a cada hit.
+// O resultado fica no cache sob "<arquivo>//enc<N>" (ver cache.h). Retorna
+// false quando nada disso se aplica (arquivo grande sem irmão): o chamador
+// envia a identidade do disco.
 // -----------------------------------------------------------------------------
-static void send_file(int fd, const char *fs_path) {
-    int f = open(fs_path, O_RDONLY);
-    if (f < 0) { util_send_404(fd); return; }
+static bool send_encoded(Conn *c, const char *fs_path, int f, const struct stat *st,
+                         const char *ctype, const Validators *val, unsigned enc) {
+    char *vkey = arena_printf(&c->arena, "%s" CACHE_VARIANT_FMT, fs_path, enc);
+    if (!vkey) return false;
+    uint64_t epoch = 0;
+    (void)cache_begin(fs_path, &epoch);   // o watch do diretório cobre os irmãos
+
+    static const struct { unsigned bit; const char *ext, *name; } sib[] = {
+        { ENC_BR,   ".br", "br"   },
+        { ENC_GZIP, ".gz", "gzip" },
+    };
+    for (size_t i = 0; i < sizeof(sib) / sizeof(sib[0]); i++) {
+        if (!(enc & sib[i].bit)) continue;
+        char *spath = arena_printf(&c->arena, "%s%s", fs_path, sib[i].ext);
+        struct stat sst;
+        int sf = spath ? open_regular(spath, &sst) : -1;
+        if (sf < 0) continue;
+        if (mtime_before(&sst.st_mtim, &st->st_mtim)) {
+            close(sf);   // irmão velho: o original mudou depois dele
+            continue;
+        }
 
-    struct stat st;
-    if (fstat(f, &st) < 0 || !S_ISREG(st.st_mode)) {
-        close(f); util_send_404(fd); return;
+        Validators sval;
+        util_validators(&sst, &sval);
+        if ((size_t)sst.st_size <= cache_max_body()) {
+            CacheEntry *e = load_into_cache(vkey, sf, sst.st_size, ctype, &sval,
+                                            sib[i].name, true, epoch);
+            if (e) { close(sf); send_cached(c, e); return true; }
+        }
+
+        char hdr[512];
+        int hl = format_file_200(hdr, sizeof(hdr), ctype, sst.st_size, &sval, sib[i].name, true);
+        if (hl < 0) { close(sf); continue; }
+        BodySrc src = { .e = NULL, .mem = NULL, .fd = sf };
+        respond_file(c, &src, ctype, sst.st_size, &sval, sib[i].name, true, hdr, (size_t)hl);
+        close(sf);
+        return true;
+    }
+
+    if ((size_t)st->st_size > cache_max_body() || (size_t)st->st_size > COMPRESS_MAX)
+        return false;
+
+    size_t size = (size_t)st->st_size;
+    char *raw = (char *)malloc(size ? size : 1);
+    if (!raw) return false;
+    if (!read_all(f, raw, size)) { free(raw); return false; }
+
+    char hdr[512];
+    CacheEntry *e = NULL;
+    size_t glen = 0;
+    char *gz = (enc & ENC_GZIP) ? gzip_compress(raw, size, &glen) : NULL;
+    if (gz && glen < size) {
+        // ETag próprio da representação gzip (RFC 9110 §8.8.3)
+        Validators gval = *val;
+        size_t el = strlen(gval.etag);
+        if (el > 1 && el + 3 < sizeof(gval.etag)) memcpy(gval.etag + el - 1, "-gz\"", 5);
+        int hl = format_file_200(hdr, sizeof(hdr), ctype, (off_t)glen, &gval, "gzip", true);
+        if (hl >= 0) e = make_entry(vkey, hdr, (size_t)hl, gz, glen, ctype, &gval, "gzip", true, epoch);
+    } else {
+        int hl = format_file_200(hdr, sizeof(hdr), ctype, (off_t)size, val, NULL, true);
+        if (hl >= 0) e = make_entry(vkey, hdr, (size_t)hl, raw, size, ctype, val, NULL, true, epoch);
     }
+    free(gz);
+    free(raw);
+    if (!e) return false;
+    send_cached(c, e);
+    return true;
+}
 
+// -----------------------------------------------------------------------------
+// Enfileira cabeçalhos + arquivo; o corpo sai aos poucos via conn_flush().
+// Arquivos pequenos o bastante passam a morar no cache. `f` é o arquivo
+// regular já aberto (fechado aqui) e `st`, o seu fstat.
+// -----------------------------------------------------------------------------
+static void send_file(Conn *c, const char *fs_path, int f, const struct stat *st_in) {
+    struct stat st = *st_in;
     const char *ctype = util_mime_type(fs_path);
-    util_send_headers(fd, "200 OK", ctype, (long)st.st_size);
-
-    char buf[16 * 1024];
-    ssize_t n;
-    while ((n = read(f, buf, sizeof(buf))) > 0) {
-        ssize_t sent_total = 0;
-        while (sent_total < n) {
-            ssize_t s = send(fd, buf + sent_total, (size_t)(n - sent_total), 0);
-            if (s <= 0) { close(f); return; }
-            sent_total += s;
-        }
+    Validators val;
+    util_validators(&st, &val);
+
+    bool vary = util_mime_compressible(ctype) && st.st_size >= COMPRESS_MIN;
+    unsigned enc = vary ? util_accept_encoding(c->req) : 0;
+    if (enc && send_encoded(c, fs_path, f, &st, ctype, &val, enc)) { close(f); return; }
+
+    uint64_t epoch;
+    if ((size_t)st.st_size <= cache_max_body() && cache_begin(fs_path, &epoch)) {
+        CacheEntry *e = load_into_cache(fs_path, f, st.st_size, ctype, &val, NULL, vary, epoch);
+        if (e) { close(f); send_cached(c, e); return; }
     }
-    close(f);
+
+    char hdr[512];
+    int hl = format_file_200(hdr, sizeof(hdr), ctype, st.st_size, &val, NULL, vary);
+    if (hl < 0) { close(f); c->state = CONN_CLOSING; return; }
+
+    BodySrc src = { .e = NULL, .mem = NULL, .fd = f };
+    respond_file(c, &src, ctype, st.st_size, &val, NULL, vary, hdr, (size_t)hl);
+    close(f);   // cada trecho enfileirado tem sua própria cópia (dup)
 }
 
 // -----------------------------------------------------------------------------
-// Mapeia URL -> caminho seguro em disco (sem permitir "..") e entrega em out_path.
+// Mapeia URL -> caminho em disco (sem permitir "..") e entrega em out_path.
+// Só monta a string, em uma passada: quem garante que o arquivo aberto está
+// sob a raiz é open_beneath(). O caminho serve de chave para os caches.
 // -----------------------------------------------------------------------------
 bool fs_join_and_sanitize(const char *root, const char *url_path, char out_path[]) {
-    // 1) normaliza componentes da URL
-    char clean[PATH_MAX] = "";
+    size_t n = root_len(root);
+    if (n >= PATH_MAX) return false;
+    memcpy(out_path, root, n);
+
     const char *p = url_path;
-    if (*p == '/') p++; // ignora barra inicial
     while (*p) {
-        const char *q = strchr(p, '/');
-        size_t len = q ? (size_t)(q - p) : strlen(p);
-        if (len == 0) { p++; continue; }
-        if (len == 1 && p[0] == '.') {
-            // ignora "."
-        } else if (len == 2 && p[0] == '.' && p[1] == '.') {
-            return false; // recusa ".."
-        } else {
-            if (clean[0]) strncat(clean, "/", sizeof(clean) - strlen(clean) - 1);
-            strncat(clean, p, len);
-        }
-        if (!q) break;
-        p = q + 1;
+        while (*p == '/') p++;   // barras repetidas
+        if (!*p) break;
+        const char *q = strchrnul(p, '/');
+        size_t len = (size_t)(q - p);
+        p = q;
+        if (len == 1 && q[-1] == '.') continue;                   // ignora "."
+        if (len == 2 && q[-2] == '.' && q[-1] == '.') return false; // recusa ".."
+        if (n + 1 + len >= PATH_MAX) return false;
+        out_path[n++] = '/';
+        memcpy(out_path + n, q - len, len);
+        n += len;
     }
+    if (n == 0) out_path[n++] = '/';   // a raiz é "/"
+    out_path[n] = '\0';
+    return true;
+}
+
+// Prefixo dos links da listagem HTML: a URL sem a barra final.
+static char *link_prefix(Conn *c, const char *url_path) {
+    size_t ul = strlen(url_path);
+    char *u = arena_strndup(&c->arena, url_path, ul);
+    if (u && ul > 1 && u[ul - 1] == '/') u[ul - 1] = '\0';
+    return u;
+}
 
-    // 2) resolve raiz para caminho absoluto
-    char root_real[PATH_MAX];
-    if (!realpath(root, root_real)) return false;
+// -----------------------------------------------------------------------------
+// Pacote (--bundle). fs_path é "/" + caminho relativo; o pacote guarda o
+// relativo, sem a barra.
+// -----------------------------------------------------------------------------
 
-    // 3) monta caminho final
-    char resolved[PATH_MAX];
-    if (clean[0]) {
-        if (snprintf(resolved, sizeof(resolved), "%s/%s", root_real, clean) >= (int)sizeof(resolved))
-            return false;
-    } else {
-        if (snprintf(resolved, sizeof(resolved), "%s", root_real) >= (int)sizeof(resolved))
-            return false;
+// Validadores da representação `v`; as comprimidas têm ETag próprio
+// (RFC 9110 §8.8.3), com o mesmo sufixo do gzip feito na hora.
+static void bundled_validators(const PackEntry *e, int v, Validators *val) {
+    size_t el = strlen(e->etag);
+    memcpy(val->etag, e->etag, el + 1);
+    if (v != PACK_IDENTITY && el > 1)
+        memcpy(val->etag + el - 1, v == PACK_GZIP ? "-gz\"" : "-br\"", 5);
+    memcpy(val->last_modified, e->last_modified, sizeof(e->last_modified));
+    val->mtime = (time_t)e->mtime;
+}
+
+static void send_bundled(Conn *c, const PackEntry *e) {
+    int v = PACK_IDENTITY;
+    bool vary = (e->variants & ~(1u << PACK_IDENTITY)) != 0;
+    if (vary) {
+        unsigned enc = util_accept_encoding(c->req);
+        if ((enc & ENC_BR) && (e->variants & (1u << PACK_BR)))          v = PACK_BR;
+        else if ((enc & ENC_GZIP) && (e->variants & (1u << PACK_GZIP))) v = PACK_GZIP;
     }
+    Validators val;
+    bundled_validators(e, v, &val);
+    const char *ctype = bundle_str(e->ctype);
+    off_t size = (off_t)e->body[v].len;
+
+    const char *encoding = v == PACK_BR ? "br" : v == PACK_GZIP ? "gzip" : NULL;
+
+    char hdr[512];
+    int hl = format_file_200(hdr, sizeof(hdr), ctype, size, &val, encoding, vary);
+    if (hl < 0) { c->state = CONN_CLOSING; return; }
+    BodySrc src = { .e = NULL, .mem = bundle_data(&e->body[v]), .fd = -1 };
+    respond_file(c, &src, ctype, size, &val, encoding, vary, hdr, (size_t)hl);
+}
 
-    // 4) garante que resolved permanece sob root_real
-    size_t rl = strlen(root_real);
-    if (strncmp(resolved, root_real, rl) != 0 ||
-        (resolved[rl] != '/' && resolved[rl] != '\0')) {
-        return false;
+// Nomes sob o diretório `rel`, copiados para a arena. -1 se não é diretório
+// do pacote (ou faltou memória: a conexão já está marcada para fechar).
+static long bundled_names(Conn *c, const char *rel, char ***out) {
+    long n = bundle_list(rel, NULL, NULL, 0);
+    if (n < 0) return -1;
+    const char **v = (const char **)conn_scratch(c, (size_t)n * sizeof(*v));
+    size_t *lens = (size_t *)conn_scratch(c, (size_t)n * sizeof(*lens));
+    char **names = (char **)conn_scratch(c, (size_t)n * sizeof(*names));
+    if (!v || !lens || !names) { c->state = CONN_CLOSING; return -1; }
+    bundle_list(rel, v, lens, (size_t)n);
+    for (long i = 0; i < n; i++) {
+        names[i] = arena_strndup(&c->arena, v[i], lens[i]);
+        if (!names[i]) { c->state = CONN_CLOSING; return -1; }
     }
+    *out = names;
+    return n;
+}
 
-    // 5) entrega saída
-    strncpy(out_path, resolved, PATH_MAX - 1);
-    out_path[PATH_MAX - 1] = '\0';
-    return true;
+// Listagem pronta do pacote (vive até o fim): pequena sai copiada junto dos
+// cabeçalhos, grande vai por referência.
+static void send_prebuilt(Conn *c, const char *ctype, const char *body, size_t len) {
+    util_send_headers(c, "200 OK", ctype, (long)len);
+    if (len <= CACHE_COPY_MAX) conn_out_write(c, body, len);
+    else                       conn_out_ref(c, body, len, NULL, NULL);
+}
+
+static void serve_bundle(Conn *c, const char *rel) {
+    const PackEntry *e = bundle_find(rel);
+    if (e) { send_bundled(c, e); return; }
+
+    char *idx = arena_printf(&c->arena, "%s%sindex.html", rel, *rel ? "/" : "");
+    if (!idx) { c->state = CONN_CLOSING; return; }
+    e = bundle_find(idx);
+    if (e) { send_bundled(c, e); return; }
+
+    const BundleDir *d = bundle_dir(rel);
+    if (d) send_prebuilt(c, "text/html; charset=utf-8", d->html, d->html_len);
+    else   util_send_404(c);
+}
+
+// "?list=1" sobre o pacote. A página usa a posição do próximo nome como
+// cursor; stream devolve a lista inteira de uma vez (já está em memória).
+static void send_bundle_dir_json(Conn *c, const char *rel, const ListQuery *q) {
+    const BundleDir *d = bundle_dir(rel);
+    if (!d) { util_send_404(c); return; }
+    if (!q->paged) {
+        send_prebuilt(c, "application/json; charset=utf-8", d->json, d->json_len);
+        return;
+    }
+
+    char **names;
+    long n = bundled_names(c, rel, &names);
+    if (n < 0) {
+        if (c->state != CONN_CLOSING) util_send_404(c);
+        return;
+    }
+    size_t len;
+
+    // Mesmo filtro da listagem: sem ocultos e sem index.html
+    size_t k = 0;
+    for (long i = 0; i < n; i++)
+        if (names[i][0] != '.' && strcasecmp(names[i], "index.html") != 0) names[k++] = names[i];
+
+    size_t start = q->offset;
+    if (q->cursor) {
+        char *end;
+        unsigned long long v = strtoull(q->cursor, &end, 10);
+        if (*end || v > k) { util_send_400(c); return; }
+        start = (size_t)v;
+    }
+    if (start > k) start = k;
+    size_t stop = k - start > q->limit ? start + q->limit : k;
+
+    size_t cap = 64;
+    for (size_t i = start; i < stop; i++) cap += 2 * strlen(names[i]) + 3;
+    char *body = (char *)conn_scratch(c, cap);
+    if (!body) { c->state = CONN_CLOSING; return; }
+    len = (size_t)snprintf(body, cap, "{\"items\":[");
+    for (size_t i = start; i < stop; i++) {
+        if (i > start) body[len++] = ',';
+        body[len++] = '"';
+        len += listing_json_escape(body + len, names[i]);
+        body[len++] = '"';
+    }
+    if (stop == k) len += (size_t)snprintf(body + len, cap - len, "],\"next\":null}");
+    else           len += (size_t)snprintf(body + len, cap - len, "],\"next\":\"%zu\"}", stop);
+    util_send_headers(c, "200 OK", "application/json; charset=utf-8", (long)len);
+    conn_out_ref(c, body, len, NULL, NULL);
 }
 
 // -----------------------------------------------------------------------------
 // Decide resposta para o caminho dado: index.html (se dir), listagem ou arquivo.
 // -----------------------------------------------------------------------------
-void fs_serve_path(int fd, const char *url_path, const char *fs_path) {
+void fs_serve_path(Conn *c, const char *url_path, const char *fs_path) {
+    if (bundle_enabled()) { serve_bundle(c, fs_path + 1); return; }
+
+    char *idx = arena_printf(&c->arena, "%s/index.html", fs_path);
+    if (!idx) { c->state = CONN_CLOSING; return; }
+
+    // Cache primeiro: um acerto não toca no sistema de arquivos. A chave é
+    // sempre o arquivo; um diretório acerta pelo seu index.html.
+    if (cache_enabled()) {
+        const char *key = fs_path;
+        CacheEntry *e = cache_get(fs_path);
+        if (!e) { key = idx; e = cache_get(idx); }
+        if (e) {
+            // Tipo comprimível: a representação certa depende de Accept-Encoding
+            unsigned enc = 0;
+            if (util_mime_compressible(e->ctype) && e->body_len >= COMPRESS_MIN)
+                enc = util_accept_encoding(c->req);
+            if (!enc) { send_cached(c, e); return; }
+
+            char *vkey = arena_printf(&c->arena, "%s" CACHE_VARIANT_FMT, key, enc);
+            CacheEntry *v = vkey ? cache_get(vkey) : NULL;
+            cache_release(e);
+            if (v) { send_cached(c, v); return; }
+
+            // Monta a variante e guarda no cache
+            struct stat st;
+            int f = open_regular(key, &st);
+            if (f < 0) util_send_404(c);
+            else       send_file(c, key, f, &st);
+            return;
+        }
+        cache_note_miss();
+    }
+
+    char *u = link_prefix(c, url_path);
+    if (!u) { c->state = CONN_CLOSING; return; }
+    bool gz = (util_accept_encoding(c->req) & ENC_GZIP) != 0;
+
+    // Listagem em memória: também dispensa abrir o diretório
+    ListingBody *lb = listing_find(fs_path, LISTING_HTML, u, gz);
+    if (lb) { send_listing(c, "text/html; charset=utf-8", lb); return; }
+
+    // Uma abertura e um fstat decidem o resto
+    int fd = open_beneath(fs_path, OPEN_FLAGS);
     struct stat st;
-    if (stat(fs_path, &st) != 0) { util_send_404(fd); return; }
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        if (fd >= 0) close(fd);
+        util_send_404(c);
+        return;
+    }
 
+    if (S_ISREG(st.st_mode)) {
+        send_file(c, fs_path, fd, &st);
+        return;
+    }
     if (S_ISDIR(st.st_mode)) {
-        char idx[PATH_MAX];
-        snprintf(idx, sizeof(idx), "%s/index.html", fs_path);
-
-        if (stat(idx, &st) == 0 && S_ISREG(st.st_mode)) {
+        struct stat ist;
+        int xf = open_regular(idx, &ist);
+        if (xf >= 0) {
             // Diretório com index.html → serve o index (frontend buscará /?list=1)
-            send_file(fd, idx);
+            send_file(c, idx, xf, &ist);
         } else {
             // Sem index.html → listagem HTML simples (ocultando index.html por coerência)
-            char u[PATH_MAX];
-            snprintf(u, sizeof(u), "%s", url_path);
-            size_t ul = strlen(u);
-            if (ul > 1 && u[ul - 1] == '/') u[ul - 1] = '\0';
-            send_dir_listing(fd, u, fs_path);
+            lb = listing_get(fs_path, fd, LISTING_HTML, u, gz);
+            if (lb) send_listing(c, "text/html; charset=utf-8", lb);
+            else    util_send_404(c);
         }
-    } else if (S_ISREG(st.st_mode)) {
-        send_file(fd, fs_path);
     } else {
-        util_send_404(fd);
+        util_send_404(c);
     }
+    close(fd);
 }
 
 // -----------------------------------------------------------------------------
-// NOVO: envia JSON com os itens do diretório (exceto "index.html" e ocultos).
-// Use no http.c quando a query string indicar listagem (ex.: "?list=1").
+// Listagem direta do disco (getdents64), para diretórios de qualquer tamanho.
 // -----------------------------------------------------------------------------
-void fs_send_dir_json(int fd, const char *fs_dir) {
-    DIR *d = opendir(fs_dir);
-    if (!d) { util_send_404(fd); return; }
+#define LIST_CHUNK (64 * 1024)   // JSON por chunk no modo stream
+
+#define PAGE_START 4096         // corpo inicial de uma página (dobra se precisar)
+#define PAGE_TAIL  40           // reserva para "],\"next\":\"<cursor>\"}"
+
+// Uma página: {"items":[...],"next":"<cursor>"} ("next": null na última).
+// Memória proporcional ao que sai, não ao diretório nem ao limite.
+static void send_dir_page(Conn *c, ListingStream *s, const ListQuery *q) {
+    if (q->cursor ? !listing_stream_seek(s, q->cursor) : !listing_stream_skip(s, q->offset)) {
+        util_send_400(c);
+        return;
+    }
+
+    // O corpo é montado direto na arena e sai por referência, sem cópia;
+    // cresce no lugar (arena_grow) quando o próximo nome não cabe
+    size_t cap = PAGE_START, left = q->limit;
+    char *body = (char *)conn_scratch(c, cap);
+    if (!body) { c->state = CONN_CLOSING; return; }
+    size_t len = (size_t)snprintf(body, cap, "{\"items\":[");
+    for (;;) {
+        ssize_t n = listing_stream_json(s, body + len, cap - len - PAGE_TAIL, &left);
+        if (n < 0) { c->state = CONN_CLOSING; return; }
+        len += (size_t)n;
+        if (left == 0 || listing_stream_done(s)) break;
+        body = (char *)arena_grow(&c->arena, body, cap, cap * 2);
+        if (!body) { c->state = CONN_CLOSING; return; }
+        cap *= 2;
+    }
 
-    // Monta JSON em memória.
-    size_t cap = 0, len = 0;
-    char *json = NULL;
-    (void)buf_append(&json, &cap, &len, "[");
+    if (listing_stream_done(s)) {
+        len += (size_t)snprintf(body + len, cap - len, "],\"next\":null}");
+    } else {
+        char next[24];
+        listing_stream_cursor(s, next, sizeof(next));
+        len += (size_t)snprintf(body + len, cap - len, "],\"next\":\"%s\"}", next);
+    }
+    util_send_headers(c, "200 OK", "application/json; charset=utf-8", (long)len);
+    conn_out_ref(c, body, len, NULL, NULL);
+}
 
-    struct dirent *ent;
-    bool first = true;
-    while ((ent = readdir(d)) != NULL) {
-        const char *name = ent->d_name;
+typedef struct {
+    ListingStream *s;
+    bool           chunked;
+    bool           opened;    // "[" já saiu
+} DirStreamCtx;
 
-        // Oculta ".", "..", "index.html" e itens que começam com "."
-        if (!strcmp(name, ".") || !strcmp(name, "..")) continue;
-        if (!strcasecmp(name, "index.html")) continue;
-        if (name[0] == '.') continue;
+static void dir_stream_free(void *ctx) {
+    DirStreamCtx *ds = (DirStreamCtx *)ctx;
+    listing_stream_close(ds->s);
+    free(ds);
+}
 
-        // Escapa para JSON
-        char esc[PATH_MAX * 2]; // espaço suficiente para aspas escapadas
-        json_escape_into(esc, name);
+// Produtor do modo stream: um lote de nomes por chamada (só quando a fila de
+// saída esvaziou), então a memória não cresce com o diretório.
+static int dir_stream_produce(Conn *c, void *ctx) {
+    DirStreamCtx *ds = (DirStreamCtx *)ctx;
+    char buf[LIST_CHUNK];
+    size_t len = 0;
+    if (!ds->opened) { buf[len++] = '['; ds->opened = true; }
+
+    size_t all = (size_t)-1;
+    ssize_t n = listing_stream_json(ds->s, buf + len, sizeof(buf) - len - 1, &all);
+    if (n < 0) return -1;   // corpo truncado: a conexão fecha
+    len += (size_t)n;
+    bool done = listing_stream_done(ds->s);
+    if (done) buf[len++] = ']';
+
+    if (ds->chunked) {
+        conn_out_printf(c, "%zx\r\n", len);
+        conn_out_write(c, buf, len);
+        conn_out_write(c, done ? "\r\n0\r\n\r\n" : "\r\n", done ? 7 : 2);
+    } else {
+        conn_out_write(c, buf, len);
+    }
+    return done ? 0 : 1;
+}
 
-        char tmp[PATH_MAX * 2 + 8];
-        snprintf(tmp, sizeof tmp, "%s\"%s\"", first ? "" : ",", esc);
-        first = false;
-        if (!buf_append(&json, &cap, &len, tmp)) { free(json); closedir(d); return; }
+// Lista inteira sem Content-Length: chunked em HTTP/1.1; em HTTP/1.0 o fim
+// do corpo é o fechamento da conexão.
+static void send_dir_stream(Conn *c, ListingStream *s, const ListQuery *q) {
+    if (q->cursor ? !listing_stream_seek(s, q->cursor) : !listing_stream_skip(s, q->offset)) {
+        listing_stream_close(s);
+        util_send_400(c);
+        return;
     }
-    closedir(d);
+    DirStreamCtx *ds = (DirStreamCtx *)calloc(1, sizeof(*ds));
+    if (!ds) { listing_stream_close(s); c->state = CONN_CLOSING; return; }
+    ds->s = s;
+    ds->chunked = q->chunked;
+    if (!q->chunked) c->keep_alive = false;
+
+    conn_out_printf(c,
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/json; charset=utf-8\r\n"
+        "%s",
+        q->chunked ? "Transfer-Encoding: chunked\r\n" : "");
+    util_end_headers(c);
+    conn_set_producer(c, dir_stream_produce, dir_stream_free, ds);
+}
 
-    if (!buf_append(&json, &cap, &len, "]")) { free(json); return; }
+// -----------------------------------------------------------------------------
+// NOVO: envia JSON com os itens do diretório (exceto "index.html" e ocultos).
+// Use no http.c quando a query string indicar listagem (ex.: "?list=1").
+// Sem paginação, vem do cache de listagens; paginada ou em stream, é lida
+// direto do disco aos poucos.
+// -----------------------------------------------------------------------------
+void fs_send_dir_json(Conn *c, const char *fs_dir, const ListQuery *q) {
+    if (bundle_enabled()) { send_bundle_dir_json(c, fs_dir + 1, q); return; }
+    if (q->paged || q->stream) {
+        // O produtor do stream sobrevive aos resets da arena: fica no heap.
+        // A página cabe na arena, junto com o próprio corpo.
+        int dfd = open_beneath(fs_dir, OPEN_FLAGS | O_DIRECTORY);
+        ListingStream *s = q->stream ? listing_stream_open(dfd)
+                                     : listing_stream_open_in(conn_scratch(c, listing_stream_size()), dfd);
+        if (!s) {
+            if (dfd >= 0) c->state = CONN_CLOSING;   // sem memória
+            else          util_send_404(c);          // não é diretório (ou ilegível)
+            return;
+        }
+        if (q->stream) { send_dir_stream(c, s, q); return; }   // s passa ao produtor
+        send_dir_page(c, s, q);
+        listing_stream_close(s);
+        return;
+    }
 
-    util_send_headers(fd, "200 OK", "application/json; charset=utf-8", (long)len);
-    (void)send(fd, json, len, 0);
-    free(json);
+    bool gz = (util_accept_encoding(c->req) & ENC_GZIP) != 0;
+    ListingBody *lb = listing_find(fs_dir, LISTING_JSON, "", gz);
+    if (!lb) {
+        int fd = open_beneath(fs_dir, OPEN_FLAGS | O_DIRECTORY);
+        if (fd >= 0) {
+            lb = listing_get(fs_dir, fd, LISTING_JSON, "", gz);
+            close(fd);
+        }
+    }
+    if (!lb) { util_send_404(c); return; }   // não é diretório (ou ilegível)
+    send_listing(c, "application/json; charset=utf-8", lb);
 }
\ No newline at end of file
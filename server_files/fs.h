@@ -1,9 +1,26 @@
 #ifndef FS_H
 #define FS_H
 #include <stdbool.h>
+#include "conn.h"
 
+// Parâmetros de "?list=1" (ver http.c).
+typedef struct {
+    bool        paged;     // offset/limit/cursor presentes: resposta paginada
+    size_t      offset;    // nomes a pular
+    size_t      limit;     // nomes por página
+    const char *cursor;    // continuação devolvida em "next" (NULL = início)
+    bool        stream;    // lista inteira em chunked, lida aos poucos do disco
+    bool        chunked;   // o cliente aceita Transfer-Encoding: chunked (HTTP/1.1)
+} ListQuery;
+
+// Abre a raiz (já resolvida com realpath) uma vez; os requests são abertos
+// relativos a ela. Chamar antes de servir.
+bool fs_init(const char *root);
+bool fs_has_openat2(void);   // false: percurso com openat(O_NOFOLLOW)
+
+// `out_path` precisa de strlen(root) + strlen(url_path) + 2 bytes.
 bool fs_join_and_sanitize(const char *root, const char *url_path, char out_path[]);
-void fs_serve_path(int fd, const char *url_path, const char *fs_path);
-void fs_send_dir_json(int fd, const char *fs_dir);
+void fs_serve_path(Conn *c, const char *url_path, const char *fs_path);
+void fs_send_dir_json(Conn *c, const char *fs_dir, const ListQuery *q);
 
 #endif
\ No newline at end of file
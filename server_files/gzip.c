@@ -0,0 +1,197 @@
+// Compressor gzip para respostas de texto.
+//
+// Só o lado da compressão do DEFLATE: procura de repetições (LZ77) por tabela
+// hash de 3 bytes com cadeias limitadas, e um único bloco com os códigos de
+// Huffman fixos (BTYPE=01), que dispensam transmitir tabelas. O resultado é
+// maior que o de um zlib -6, mas texto/JSON repetitivo ainda encolhe várias
+// vezes, e o servidor continua sem bibliotecas externas.
+
+#include "gzip.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WSIZE      32768          // janela do DEFLATE
+#define WMASK      (WSIZE - 1)
+#define HBITS      15
+#define HSIZE      (1 << HBITS)
+#define MIN_MATCH  3
+#define MAX_MATCH  258
+#define MAX_CHAIN  32             // candidatos examinados por posição
+
+// -----------------------------------------------------------------------------
+// CRC-32 (polinômio refletido 0xEDB88320)
+// -----------------------------------------------------------------------------
+
+static uint32_t crc_table[256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void crc_init(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc_table[n] = c;
+    }
+}
+
+uint32_t gzip_crc32(uint32_t crc, const void *buf, size_t len) {
+    pthread_once(&crc_once, crc_init);
+    const unsigned char *p = (const unsigned char *)buf;
+    crc = ~crc;
+    while (len--) crc = crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// -----------------------------------------------------------------------------
+// Escrita de bits (LSB primeiro, como o DEFLATE exige)
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    unsigned char *out;
+    size_t         len;
+    uint64_t       bits;
+    int            nbits;
+} BitWriter;
+
+static void put_bits(BitWriter *bw, uint32_t v, int n) {
+    bw->bits |= (uint64_t)v << bw->nbits;
+    bw->nbits += n;
+    while (bw->nbits >= 8) {
+        bw->out[bw->len++] = (unsigned char)bw->bits;
+        bw->bits >>= 8;
+        bw->nbits -= 8;
+    }
+}
+
+static void flush_bits(BitWriter *bw) {
+    if (bw->nbits > 0) bw->out[bw->len++] = (unsigned char)bw->bits;
+    bw->bits = 0;
+    bw->nbits = 0;
+}
+
+// Códigos de Huffman são definidos MSB primeiro: inverte antes de escrever.
+static void put_code(BitWriter *bw, uint32_t code, int n) {
+    uint32_t r = 0;
+    for (int i = 0; i < n; i++) { r = (r << 1) | (code & 1); code >>= 1; }
+    put_bits(bw, r, n);
+}
+
+// Tabela fixa de literais/comprimentos (RFC 1951 §3.2.6).
+static void put_litlen(BitWriter *bw, int sym) {
+    if (sym < 144)      put_code(bw, 0x30 + (uint32_t)sym, 8);
+    else if (sym < 256) put_code(bw, 0x190 + (uint32_t)(sym - 144), 9);
+    else if (sym < 280) put_code(bw, (uint32_t)(sym - 256), 7);
+    else                put_code(bw, 0xC0 + (uint32_t)(sym - 280), 8);
+}
+
+static const uint16_t len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static void put_match(BitWriter *bw, int len, int dist) {
+    int li = 28;
+    while (len_base[li] > len) li--;
+    put_litlen(bw, 257 + li);
+    if (len_extra[li]) put_bits(bw, (uint32_t)(len - len_base[li]), len_extra[li]);
+
+    int di = 29;
+    while (dist_base[di] > dist) di--;
+    put_code(bw, (uint32_t)di, 5);
+    if (dist_extra[di]) put_bits(bw, (uint32_t)(dist - dist_base[di]), dist_extra[di]);
+}
+
+// -----------------------------------------------------------------------------
+// LZ77 + bloco fixo
+// -----------------------------------------------------------------------------
+
+static inline uint32_t hash3(const unsigned char *p) {
+    uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+    return (v * 2654435761u) >> (32 - HBITS);
+}
+
+static void deflate_fixed(BitWriter *bw, const unsigned char *src, size_t len,
+                          int32_t *head, int32_t *prev) {
+    put_bits(bw, 1, 1);   // BFINAL
+    put_bits(bw, 1, 2);   // BTYPE = 01 (Huffman fixo)
+
+    size_t i = 0;
+    while (i < len) {
+        int best = 0, best_dist = 0;
+        if (i + MIN_MATCH <= len) {
+            uint32_t h = hash3(src + i);
+            int32_t cand = head[h];
+            int chain = MAX_CHAIN;
+            size_t max = len - i < MAX_MATCH ? len - i : MAX_MATCH;
+            while (cand >= 0 && i - (size_t)cand <= WSIZE && chain-- > 0) {
+                const unsigned char *a = src + cand, *b = src + i;
+                if (a[best] == b[best]) {
+                    size_t m = 0;
+                    while (m < max && a[m] == b[m]) m++;
+                    if ((int)m > best) {
+                        best = (int)m;
+                        best_dist = (int)(i - (size_t)cand);
+                        if (m == max) break;
+                    }
+                }
+                int32_t next = prev[cand & WMASK];
+                if (next >= cand) break;   // entrada reciclada da janela
+                cand = next;
+            }
+        }
+
+        int step = (best >= MIN_MATCH) ? best : 1;
+        if (best >= MIN_MATCH) put_match(bw, best, best_dist);
+        else                   put_litlen(bw, src[i]);
+
+        // Indexa todas as posições consumidas (a última sequência de 3 bytes
+        // completa é len - 3)
+        for (int k = 0; k < step; k++, i++) {
+            if (i + MIN_MATCH <= len) {
+                uint32_t h = hash3(src + i);
+                prev[i & WMASK] = head[h];
+                head[h] = (int32_t)i;
+            }
+        }
+    }
+    put_litlen(bw, 256);  // fim do bloco
+    flush_bits(bw);
+}
+
+char *gzip_compress(const void *src, size_t len, size_t *out_len) {
+    // Pior caso: todo byte como literal de 9 bits + cabeçalho/rodapé
+    size_t cap = len + len / 8 + 64;
+    unsigned char *out = (unsigned char *)malloc(cap);
+    int32_t *head = (int32_t *)malloc(HSIZE * sizeof(int32_t));
+    int32_t *prev = (int32_t *)malloc(WSIZE * sizeof(int32_t));
+    if (!out || !head || !prev) { free(out); free(head); free(prev); return NULL; }
+    memset(head, 0xFF, HSIZE * sizeof(int32_t));   // -1 = sem candidato
+    memset(prev, 0xFF, WSIZE * sizeof(int32_t));
+
+    // Cabeçalho gzip: ID1 ID2 CM=8 FLG=0 MTIME=0 XFL=0 OS=3 (Unix)
+    static const unsigned char hdr[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3 };
+    memcpy(out, hdr, sizeof(hdr));
+
+    BitWriter bw = { .out = out, .len = sizeof(hdr) };
+    deflate_fixed(&bw, (const unsigned char *)src, len, head, prev);
+    free(head);
+    free(prev);
+
+    uint32_t crc = gzip_crc32(0, src, len);
+    uint32_t isize = (uint32_t)len;
+    for (int k = 0; k < 4; k++) out[bw.len++] = (unsigned char)(crc >> (8 * k));
+    for (int k = 0; k < 4; k++) out[bw.len++] = (unsigned char)(isize >> (8 * k));
+
+    *out_len = bw.len;
+    return (char *)out;
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+// server_files/gzip.h
+// Compressor gzip (RFC 1952/1951) mínimo, sem dependências: LZ77 com janela
+// de 32 KB e códigos de Huffman fixos.
+#ifndef GZIP_H
+#define GZIP_H
+#include <stddef.h>
+#include <stdint.h>
+
+// Comprime `len` bytes; devolve buffer alocado com malloc (ou NULL).
+char *gzip_compress(const void *src, size_t len, size_t *out_len);
+
+uint32_t gzip_crc32(uint32_t crc, const void *buf, size_t len);
+
+#endif
\ No newline at end of file
@@ -1,132 +1,1166 @@
 // Camada de rede: abre socket, aceita conexões e trata cada cliente.
 // HTTP: aceita GET e delega o mapeamento/retorno para fs.c.
+//
+// Cada worker (thread) roda um laço epoll (reactor) dono do seu próprio
+// socket de escuta (SO_REUSEPORT) e de todos os sockets de cliente que ele
+// aceitou, todos não bloqueantes. O kernel distribui as conexões entre os
+// sockets de escuta, então os workers não compartilham nada no caminho
+// quente. Cada conexão guarda seu próprio estado (conn.h): bytes lidos até
+// agora, fase e fila de resposta pendente, então um cliente lento ou um
+// download grande não trava os demais.
+//
+// Com --io=uring, o mesmo atendimento roda sobre io_uring em vez de epoll
+// (ver "Backend io_uring" abaixo).
 
+#define _GNU_SOURCE
 #include "http.h"
+#include "accesslog.h"
+#include "arena.h"
+#include "bundle.h"
+#include "cache.h"
+#include "conn.h"
 #include "fs.h"
+#include "listing.h"
+#include "mime.h"
+#include "scan.h"
+#include "stats.h"
+#include "timer.h"
+#include "uring.h"
 #include "util.h"
 
-#include <arpa/inet.h>   
-#include <netinet/in.h>  
-#include <stdio.h>       
-#include <string.h>      
-#include <sys/socket.h>  
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
 #include <sys/types.h>
-#include <sys/stat.h>    
-#include <unistd.h>      
-#include <limits.h>      
-#include <stdlib.h>      
-
-#define BACKLOG 16        // fila de conexões pendentes
-#define RECV_BUF 4096     // buffer para ler a primeira linha do request
-
-// Trata um cliente: lê a primeira linha, valida método e chama a camada de FS.
-static void handle_client(int cfd, const char *root_real) {
-    char buf[RECV_BUF + 1];
-
-    // Lê até RECV_BUF bytes (suficiente para "GET /path HTTP/1.1\r\n")
-    ssize_t n = recv(cfd, buf, RECV_BUF, 0);
-    if (n <= 0) { close(cfd); return; }
-    buf[n] = '\0';
-
-    // Parse da primeira linha: MÉTODO, URL e VERSÃO
-    char method[16], url[1024], version[16];
-    if (sscanf(buf, "%15s %1023s %15s", method, url, version) < 2) {
-        util_send_400(cfd);
-        close(cfd);
+#include <sys/stat.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdlib.h>
+
+#define MAX_EVENTS 256    // eventos devolvidos por epoll_wait
+#define PIPELINE_MAX 16   // requests enfileirados por conexão antes de drenar a saída
+#define TICK_MS 250       // resolução dos prazos das conexões (tick da roda)
+#define LIST_LIMIT_DEFAULT 100   // nomes por página em "?list=1&offset=..."
+#define LIST_LIMIT_MAX     1000
+
+// Estado de um worker: socket de escuta e epoll próprios, além da roda com
+// os prazos das suas conexões.
+typedef struct Worker {
+    int                id;
+    int                cpu;        // CPU fixada (-1 = sem afinidade)
+    int                sfd, efd;
+    const char        *root_real;
+    const HttpConfig  *cfg;
+    ReqLimits          limits;     // limites do parser (derivados de cfg)
+    TimerWheel         timers;     // prazos das conexões, em ticks de TICK_MS
+    LogRing           *log;        // anel do log de acesso (NULL = desligado)
+    pthread_t          th;
+
+    // Backend io_uring (uring == false: epoll)
+    bool               uring;
+    Uring              ring;
+    UringBufs          bufs;
+    struct __kernel_timespec tick;
+} Worker;
+
+// Marcador no epoll para o socket de escuta (conexões usam o ponteiro Conn*).
+static int g_listen_tag;
+
+// SIGUSR1 pede um relatório de contadores (impresso pelo worker 0).
+static volatile sig_atomic_t g_report;
+
+static void on_sigusr1(int sig) {
+    (void)sig;
+    g_report = 1;
+}
+
+static void print_report(void) {
+    ArenaStats as;
+    arena_stats(&as);
+    fprintf(stderr, "memória: %llu mallocs, %llu frees (arenas e pools), %zu KB em uso, %llu objetos nas pools\n",
+            (unsigned long long)as.heap_allocs, (unsigned long long)as.heap_frees,
+            as.heap_bytes / 1024, (unsigned long long)as.pool_objs);
+
+    if (accesslog_enabled()) {
+        AccessLogStats ls;
+        accesslog_stats(&ls);
+        fprintf(stderr, "log de acesso: %llu registros gravados, %llu descartados (anel cheio)\n",
+                (unsigned long long)ls.written, (unsigned long long)ls.dropped);
+    }
+
+    if (cache_enabled()) {
+        CacheStats cs;
+        cache_stats(&cs);
+        uint64_t total = cs.hits + cs.misses;
+        fprintf(stderr,
+            "cache: %llu acertos, %llu faltas (%.1f%%), %zu entradas, %zu/%zu KB, "
+            "%llu inserções, %llu expulsas (LRU), %llu invalidadas\n",
+            (unsigned long long)cs.hits, (unsigned long long)cs.misses,
+            total ? 100.0 * (double)cs.hits / (double)total : 0.0,
+            cs.entries, cs.bytes / 1024, cs.budget / 1024,
+            (unsigned long long)cs.inserts, (unsigned long long)cs.evictions,
+            (unsigned long long)cs.invalidations);
+    } else {
+        fprintf(stderr, "cache: desligado\n");
         return;
     }
 
-    // Aceita apenas GET (didático)
-    if (strcmp(method, "GET") != 0) {
-        util_send_405(cfd);
-        close(cfd);
+    ListingStats ls;
+    listing_stats(&ls);
+    fprintf(stderr, "listagens: %llu acertos, %llu varreduras, %llu correções (inotify), %llu diretórios\n",
+            (unsigned long long)ls.hits, (unsigned long long)ls.misses,
+            (unsigned long long)ls.patches, (unsigned long long)ls.dirs);
+}
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Decide se a conexão continua aberta depois deste request: HTTP/1.1 é
+// persistente por padrão, HTTP/1.0 só com "Connection: keep-alive".
+static bool want_keep_alive(const Worker *w, const Conn *c, const HttpRequest *r) {
+    if (w->cfg->keepalive_timeout <= 0) return false;
+    if (w->cfg->max_requests > 0 && c->requests + 1 >= (unsigned)w->cfg->max_requests) return false;
+
+    size_t len = 0;
+    const char *v = util_find_header(r, "Connection", &len);
+    if (r->minor >= 1) return !(v && util_header_has_token(v, len, "close"));
+    return v && util_header_has_token(v, len, "keep-alive");
+}
+
+// Número decimal não negativo e completo (parâmetros de paginação).
+static bool parse_count(const char *v, size_t *out) {
+    char *end;
+    errno = 0;
+    unsigned long long n = strtoull(v, &end, 10);
+    if (errno || end == v || *end || *v == '-') return false;
+    *out = (size_t)n;
+    return true;
+}
+
+// Lê os parâmetros de "?list=1": paginação por offset/limit ou por cursor
+// ("next" da página anterior) e o modo stream. false = parâmetro inválido.
+static bool parse_list_query(const char *qs, ListQuery *lq, char *cursor, size_t cap) {
+    char v[32];
+    if (util_query_param(qs, "offset", v, sizeof(v))) {
+        if (!parse_count(v, &lq->offset)) return false;
+        lq->paged = true;
+    }
+    if (util_query_param(qs, "limit", v, sizeof(v))) {
+        if (!parse_count(v, &lq->limit) || lq->limit == 0) return false;
+        if (lq->limit > LIST_LIMIT_MAX) lq->limit = LIST_LIMIT_MAX;
+        lq->paged = true;
+    }
+    if (util_query_param(qs, "cursor", cursor, cap)) {
+        if (!*cursor) return false;
+        lq->cursor = cursor;
+        lq->paged = true;
+    }
+    if (util_query_param(qs, "stream", v, sizeof(v)) && !strcmp(v, "1")) lq->stream = true;
+    return true;
+}
+
+// Métricas em texto do Prometheus, ou JSON com "?format=json".
+static void send_stats(Conn *c, const char *qs) {
+    char v[8];
+    bool json = qs && util_query_param(qs, "format", v, sizeof(v)) && !strcmp(v, "json");
+    size_t len = 0;
+    char *body = stats_render(&c->arena, json, &len);
+    if (!body) { c->state = CONN_CLOSING; return; }
+    util_send_headers(c, "200 OK",
+                      json ? "application/json; charset=utf-8"
+                           : "text/plain; version=0.0.4; charset=utf-8",
+                      (long)len);
+    conn_out_ref(c, body, len, NULL, NULL);
+}
+
+// Trata o request já interpretado em c->req: valida método e chama a camada
+// de FS. A resposta fica enfileirada na conexão; quem envia é o laço de eventos.
+static void handle_client(Worker *w, Conn *c) {
+    const char *root_real = w->root_real;
+    const HttpRequest *r = c->req;
+    c->keep_alive = want_keep_alive(w, c, r);
+
+    // Aceita apenas GET (didático). Um eventual corpo não é lido, então a
+    // conexão não pode ser reaproveitada.
+    if (!req_view_eq(r->method, "GET")) {
+        c->keep_alive = false;
+        util_send_405(c);
         return;
     }
 
     // ---- Query string -----------------------------------------------------
-    // Mantemos a query para detectar "?list=1" (usada pelo index.html).
-    // Depois de checar, removemos a query da URL para mapear o caminho.
+    // Mantemos a query para detectar "?list=1" (usada pelo index.html) e a
+    // paginação. Depois de checar, removemos a query da URL para mapear o caminho.
+    // Cópias do request vão para a arena da conexão (zerada com a resposta)
+    char *url = arena_strndup(&c->arena, r->target.p, r->target.len);
+    if (!url) { c->state = CONN_CLOSING; return; }
+
     int want_list = 0;
+    ListQuery lq = { .limit = LIST_LIMIT_DEFAULT, .chunked = r->minor >= 1 };
+    char cursor[32];
     char *q = strchr(url, '?');
     if (q) {
-        // procura "list=1" simples (não fazemos parse completo, didático)
-        if (strstr(q + 1, "list=1") != NULL) want_list = 1;
         *q = '\0'; // remove query para resolver o caminho físico
+        char v[8];
+        if (util_query_param(q + 1, "list", v, sizeof(v)) && !strcmp(v, "1")) {
+            want_list = 1;
+            if (!parse_list_query(q + 1, &lq, cursor, sizeof(cursor))) {
+                util_send_400(c);
+                return;
+            }
+        }
+    }
+
+    // Métricas (--stats): caminho exato, sem passar pelo disco
+    if (w->cfg->stats_path && !strcmp(url, w->cfg->stats_path)) {
+        send_stats(c, q ? q + 1 : NULL);
+        return;
     }
 
     // Decodifica %XX
     util_url_decode(url);
 
     // Constrói o caminho de arquivo de forma segura (sem permitir "..")
-    char fs_path[PATH_MAX];
+    char *fs_path = (char *)conn_scratch(c, strlen(root_real) + strlen(url) + 2);
+    if (!fs_path) { c->state = CONN_CLOSING; return; }
     if (!fs_join_and_sanitize(root_real, url, fs_path)) {
-        util_send_404(cfd);
-        close(cfd);
+        util_send_404(c);
         return;
     }
 
     // Se pediram "?list=1", e o alvo é um diretório, responde JSON com a lista
     if (want_list) {
-        struct stat st;
-        if (stat(fs_path, &st) == 0 && S_ISDIR(st.st_mode)) {
-            fs_send_dir_json(cfd, fs_path);  // lista sem "index.html" e sem ocultos
+        // Lista sem "index.html" e sem ocultos; 404 se não for diretório
+        fs_send_dir_json(c, fs_path, &lq);
+        return;
+    }
+
+    // Responde: arquivo (com MIME) ou diretório (index.html / listagem HTML)
+    fs_serve_path(c, url, fs_path);
+}
+
+// -----------------------------------------------------------------------------
+// Reactor (um por worker)
+// -----------------------------------------------------------------------------
+
+// Prazos por conexão. Cada uma tem um só temporizador na roda do worker,
+// armado conforme a fase:
+//   HEADER  da conexão (ou do 1º byte após ociosa) até o request completo.
+//           Bytes novos NÃO renovam o prazo: um cliente que manda um byte por
+//           segundo (slowloris) cai igual a um que não manda nada.
+//   IDLE    keep-alive, entre a resposta e o 1º byte do próximo request.
+//   SEND    resposta na fila: a cada janela de send_timeout segundos o
+//           cliente precisa ter consumido min_send_rate * janela bytes.
+// Armar só reencadeia o temporizador (a roda usa o tick do último avanço,
+// sem consultar o relógio); expirar fecha a conexão.
+enum { DEADLINE_NONE, DEADLINE_HEADER, DEADLINE_IDLE, DEADLINE_SEND };
+
+static void deadline_set(Worker *w, Conn *c, int kind, int seconds) {
+    if (c->state == CONN_CLOSING) return;   // io_uring: esperando os CQEs para liberar
+    c->deadline = (unsigned char)kind;
+    timer_add(&w->timers, &c->timer, w->timers.now + ((uint64_t)seconds * 1000 + TICK_MS - 1) / TICK_MS);
+}
+
+static void deadline_header(Worker *w, Conn *c) {
+    deadline_set(w, c, DEADLINE_HEADER, w->cfg->header_timeout);
+}
+
+static void deadline_send(Worker *w, Conn *c) {
+    c->bytes_mark = c->bytes_out;
+    deadline_set(w, c, DEADLINE_SEND, w->cfg->send_timeout);
+}
+
+static void uring_close(Worker *w, Conn *c);
+static void uring_send(Worker *w, Conn *c);
+
+static void conn_close(Worker *w, Conn *c) {
+    timer_del(&w->timers, &c->timer);
+    if (w->uring) { uring_close(w, c); return; }
+    (void)epoll_ctl(w->efd, EPOLL_CTL_DEL, c->fd, NULL);
+    conn_free(c);
+}
+
+static void conn_wait(Worker *w, Conn *c, uint32_t events) {
+    struct epoll_event ev = { .events = events, .data.ptr = c };
+    (void)epoll_ctl(w->efd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+static void conn_process(Worker *w, Conn *c);
+
+static void conn_on_sent(Worker *w, Conn *c);
+
+// Drena a fila de saída; se o socket encher, passa a esperar EPOLLOUT.
+static void conn_on_writable(Worker *w, Conn *c) {
+    if (w->uring) { uring_send(w, c); return; }
+    int r = conn_flush(c);
+    if (r < 0) { conn_close(w, c); return; }
+    if (r == 0) {
+        if (!c->want_out) { conn_wait(w, c, EPOLLOUT); c->want_out = true; }
+        return;
+    }
+    conn_on_sent(w, c);
+}
+
+// Resposta completa: fecha ou volta a ler (keep-alive). Cliente que já
+// encerrou o envio ainda recebe as respostas dos requests que ficaram no
+// buffer além do lote (PIPELINE_MAX); conn_process fecha quando acabarem.
+static void conn_on_sent(Worker *w, Conn *c) {
+    if (c->queued_at) {
+        stats_record(STATS_SEND, stats_now() - c->queued_at);
+        c->queued_at = 0;
+    }
+    if (!c->keep_alive || (c->peer_closed && c->in_len == 0)) { conn_close(w, c); return; }
+    c->state = CONN_READING;
+    if (c->want_out) { conn_wait(w, c, EPOLLIN | EPOLLRDHUP); c->want_out = false; }
+    // Parte do próximo request já chegou: o prazo do cabeçalho corre
+    if (c->in_len > 0) deadline_header(w, c);
+    else deadline_set(w, c, DEADLINE_IDLE, w->cfg->keepalive_timeout);
+
+    // Requests em pipeline que já chegaram são atendidos sem esperar o epoll
+    conn_process(w, c);
+}
+
+// Copia `v` truncado em `cap` (com terminador).
+static void view_copy(char *dst, size_t cap, const char *p, size_t len) {
+    if (len >= cap) len = cap - 1;
+    memcpy(dst, p, len);
+    dst[len] = '\0';
+}
+
+// Registro do log de acesso para a resposta enfileirada depois de `m`. O
+// request pode ser NULL (recusado pelo parser). Só cópias: formatar e gravar
+// é com a thread do log.
+static void log_request(Worker *w, Conn *c, const HttpRequest *r, ConnMark m, int status) {
+    LogRecord *rec = accesslog_begin(w->log);
+    if (!rec) return;
+    clock_gettime(CLOCK_REALTIME_COARSE, &rec->when);
+    rec->status = status;
+    rec->bytes = conn_out_size(c, m);
+    memcpy(rec->peer, c->peer, sizeof(rec->peer));
+    rec->method[0] = rec->target[0] = rec->version[0] = '\0';
+    rec->referer[0] = rec->agent[0] = '\0';
+    if (r) {
+        view_copy(rec->method, sizeof(rec->method), r->method.p, r->method.len);
+        view_copy(rec->target, sizeof(rec->target), r->target.p, r->target.len);
+        view_copy(rec->version, sizeof(rec->version), r->version.p, r->version.len);
+        size_t len;
+        const char *v = util_find_header(r, "Referer", &len);
+        if (v) view_copy(rec->referer, sizeof(rec->referer), v, len);
+        v = util_find_header(r, "User-Agent", &len);
+        if (v) view_copy(rec->agent, sizeof(rec->agent), v, len);
+    }
+    accesslog_commit(w->log);
+}
+
+// Métricas e log de acesso da resposta que acabou de ser enfileirada.
+static void account_response(Worker *w, Conn *c, const HttpRequest *r, ConnMark m) {
+    int status = conn_out_status(c, m);
+    if (!status) return;
+    stats_count_status(status);
+    if (w->log) log_request(w, c, r, m, status);
+}
+
+// Atende todos os requests completos no buffer (pipelining), na ordem de
+// chegada; as respostas vão para a mesma fila de saída, em ordem. Com
+// --stats, cada request mede o parser e a resolução; o envio é medido da
+// primeira resposta enfileirada até a fila esvaziar (conn_on_sent).
+static void conn_process(Worker *w, Conn *c) {
+    bool timing = stats_enabled();
+    uint64_t now = 0;
+    int batch = 0;
+    while (c->state == CONN_READING && !conn_streaming(c) && batch < PIPELINE_MAX) {
+        // O parser continua de onde parou na leitura anterior
+        // No pipeline, o fim do request anterior serve de início deste
+        uint64_t t0 = timing ? (now ? now : stats_now()) : 0;
+        ReqStatus st = req_parse(&c->rq, c->in, c->in_len, &w->limits);
+        if (timing) {
+            now = stats_now();
+            c->parse_ns += now - t0;
+        }
+        ConnMark m = conn_out_mark(c);
+        if (st == REQ_AGAIN) {
+            if (!c->peer_closed) break;
+            // Cliente encerrou no meio de um request: sem conserto
+            c->keep_alive = false;
+            if (c->in_len > 0) util_send_400(c);
+            account_response(w, c, NULL, m);
+            break;
+        }
+        if (st != REQ_DONE) {
+            c->keep_alive = false;
+            if (st == REQ_URI_TOO_LONG)        util_send_414(c);
+            else if (st == REQ_HEAD_TOO_LARGE) util_send_431(c);
+            else if (st == REQ_BAD_VERSION)    util_send_505(c);
+            else                               util_send_400(c);
+            account_response(w, c, NULL, m);
+            break;
+        }
+
+        // Atende e descarta o request do buffer
+        size_t req_len = c->rq.head_len;
+        c->req = &c->rq;
+        handle_client(w, c);
+        account_response(w, c, c->req, m);
+        c->req = NULL;
+        if (timing) {
+            uint64_t t2 = stats_now();
+            stats_record(STATS_PARSE, c->parse_ns);
+            stats_record(STATS_RESOLVE, t2 - now);
+            if (!c->queued_at) c->queued_at = t2;
+            now = t2;
+        }
+        c->parse_ns = 0;
+
+        memmove(c->in, c->in + req_len, c->in_len - req_len);
+        c->in_len -= req_len;
+        c->in[c->in_len] = '\0';
+        req_reset(&c->rq);
+        c->requests++;
+        batch++;
+        if (!c->keep_alive) break;
+    }
+
+    if (c->state == CONN_CLOSING) { conn_close(w, c); return; }
+    if (!conn_out_pending(c)) {
+        if (c->peer_closed) conn_close(w, c);
+        return;
+    }
+
+    c->state = CONN_WRITING;
+    deadline_send(w, c);
+    if (timing && !c->queued_at) c->queued_at = now;
+    conn_on_writable(w, c);
+}
+
+// Bytes novos em c->in (ou fim da entrada): atende o que ficou completo.
+static void conn_on_input(Worker *w, Conn *c) {
+    if (c->deadline == DEADLINE_IDLE && c->in_len > 0) deadline_header(w, c);
+    conn_process(w, c);
+}
+
+// Lê o que houver no socket e atende os requests que ficarem completos.
+static void conn_on_readable(Worker *w, Conn *c) {
+    for (;;) {
+        size_t room = CONN_RECV_BUF - c->in_len;
+        if (room == 0) break;
+        ssize_t n = recv(c->fd, c->in + c->in_len, room, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0) { conn_close(w, c); return; }
+        if (n == 0) { c->peer_closed = true; break; }
+
+        c->in_len += (size_t)n;
+        c->in[c->in_len] = '\0';
+    }
+    conn_on_input(w, c);
+}
+
+// Prazo vencido: fecha a conexão. No envio, ela ganha outra janela se o
+// cliente consumiu o mínimo; se não, sai com RST (SO_LINGER 0), já que um
+// close() normal deixaria o kernel entregando o que está no buffer do socket
+// no ritmo do cliente lento.
+static void on_deadline(Timer *t, void *arg) {
+    Worker *w = (Worker *)arg;
+    Conn *c = (Conn *)((char *)t - offsetof(Conn, timer));
+    if (c->deadline == DEADLINE_SEND) {
+        uint64_t sent = c->bytes_out - c->bytes_mark;
+        if (sent > 0 && sent >= (uint64_t)w->cfg->min_send_rate * (uint64_t)w->cfg->send_timeout) {
+            deadline_send(w, c);
+            return;
+        }
+        struct linger lg = { .l_onoff = 1, .l_linger = 0 };
+        (void)setsockopt(c->fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    }
+    conn_close(w, c);
+}
+
+static void deadlines_advance(Worker *w) {
+    timer_advance(&w->timers, (uint64_t)now_ms() / TICK_MS, on_deadline, w);
+}
+
+// Endereço do cliente em texto, para o log de acesso. Clientes IPv4 no
+// socket dual-stack chegam como ::ffff:a.b.c.d e saem como a.b.c.d.
+static void conn_set_peer(Conn *c, const struct sockaddr_storage *ss) {
+    int family = ss->ss_family;
+    const void *a = &((const struct sockaddr_in *)ss)->sin_addr;
+    if (family == AF_INET6) {
+        const struct in6_addr *a6 = &((const struct sockaddr_in6 *)ss)->sin6_addr;
+        if (IN6_IS_ADDR_V4MAPPED(a6)) { family = AF_INET; a = &a6->s6_addr[12]; }
+        else a = a6;
+    }
+    if (!inet_ntop(family, a, c->peer, sizeof(c->peer))) c->peer[0] = '\0';
+}
+
+// Aceita todas as conexões pendentes (o socket de escuta é não bloqueante):
+// uma acordada do epoll drena a fila inteira, um accept4 por conexão, já
+// não bloqueante e com CLOEXEC. TCP_NODELAY vem herdado do socket de escuta.
+static void accept_all(Worker *w) {
+    for (;;) {
+        struct sockaddr_storage ss;
+        socklen_t sl = sizeof(ss);
+        int cfd = accept4(w->sfd, w->log ? (struct sockaddr *)&ss : NULL, w->log ? &sl : NULL,
+                          SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (cfd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept");
+            return;
+        }
+
+        Conn *c = conn_new(cfd);
+        if (!c) { close(cfd); continue; }
+        if (w->log) conn_set_peer(c, &ss);
+
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = c };
+        if (epoll_ctl(w->efd, EPOLL_CTL_ADD, cfd, &ev) < 0) {
+            perror("epoll_ctl");
+            conn_free(c);
+            continue;
+        }
+        deadline_header(w, c);
+        // Com TCP_DEFER_ACCEPT a conexão só sai da fila quando o request já
+        // chegou: lê agora em vez de esperar outra volta do epoll
+        if (w->cfg->defer_accept > 0) conn_on_readable(w, c);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Backend io_uring (--io=uring)
+//
+// Mesmo atendimento (conn_process/handle_client), outro transporte: aceitação
+// multishot no socket de escuta, recepção com buffers fornecidos pelo anel,
+// sendmsg com iovecs para a memória e pares splice arquivo->pipe->socket
+// encadeados (IOSQE_IO_LINK) para arquivos. Cada volta do laço submete numa
+// só io_uring_enter as operações de todas as conexões e colhe as conclusões.
+// Os sockets aceitos são não bloqueantes, como no epoll: recv e sendmsg
+// concluem na hora ou esperam por poll interno do anel, sem ocupar threads
+// do io-wq. O splice não tem essa espera: com o socket cheio ele volta com
+// -EAGAIN e a drenagem é refeita atrás de um POLL_ADD(POLLOUT) encadeado.
+//
+// Uma conexão só é liberada quando não há operação sua em voo: fechar faz
+// shutdown() (o que conclui recv/send pendentes) e espera os CQEs.
+// -----------------------------------------------------------------------------
+
+#define URING_ENTRIES  1024
+#define URING_BUFS     512              // buffers de recepção por worker (potência de 2)
+#define URING_BUF_SIZE 4096
+#define URING_IOV      16               // segmentos de memória por sendmsg
+#define URING_SPLICE   (64 * 1024)      // capacidade padrão de um pipe
+
+enum { OP_ACCEPT = 1, OP_TICK, OP_RECV, OP_SEND, OP_FILL, OP_DRAIN, OP_WAIT };
+
+// Estado de uma conexão no backend (Conn.io).
+typedef struct {
+    struct iovec  iov[URING_IOV];
+    struct msghdr mh;
+    unsigned      inflight;    // operações submetidas ainda sem CQE
+    unsigned      sending;     // dessas, as de envio
+    bool          recv_armed;
+    bool          send_failed; // algum splice do par falhou
+    bool          drain_wait;  // último splice para o socket deu -EAGAIN
+    bool          busy;        // tratando um CQE desta conexão
+    bool          closing;     // fechada: libera quando inflight chegar a 0
+} UConn;
+
+static __thread Pool g_uconn_pool = POOL_INIT(UConn, 64);
+
+static void uconn_free(void *u) {
+    pool_put(&g_uconn_pool, u);
+}
+
+static struct io_uring_sqe *uring_get(Worker *w, Conn *c, unsigned op) {
+    struct io_uring_sqe *sqe = uring_sqe(&w->ring);
+    if (!sqe) return NULL;
+    sqe->user_data = uring_tag(c, op);
+    ((UConn *)c->io)->inflight++;
+    return sqe;
+}
+
+static void uring_close(Worker *w, Conn *c) {
+    UConn *u = (UConn *)c->io;
+    c->state = CONN_CLOSING;
+    if (!u->closing) {
+        u->closing = true;
+        (void)shutdown(c->fd, SHUT_RDWR);
+    }
+    if (!u->inflight && !u->busy) conn_free(c);
+    (void)w;
+}
+
+static void uring_arm_recv(Worker *w, Conn *c) {
+    UConn *u = (UConn *)c->io;
+    size_t room = CONN_RECV_BUF - c->in_len;
+    if (u->recv_armed || c->state != CONN_READING || c->peer_closed || room == 0) return;
+
+    struct io_uring_sqe *sqe = uring_get(w, c, OP_RECV);
+    if (!sqe) { conn_close(w, c); return; }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = c->fd;
+    sqe->len = (unsigned)(room < URING_BUF_SIZE ? room : URING_BUF_SIZE);
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = w->bufs.bgid;
+    u->recv_armed = true;
+}
+
+// Par encadeado arquivo -> pipe -> socket; se o pipe já tem bytes (um
+// splice anterior saiu curto), só o segundo.
+static void uring_splice(Worker *w, Conn *c, bool more) {
+    UConn *u = (UConn *)c->io;
+    Seg *s = c->out_head;
+    if (!conn_pipe(c) || !uring_reserve(&w->ring, 2)) { conn_close(w, c); return; }
+
+    size_t len = c->pipe_len;
+    if (len == 0) {
+        conn_file_advise(s);
+        off_t left = s->fend - s->foff;
+        len = left > URING_SPLICE ? URING_SPLICE : (size_t)left;
+        struct io_uring_sqe *in = uring_get(w, c, OP_FILL);
+        in->opcode = IORING_OP_SPLICE;
+        in->splice_fd_in = s->ffd;
+        in->splice_off_in = (uint64_t)s->foff;
+        in->fd = c->pipe_fd[1];
+        in->off = (uint64_t)-1;
+        in->len = (unsigned)len;
+        in->splice_flags = SPLICE_F_MOVE;
+        in->flags = IOSQE_IO_LINK;
+        u->sending++;
+        more = more || s->foff + (off_t)len < s->fend;
+    } else {
+        more = more || s->foff < s->fend;
+        if (u->drain_wait) {
+            struct io_uring_sqe *p = uring_get(w, c, OP_WAIT);
+            p->opcode = IORING_OP_POLL_ADD;
+            p->fd = c->fd;
+            p->poll32_events = POLLOUT;
+            p->flags = IOSQE_IO_LINK;
+            u->sending++;
+        }
+    }
+
+    struct io_uring_sqe *out = uring_get(w, c, OP_DRAIN);
+    out->opcode = IORING_OP_SPLICE;
+    out->splice_fd_in = c->pipe_fd[0];
+    out->splice_off_in = (uint64_t)-1;
+    out->fd = c->fd;
+    out->off = (uint64_t)-1;
+    out->len = (unsigned)len;
+    out->splice_flags = SPLICE_F_MOVE | (more ? SPLICE_F_MORE : 0);
+    u->sending++;
+}
+
+// Equivalente assíncrono de conn_flush: submete o próximo passo da fila.
+static void uring_send(Worker *w, Conn *c) {
+    UConn *u = (UConn *)c->io;
+    if (u->sending || u->closing) return;
+
+    int n = 0;
+    bool more = false;
+    switch (conn_out_next(c, u->iov, URING_IOV, &n, &more)) {
+    case CONN_OUT_ERROR:
+        conn_close(w, c);
+        return;
+    case CONN_OUT_DONE:
+        conn_on_sent(w, c);
+        return;
+    case CONN_OUT_FILE:
+        uring_splice(w, c, more);
+        return;
+    case CONN_OUT_MEM: {
+        struct io_uring_sqe *sqe = uring_get(w, c, OP_SEND);
+        if (!sqe) { conn_close(w, c); return; }
+        u->mh.msg_iov = u->iov;
+        u->mh.msg_iovlen = (size_t)n;
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = c->fd;
+        sqe->addr = (uint64_t)(uintptr_t)&u->mh;
+        sqe->len = 1;
+        sqe->msg_flags = MSG_NOSIGNAL | (more ? MSG_MORE : 0);
+        u->sending = 1;
+        return;
+    }
+    }
+}
+
+static void uring_arm_accept(Worker *w) {
+    struct io_uring_sqe *sqe = uring_sqe(&w->ring);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = w->sfd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = uring_tag(w, OP_ACCEPT);
+}
+
+static void uring_arm_tick(Worker *w) {
+    struct io_uring_sqe *sqe = uring_sqe(&w->ring);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr = (uint64_t)(uintptr_t)&w->tick;
+    sqe->len = 1;
+    sqe->user_data = uring_tag(w, OP_TICK);
+}
+
+static void uring_on_accept(Worker *w, int res, unsigned flags) {
+    if (res >= 0) {
+        Conn *c = conn_new(res);
+        UConn *u = c ? (UConn *)pool_get(&g_uconn_pool) : NULL;
+        if (!u) {
+            if (c) conn_free(c); else close(res);
         } else {
-            util_send_404(cfd);
+            c->io = u;
+            c->io_free = uconn_free;
+            if (w->log) {
+                // O accept multishot não devolve o endereço
+                struct sockaddr_storage ss;
+                socklen_t sl = sizeof(ss);
+                if (getpeername(res, (struct sockaddr *)&ss, &sl) == 0) conn_set_peer(c, &ss);
+            }
+            deadline_header(w, c);
+            uring_arm_recv(w, c);
+        }
+    } else if (res != -EINTR && res != -EAGAIN && res != -ECONNABORTED) {
+        fprintf(stderr, "accept (io_uring): %s\n", strerror(-res));
+    }
+    if (!(flags & IORING_CQE_F_MORE)) uring_arm_accept(w);   // multishot encerrado
+}
+
+static void uring_on_recv(Worker *w, Conn *c, int res, unsigned flags) {
+    UConn *u = (UConn *)c->io;
+    u->recv_armed = false;
+    if (flags & IORING_CQE_F_BUFFER) {
+        unsigned bid = flags >> IORING_CQE_BUFFER_SHIFT;
+        if (res > 0 && !u->closing) {
+            // res <= sqe->len <= espaço livre em c->in
+            memcpy(c->in + c->in_len, uring_buf(&w->bufs, bid), (size_t)res);
+            c->in_len += (size_t)res;
+            c->in[c->in_len] = '\0';
         }
-        close(cfd);
+        uring_buf_recycle(&w->bufs, bid);
+    }
+    if (u->closing) return;
+
+    if (res > 0) {
+        conn_on_input(w, c);
+    } else if (res == 0) {
+        c->peer_closed = true;
+        conn_on_input(w, c);
+    } else if (res != -ENOBUFS && res != -EINTR && res != -EAGAIN) {
+        conn_close(w, c);
+    }
+    // -ENOBUFS: todos os buffers em uso neste instante; rearma em seguida
+}
+
+static void uring_on_conn(Worker *w, Conn *c, unsigned op, int res, unsigned flags) {
+    UConn *u = (UConn *)c->io;
+    u->inflight--;
+    u->busy = true;
+
+    switch (op) {
+    case OP_RECV:
+        uring_on_recv(w, c, res, flags);
+        break;
+    case OP_SEND:
+        u->sending = 0;
+        if (res < 0) { conn_close(w, c); break; }
+        conn_out_advance(c, (size_t)res);
+        uring_send(w, c);
+        break;
+    case OP_FILL:
+    case OP_DRAIN:
+    case OP_WAIT:
+        u->sending--;
+        if (op == OP_WAIT) {
+            if (res < 0 && res != -ECANCELED) u->send_failed = true;
+        } else if (res > 0 && op == OP_FILL) {
+            c->out_head->foff += res;
+            c->pipe_len += (size_t)res;
+        } else if (res > 0) {
+            c->pipe_len -= (size_t)res;
+            c->bytes_out += (size_t)res;
+            stats_count_bytes((size_t)res);
+            u->drain_wait = false;
+        } else if (res == -EAGAIN && op == OP_DRAIN) {
+            u->drain_wait = true;    // socket cheio: espera POLLOUT e refaz
+        } else if (res != -ECANCELED) {
+            u->send_failed = true;   // erro, ou arquivo encolheu (0)
+        }
+        if (u->sending) break;
+        if (u->send_failed) { conn_close(w, c); break; }
+        uring_send(w, c);
+        break;
+    }
+
+    u->busy = false;
+    if (u->closing) {
+        if (!u->inflight) conn_free(c);
         return;
     }
+    uring_arm_recv(w, c);
+}
 
-    // Responde: arquivo (com MIME) ou diretório (index.html / listagem HTML)
-    fs_serve_path(cfd, url, fs_path);
+// Laço do worker sobre io_uring. false se o anel não pôde ser montado nesta
+// thread (o chamador segue com epoll).
+static bool uring_loop(Worker *w) {
+    if (!uring_init(&w->ring, URING_ENTRIES)) return false;
+    if (!uring_bufs_init(&w->ring, &w->bufs, 0, URING_BUFS, URING_BUF_SIZE)) {
+        uring_exit(&w->ring);
+        return false;
+    }
+
+    w->tick.tv_sec = TICK_MS / 1000;
+    w->tick.tv_nsec = (long long)(TICK_MS % 1000) * 1000000;
+    uring_arm_accept(w);
+    uring_arm_tick(w);
 
-    // Encerra a conexão (Connection: close)
-    close(cfd);
+    for (;;) {
+        int r = uring_submit(&w->ring, 1);
+        if (r < 0 && r != -EINTR && r != -EBUSY && r != -EAGAIN) {
+            fprintf(stderr, "io_uring_enter: %s\n", strerror(-r));
+            return true;
+        }
+
+        struct io_uring_cqe *cqe;
+        while ((cqe = uring_cqe(&w->ring)) != NULL) {
+            struct io_uring_cqe e = *cqe;
+            uring_cqe_seen(&w->ring);
+
+            unsigned op = uring_tag_op(e.user_data);
+            if (op == OP_ACCEPT) {
+                uring_on_accept(w, e.res, e.flags);
+            } else if (op == OP_TICK) {
+                deadlines_advance(w);
+                uring_arm_tick(w);
+            } else {
+                uring_on_conn(w, (Conn *)uring_tag_ptr(e.user_data), op, e.res, e.flags);
+            }
+        }
+
+        if (w->id == 0 && g_report) {
+            g_report = 0;
+            print_report();
+        }
+    }
 }
 
-// Sobe o servidor: cria socket TCP, bind/listen e atende no loop principal.
-int http_run(const char *root, int port) {
-    // 1) Cria o socket TCP/IPv4
-    int sfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sfd < 0) { perror("socket"); return 1; }
+// Laço principal do worker: despacha eventos para aceitar, ler ou escrever.
+static void *worker_main(void *arg) {
+    Worker *w = (Worker *)arg;
+    stats_register();
+
+    if (w->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(w->cpu, &set);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err) fprintf(stderr, "worker %d: afinidade com CPU %d falhou: %s\n",
+                         w->id, w->cpu, strerror(err));
+    }
+
+    // O anel é criado aqui: com SINGLE_ISSUER ele pertence à thread que o cria
+    if (w->uring) {
+        if (uring_loop(w)) return NULL;
+        fprintf(stderr, "worker %d: io_uring indisponível; usando epoll\n", w->id);
+        w->uring = false;
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    while (1) {
+        int n = epoll_wait(w->efd, events, MAX_EVENTS, TICK_MS);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == &g_listen_tag) {
+                accept_all(w);
+                continue;
+            }
 
-    // 2) Permite reusar a porta rapidamente após reiniciar o servidor
+            Conn *c = (Conn *)events[i].data.ptr;
+            uint32_t e = events[i].events;
+            if (e & (EPOLLERR | EPOLLHUP)) { conn_close(w, c); continue; }
+
+            if (c->state == CONN_READING && (e & (EPOLLIN | EPOLLRDHUP)))
+                conn_on_readable(w, c);
+            else if (c->state == CONN_WRITING && (e & EPOLLOUT))
+                conn_on_writable(w, c);
+        }
+
+        deadlines_advance(w);
+        if (w->id == 0 && g_report) {
+            g_report = 0;
+            print_report();
+        }
+    }
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Sockets de escuta e workers
+// -----------------------------------------------------------------------------
+
+// true se os sockets de escuta são IPv6 dual-stack (false: só IPv4).
+static bool g_listen_v6;
+
+// Cria um socket de escuta em [::]:<port> (IPv6 e IPv4 no mesmo socket) ou,
+// se o kernel não tiver IPv6, em 0.0.0.0:<port>. Com SO_REUSEPORT, cada
+// worker abre o seu na mesma porta e o kernel espalha as conexões entre eles.
+static int open_listener(const HttpConfig *cfg) {
+    // 1) Cria o socket TCP (não bloqueante: quem espera é o epoll)
+    int sfd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    g_listen_v6 = sfd >= 0;
+    if (sfd < 0 && errno == EAFNOSUPPORT)
+        sfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sfd < 0) { perror("socket"); return -1; }
+
+    // 2) Permite reusar a porta rapidamente e compartilhá-la entre workers
     int yes = 1;
     (void)setsockopt(sfd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    if (setsockopt(sfd, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes)) < 0) {
+        perror("setsockopt(SO_REUSEPORT)"); close(sfd); return -1;
+    }
 
-    // 3) Endereço de escuta: 0.0.0.0:<port>
-    struct sockaddr_in addr;
-    memset(&addr, 0, sizeof(addr));
-    addr.sin_family      = AF_INET;
-    addr.sin_addr.s_addr = htonl(INADDR_ANY);
-    addr.sin_port        = htons((uint16_t)port);
+    // 3) Opções herdadas pelas conexões aceitas ou aplicadas à fila:
+    //    - TCP_NODELAY: as respostas já saem agrupadas (sendmsg com iovecs,
+    //      MSG_MORE antes de arquivos, TCP_CORK no multipart), então o Nagle
+    //      só atrasaria o último segmento; herdado por cada accept.
+    //    - TCP_DEFER_ACCEPT: a conexão só fica pronta quando chegam dados.
+    //    - TCP_FASTOPEN: o request pode vir no próprio SYN (cookie TFO).
+    (void)setsockopt(sfd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    if (cfg->defer_accept > 0 &&
+        setsockopt(sfd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &cfg->defer_accept, sizeof(int)) < 0)
+        perror("setsockopt(TCP_DEFER_ACCEPT)");
+    if (cfg->fastopen > 0 &&
+        setsockopt(sfd, IPPROTO_TCP, TCP_FASTOPEN, &cfg->fastopen, sizeof(int)) < 0)
+        perror("setsockopt(TCP_FASTOPEN)");
 
-    if (bind(sfd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
-        perror("bind"); close(sfd); return 1;
+    // 4) Endereço de escuta: [::]:<port> aceitando IPv4 mapeado, ou 0.0.0.0
+    struct sockaddr_storage ss;
+    socklen_t sl;
+    memset(&ss, 0, sizeof(ss));
+    if (g_listen_v6) {
+        int no = 0;
+        (void)setsockopt(sfd, IPPROTO_IPV6, IPV6_V6ONLY, &no, sizeof(no));
+        struct sockaddr_in6 *a6 = (struct sockaddr_in6 *)&ss;
+        a6->sin6_family = AF_INET6;
+        a6->sin6_addr   = in6addr_any;
+        a6->sin6_port   = htons((uint16_t)cfg->port);
+        sl = sizeof(*a6);
+    } else {
+        struct sockaddr_in *a4 = (struct sockaddr_in *)&ss;
+        a4->sin_family      = AF_INET;
+        a4->sin_addr.s_addr = htonl(INADDR_ANY);
+        a4->sin_port        = htons((uint16_t)cfg->port);
+        sl = sizeof(*a4);
     }
-    if (listen(sfd, BACKLOG) < 0) {
-        perror("listen"); close(sfd); return 1;
+
+    if (bind(sfd, (struct sockaddr *)&ss, sl) < 0) {
+        perror("bind"); close(sfd); return -1;
     }
+    // O kernel limita a fila a net.core.somaxconn
+    if (listen(sfd, cfg->backlog) < 0) {
+        perror("listen"); close(sfd); return -1;
+    }
+    return sfd;
+}
+
+// Prepara socket de escuta + epoll de um worker.
+static bool worker_init(Worker *w) {
+    w->sfd = open_listener(w->cfg);
+    if (w->sfd < 0) return false;
 
-    // 4) Resolve a raiz do site para caminho absoluto (ex.: "./files" -> "/abs/.../files")
-    char root_real[PATH_MAX];
-    if (!realpath(root, root_real)) {
-        perror("realpath"); close(sfd); return 1;
+    w->efd = epoll_create1(EPOLL_CLOEXEC);
+    if (w->efd < 0) { perror("epoll_create1"); close(w->sfd); return false; }
+
+    struct epoll_event lev = { .events = EPOLLIN, .data.ptr = &g_listen_tag };
+    if (epoll_ctl(w->efd, EPOLL_CTL_ADD, w->sfd, &lev) < 0) {
+        perror("epoll_ctl"); close(w->efd); close(w->sfd); return false;
     }
+    return true;
+}
 
-    printf("Servidor ouvindo em http://0.0.0.0:%d\n", port);
-    printf("Servindo diretório: %s\n", root_real);
+// N-ésima CPU permitida ao processo (respeita taskset/cgroups), em rodízio.
+static int pick_cpu(int n) {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return -1;
+    int count = CPU_COUNT(&set);
+    if (count <= 0) return -1;
+    n %= count;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set) && n-- == 0) return cpu;
+    }
+    return -1;
+}
 
-    // 5) Loop principal: aceita conexões e delega para handle_client
-    while (1) {
-        struct sockaddr_in cli;
-        socklen_t clilen = sizeof(cli);
-        int cfd = accept(sfd, (struct sockaddr *)&cli, &clilen);
-        if (cfd < 0) { perror("accept"); continue; }
-        handle_client(cfd, root_real);
+// Sobe o servidor: um socket de escuta + laço epoll por worker.
+int http_run(const HttpConfig *cfg) {
+    // Escrever num cliente que já fechou não deve derrubar o processo
+    signal(SIGPIPE, SIG_IGN);
+    conn_set_zero_copy(!cfg->no_sendfile);
+    conn_set_mmap(cfg->use_mmap);
+    conn_set_file_hints((size_t)cfg->readahead_kb * 1024, (off_t)cfg->drop_behind_mb << 20);
+    cache_set_hugepages(cfg->use_mmap);
+    scan_init();
+    signal(SIGUSR1, on_sigusr1);
+
+    // Resolve a raiz do site para caminho absoluto (ex.: "./files" -> "/abs/.../files").
+    // Com --bundle não há raiz: os caminhos ficam "/" + relativo, a chave do pacote,
+    // e nem o cache nem as listagens (que observam diretórios) são ligados.
+    static char root_real[PATH_MAX];
+    if (cfg->bundle) {
+        if (!bundle_open(cfg->bundle)) return 1;
+    } else {
+        if (!realpath(cfg->root, root_real)) {
+            perror("realpath"); return 1;
+        }
+        if (!fs_init(root_real)) {
+            perror("open(raiz)"); return 1;
+        }
+
+        if (!cache_init((size_t)cfg->cache_mb << 20)) {
+            fprintf(stderr, "cache: não foi possível iniciar; seguindo sem cache\n");
+        }
+        listing_init();
+    }
+
+    // A tabela é reconstruída antes dos workers existirem: depois disso só há leituras
+    if (cfg->mime_types) {
+        int n = mime_load(cfg->mime_types);
+        if (n < 0) {
+            fprintf(stderr, "mime: não foi possível carregar %s\n", cfg->mime_types);
+            return 1;
+        }
+        printf("MIME: %d extensões de %s (%zu no total)\n", n, cfg->mime_types, mime_count());
+    }
+
+    int nworkers = cfg->workers;
+    if (nworkers <= 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        nworkers = (ncpu > 0) ? (int)ncpu : 1;
+    }
+
+    Worker *workers = (Worker *)calloc((size_t)nworkers, sizeof(*workers));
+    if (!workers) { perror("calloc"); return 1; }
+
+    // Um anel de log por worker, com a thread de escrita já rodando
+    if (cfg->access_log) {
+        LogFormat fmt = LOG_COMBINED;
+        if (cfg->log_format && !accesslog_parse_format(cfg->log_format, &fmt)) {
+            fprintf(stderr, "Formato de log desconhecido: %s (common, combined ou json)\n",
+                    cfg->log_format);
+            return 1;
+        }
+        if (!accesslog_init(cfg->access_log, fmt, nworkers)) {
+            perror(cfg->access_log);
+            return 1;
+        }
+    }
+
+    // io_uring: confere antes o que o backend usa; sem isso, epoll
+    bool use_uring = cfg->io_uring;
+    const char *why = NULL;
+    if (use_uring && !uring_supported(&why)) {
+        fprintf(stderr, "io_uring indisponível (%s); usando epoll\n", why);
+        use_uring = false;
+    }
+
+    // O buffer de entrada e o vetor de cabeçalhos têm tamanho fixo
+    ReqLimits limits = {
+        .max_uri     = (size_t)(cfg->max_uri > 0 && cfg->max_uri < PATH_MAX ? cfg->max_uri : PATH_MAX - 1),
+        .max_headers = (size_t)(cfg->max_headers > 0 && cfg->max_headers < REQ_MAX_HEADERS
+                                ? cfg->max_headers : REQ_MAX_HEADERS),
+        .max_head    = (size_t)(cfg->max_header_bytes > 0 && cfg->max_header_bytes < CONN_RECV_BUF
+                                ? cfg->max_header_bytes : CONN_RECV_BUF),
+    };
+
+    // Todos os sockets são abertos antes de servir: erro de bind aparece já
+    for (int i = 0; i < nworkers; i++) {
+        Worker *w = &workers[i];
+        w->id = i;
+        w->cpu = cfg->pin_cpus ? pick_cpu(i) : -1;
+        w->root_real = root_real;
+        w->cfg = cfg;
+        w->limits = limits;
+        w->uring = use_uring;
+        w->log = accesslog_ring(i);
+        timer_wheel_init(&w->timers, (uint64_t)now_ms() / TICK_MS);
+        if (!worker_init(w)) return 1;
+    }
+
+    printf("Servidor ouvindo em http://%s:%d\n", g_listen_v6 ? "[::]" : "0.0.0.0", cfg->port);
+    printf("Escuta: %s, backlog %d%s",
+           g_listen_v6 ? "IPv6 + IPv4 (dual-stack)" : "só IPv4", cfg->backlog,
+           cfg->fastopen > 0 ? ", TCP Fast Open" : "");
+    if (cfg->defer_accept > 0) printf(", accept adiado até %ds pelos dados", cfg->defer_accept);
+    printf("\n");
+    if (cfg->bundle)
+        printf("Servindo pacote: %s (%zu arquivos, mapeado em memória)\n", cfg->bundle, bundle_count());
+    else
+        printf("Servindo diretório: %s\n", root_real);
+    printf("Workers: %d%s\n", nworkers, cfg->pin_cpus ? " (fixados por CPU)" : "");
+    printf("Parser: busca de delimitadores %s\n", g_scan.name);
+    if (cfg->bundle)
+        printf("Caminhos: busca binária na tabela do pacote\n");
+    else
+        printf("Caminhos: %s sob a raiz\n",
+               fs_has_openat2() ? "openat2(RESOLVE_BENEATH)" : "openat com O_NOFOLLOW");
+    printf("E/S: %s\n", use_uring ? "io_uring (accept multishot, buffers fornecidos, splice encadeado)"
+                                   : "epoll");
+    if (use_uring)
+        printf("Envio de arquivos: splice arquivo->pipe->socket pelo anel%s\n",
+               cfg->use_mmap ? " (--mmap vale só para o cache)" : "");
+    else if (cfg->use_mmap)
+        printf("Envio de arquivos: mmap + MADV_HUGEPAGE, send() do mapeamento\n");
+    else
+        printf("Envio de arquivos: %s\n", cfg->no_sendfile ? "pread/send" : "sendfile (splice como fallback)");
+    printf("Page cache: readahead ");
+    if (cfg->readahead_kb > 0) printf("%d KB à frente", cfg->readahead_kb);
+    else                       printf("sequencial do kernel");
+    if (cfg->drop_behind_mb > 0) printf(", descarta o já enviado de trechos >= %d MB", cfg->drop_behind_mb);
+    printf("\n");
+    if (cache_enabled())
+        printf("Cache: %d MB (kill -USR1 %d para ver acertos/faltas)\n", cfg->cache_mb, (int)getpid());
+    if (cfg->stats_path) {
+        stats_enable();
+        printf("Métricas: http://0.0.0.0:%d%s (Prometheus; ?format=json para JSON)\n",
+               cfg->port, cfg->stats_path);
+    }
+    if (cfg->access_log)
+        printf("Log de acesso: %s (%s, gravado por thread própria)\n",
+               !strcmp(cfg->access_log, "-") ? "stdout" : cfg->access_log,
+               cfg->log_format ? cfg->log_format : "combined");
+    if (cfg->keepalive_timeout > 0 && cfg->max_requests > 0)
+        printf("Keep-alive: %ds ocioso, até %d requests por conexão\n",
+               cfg->keepalive_timeout, cfg->max_requests);
+    else if (cfg->keepalive_timeout > 0)
+        printf("Keep-alive: %ds ocioso, requests por conexão ilimitados\n",
+               cfg->keepalive_timeout);
+    printf("Prazos: cabeçalhos em %ds, envio de ao menos %d B/s a cada %ds\n",
+           cfg->header_timeout, cfg->min_send_rate, cfg->send_timeout);
+
+    // O worker 0 roda na thread principal; os demais em threads próprias
+    for (int i = 1; i < nworkers; i++) {
+        int err = pthread_create(&workers[i].th, NULL, worker_main, &workers[i]);
+        if (err) { fprintf(stderr, "pthread_create: %s\n", strerror(err)); return 1; }
     }
+    worker_main(&workers[0]);
 
-    // (em prática não chega aqui; se chegar, fecha o socket de escuta)
-    close(sfd);
-    return 0;
+    // (em prática não chega aqui)
+    return 1;
 }
\ No newline at end of file
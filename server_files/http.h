@@ -1,6 +1,37 @@
 #ifndef HTTP_H
 #define HTTP_H
+#include <stdbool.h>
 
-int http_run(const char *root, int port);
+// Opções de execução do servidor (preenchidas por server.c).
+typedef struct {
+    const char *root;       // document root
+    const char *bundle;             // pacote de tools/pack servido no lugar da raiz (NULL = raiz)
+    int         port;
+    int         backlog;            // fila de conexões pendentes (limitada por somaxconn)
+    int         defer_accept;       // TCP_DEFER_ACCEPT em segundos (0 = desligado)
+    int         fastopen;           // fila do TCP_FASTOPEN (0 = desligado)
+    int         workers;    // nº de workers (0 = nº de CPUs online)
+    bool        pin_cpus;   // fixa cada worker em uma CPU
+    int         keepalive_timeout;  // segundos ociosa antes de fechar (0 = sem keep-alive)
+    int         max_requests;       // requests por conexão (0 = ilimitado)
+    int         header_timeout;     // segundos para receber linha + cabeçalhos
+    int         send_timeout;       // janela (s) do ritmo mínimo de envio
+    int         min_send_rate;      // bytes/s mínimos por janela (0 = só exige progresso)
+    bool        no_sendfile;        // envia arquivos com pread/send (comparação)
+    bool        use_mmap;           // envia arquivos de janelas mmap e põe o cache em páginas grandes
+    int         readahead_kb;       // janela de WILLNEED à frente do envio (0 = padrão do kernel)
+    int         drop_behind_mb;     // trechos a partir daqui saem do page cache após o envio (0 = nunca)
+    int         cache_mb;           // orçamento do cache de arquivos em MB (0 = desligado)
+    int         max_uri;            // limites do parser de requests (ver request.h)
+    int         max_headers;
+    int         max_header_bytes;
+    const char *mime_types;         // mime.types extra fundido à tabela padrão (NULL = nenhum)
+    bool        io_uring;           // backend io_uring em vez de epoll (com recuo)
+    const char *stats_path;         // endpoint de métricas (NULL = desligado)
+    const char *access_log;         // arquivo do log de acesso ("-" = stdout, NULL = desligado)
+    const char *log_format;         // common, combined ou json (NULL = combined)
+} HttpConfig;
+
+int http_run(const HttpConfig *cfg);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,524 @@
+// Cache de listagens de diretório.
+//
+// Cada diretório listado vira um Dir com seus nomes (menos "." e "..") e os
+// corpos já serializados, por tipo (JSON/HTML) e codificação. O cache de
+// respostas repassa os eventos de inotify (cache_set_dir_listener): criar ou
+// renomear para dentro acrescenta o nome, apagar ou renomear para fora o
+// remove, e em ambos os casos os corpos prontos são descartados para serem
+// refeitos da memória no próximo acesso. Só a perda de eventos (overflow) ou
+// a remoção do próprio diretório obrigam a varrer de novo.
+//
+// Um mutex cobre tudo; a serialização, feita só após mudanças, acontece sob
+// ele. O envio usa o corpo fora do lock, segurando uma referência.
+
+#define _GNU_SOURCE
+#include "listing.h"
+#include "cache.h"
+#include "gzip.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/inotify.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define LISTING_BUCKETS   512
+#define LISTING_MAX_DIRS  256      // diretórios em memória (LRU)
+#define LISTING_MAX_NAMES 65536    // maiores que isso não entram no cache
+#define LISTING_GZIP_MIN  256      // abaixo disso gzip não compensa
+#define LISTING_BATCH     (64 * 1024)  // buffer de getdents64
+
+typedef struct Dir {
+    struct Dir  *hnext;
+    struct Dir  *lprev, *lnext;         // LRU (cabeça = mais recente)
+    char        *path;
+    uint64_t     hash;
+    char       **names;
+    size_t       nnames, capnames;
+    ListingBody *body[LISTING_KINDS][2];  // [tipo][gzip]
+    char        *html_url;              // prefixo usado em body[LISTING_HTML]
+} Dir;
+
+static struct {
+    bool            on;
+    pthread_mutex_t mu;
+    Dir            *buckets[LISTING_BUCKETS];
+    Dir            *lru_head, *lru_tail;
+    size_t          ndirs;
+    uint64_t        hits, misses, patches;  // atômicos
+} g_list = { .mu = PTHREAD_MUTEX_INITIALIZER };
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+// FNV-1a 64 bits.
+static uint64_t hash_path(const char *s) {
+    uint64_t h = 1469598103934665603ULL;
+    while (*s) { h ^= (unsigned char)*s++; h *= 1099511628211ULL; }
+    return h;
+}
+
+static ListingBody *body_new(const char *data, size_t len, bool gz) {
+    ListingBody *b = (ListingBody *)malloc(sizeof(*b) + len);
+    if (!b) return NULL;
+    b->refs = 1;
+    b->gzip = gz;
+    b->len = len;
+    memcpy(b->data, data, len);
+    return b;
+}
+
+void listing_release(void *body) {
+    ListingBody *b = (ListingBody *)body;
+    if (b && __atomic_sub_fetch(&b->refs, 1, __ATOMIC_ACQ_REL) == 0) free(b);
+}
+
+static void dir_drop_bodies(Dir *d) {
+    for (int k = 0; k < LISTING_KINDS; k++)
+        for (int z = 0; z < 2; z++) { listing_release(d->body[k][z]); d->body[k][z] = NULL; }
+    free(d->html_url);
+    d->html_url = NULL;
+}
+
+static void dir_free(Dir *d) {
+    if (!d) return;
+    dir_drop_bodies(d);
+    for (size_t i = 0; i < d->nnames; i++) free(d->names[i]);
+    free(d->names);
+    free(d->path);
+    free(d);
+}
+
+static bool dir_add_name(Dir *d, const char *name) {
+    if (d->nnames == d->capnames) {
+        size_t cap = d->capnames ? d->capnames * 2 : 64;
+        char **tmp = (char **)realloc(d->names, cap * sizeof(*tmp));
+        if (!tmp) return false;
+        d->names = tmp; d->capnames = cap;
+    }
+    if (!(d->names[d->nnames] = strdup(name))) return false;
+    d->nnames++;
+    return true;
+}
+
+static ssize_t dir_index_of(const Dir *d, const char *name) {
+    for (size_t i = 0; i < d->nnames; i++)
+        if (!strcmp(d->names[i], name)) return (ssize_t)i;
+    return -1;
+}
+
+static bool dir_has_index(const Dir *d) {
+    return dir_index_of(d, "index.html") >= 0;
+}
+
+// Varre o diretório aberto em `dfd` (sem lock). NULL se não der para ler.
+static Dir *dir_scan(const char *path, int dfd) {
+    int fd = dup(dfd);
+    DIR *dp = (fd >= 0) ? fdopendir(fd) : NULL;
+    if (!dp) { if (fd >= 0) close(fd); return NULL; }
+
+    Dir *d = (Dir *)calloc(1, sizeof(*d));
+    if (!d || !(d->path = strdup(path))) { free(d); closedir(dp); return NULL; }
+    d->hash = hash_path(path);
+
+    struct dirent *ent;
+    while ((ent = readdir(dp)) != NULL) {
+        if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, "..")) continue;
+        if (!dir_add_name(d, ent->d_name)) { dir_free(d); closedir(dp); return NULL; }
+    }
+    closedir(dp);
+    return d;
+}
+
+// -----------------------------------------------------------------------------
+// Serialização
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    char  *buf;
+    size_t len, cap;
+    bool   oom;
+} Out;
+
+static void out_reserve(Out *o, size_t n) {
+    if (o->oom || o->len + n + 1 <= o->cap) return;
+    size_t cap = o->cap ? o->cap * 2 : 4096;
+    while (cap < o->len + n + 1) cap *= 2;
+    char *tmp = (char *)realloc(o->buf, cap);
+    if (!tmp) { o->oom = true; return; }
+    o->buf = tmp; o->cap = cap;
+}
+
+static void out_str(Out *o, const char *s) {
+    size_t n = strlen(s);
+    out_reserve(o, n);
+    if (o->oom) return;
+    memcpy(o->buf + o->len, s, n + 1);
+    o->len += n;
+}
+
+size_t listing_json_escape(char *dst, const char *src) {
+    char *p = dst;
+    while (*src) {
+        unsigned char c = (unsigned char)*src++;
+        if (c == '\\' || c == '\"') *p++ = '\\';
+        *p++ = (char)c;
+    }
+    *p = '\0';
+    return (size_t)(p - dst);
+}
+
+static void out_json_str(Out *o, const char *s) {
+    out_reserve(o, strlen(s) * 2 + 2);
+    if (o->oom) return;
+    o->buf[o->len++] = '"';
+    o->len += listing_json_escape(o->buf + o->len, s);
+    o->buf[o->len++] = '"';
+    o->buf[o->len] = '\0';
+}
+
+// Lista sem "index.html" e sem ocultos.
+static void serialize_json(char *const *names, size_t n, Out *o) {
+    out_str(o, "[");
+    bool first = true;
+    for (size_t i = 0; i < n; i++) {
+        const char *name = names[i];
+        if (name[0] == '.' || !strcasecmp(name, "index.html")) continue;
+        if (!first) out_str(o, ",");
+        out_json_str(o, name);
+        first = false;
+    }
+    out_str(o, "]");
+}
+
+// Página HTML simples (ocultando index.html por coerência).
+static void serialize_html(char *const *names, size_t n, const char *url, Out *o) {
+    char line[PATH_MAX * 3];
+    snprintf(line, sizeof(line),
+             "<!doctype html><meta charset='utf-8'>"
+             "<title>Index of %s</title><h1>Index of %s</h1><ul>", url, url);
+    out_str(o, line);
+    for (size_t i = 0; i < n; i++) {
+        const char *name = names[i];
+        if (!strcasecmp(name, "index.html")) continue;
+        snprintf(line, sizeof(line), "<li><a href=\"/%s/%s\">%s</a></li>", url, name, name);
+        out_str(o, line);
+    }
+    out_str(o, "</ul>");
+}
+
+char *listing_serialize(char *const *names, size_t n, ListingKind kind, const char *url, size_t *len) {
+    Out o = {0};
+    if (kind == LISTING_JSON) serialize_json(names, n, &o);
+    else                      serialize_html(names, n, url, &o);
+    if (o.oom) { free(o.buf); return NULL; }
+    *len = o.len;
+    return o.buf;
+}
+
+// Corpo pronto de `d` (serializa se preciso), com uma referência extra.
+static ListingBody *dir_body(Dir *d, ListingKind kind, const char *url, bool want_gzip) {
+    if (kind == LISTING_HTML && (!d->html_url || strcmp(d->html_url, url))) {
+        // Outro prefixo de links: refaz a página
+        for (int z = 0; z < 2; z++) { listing_release(d->body[kind][z]); d->body[kind][z] = NULL; }
+        free(d->html_url);
+        d->html_url = strdup(url);
+        if (!d->html_url) return NULL;
+    }
+
+    ListingBody **plain = &d->body[kind][0];
+    if (!*plain) {
+        Out o = {0};
+        if (kind == LISTING_JSON) serialize_json(d->names, d->nnames, &o);
+        else                      serialize_html(d->names, d->nnames, url, &o);
+        if (!o.oom) *plain = body_new(o.buf ? o.buf : "", o.len, false);
+        free(o.buf);
+        if (!*plain) return NULL;
+    }
+
+    ListingBody *b = *plain;
+    if (want_gzip && b->len >= LISTING_GZIP_MIN) {
+        ListingBody **gz = &d->body[kind][1];
+        if (!*gz) {
+            size_t glen;
+            char *z = gzip_compress(b->data, b->len, &glen);
+            // Sem ganho: guarda o próprio corpo, para não tentar de novo
+            if (z && glen < b->len) *gz = body_new(z, glen, true);
+            else { *gz = b; __atomic_fetch_add(&b->refs, 1, __ATOMIC_RELAXED); }
+            free(z);
+        }
+        if (*gz) b = *gz;
+    }
+    __atomic_fetch_add(&b->refs, 1, __ATOMIC_RELAXED);
+    return b;
+}
+
+// -----------------------------------------------------------------------------
+// Tabela + LRU (lock segurado)
+// -----------------------------------------------------------------------------
+
+static Dir **bucket_of(uint64_t h) {
+    return &g_list.buckets[h & (LISTING_BUCKETS - 1)];
+}
+
+static Dir *lookup_locked(const char *path) {
+    uint64_t h = hash_path(path);
+    for (Dir *d = *bucket_of(h); d; d = d->hnext)
+        if (d->hash == h && !strcmp(d->path, path)) return d;
+    return NULL;
+}
+
+static void lru_unlink(Dir *d) {
+    if (d->lprev) d->lprev->lnext = d->lnext; else g_list.lru_head = d->lnext;
+    if (d->lnext) d->lnext->lprev = d->lprev; else g_list.lru_tail = d->lprev;
+    d->lprev = d->lnext = NULL;
+}
+
+static void lru_push_front(Dir *d) {
+    d->lprev = NULL;
+    d->lnext = g_list.lru_head;
+    if (g_list.lru_head) g_list.lru_head->lprev = d; else g_list.lru_tail = d;
+    g_list.lru_head = d;
+}
+
+static void remove_locked(Dir *d) {
+    Dir **pp = bucket_of(d->hash);
+    while (*pp && *pp != d) pp = &(*pp)->hnext;
+    if (*pp) *pp = d->hnext;
+    lru_unlink(d);
+    g_list.ndirs--;
+    dir_free(d);
+}
+
+static void insert_locked(Dir *d) {
+    while (g_list.ndirs >= LISTING_MAX_DIRS && g_list.lru_tail) remove_locked(g_list.lru_tail);
+    Dir **b = bucket_of(d->hash);
+    d->hnext = *b; *b = d;
+    lru_push_front(d);
+    g_list.ndirs++;
+}
+
+// -----------------------------------------------------------------------------
+// Eventos (thread do watcher)
+// -----------------------------------------------------------------------------
+
+static void on_dir_event(const char *dir, const char *name, uint32_t mask) {
+    pthread_mutex_lock(&g_list.mu);
+    if (!dir) {
+        // Eventos perdidos: nenhuma listagem é confiável
+        while (g_list.lru_head) remove_locked(g_list.lru_head);
+        pthread_mutex_unlock(&g_list.mu);
+        return;
+    }
+
+    Dir *d = lookup_locked(dir);
+    if (d) {
+        if (mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+            remove_locked(d);
+        } else if (name && (mask & (IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM))) {
+            ssize_t i = dir_index_of(d, name);
+            bool ok = true;
+            if ((mask & (IN_CREATE | IN_MOVED_TO)) && i < 0) {
+                ok = dir_add_name(d, name);
+            } else if ((mask & (IN_DELETE | IN_MOVED_FROM)) && i >= 0) {
+                free(d->names[i]);
+                memmove(&d->names[i], &d->names[i + 1],
+                        (d->nnames - (size_t)i - 1) * sizeof(char *));
+                d->nnames--;
+            }
+            if (!ok || d->nnames > LISTING_MAX_NAMES) remove_locked(d);
+            else dir_drop_bodies(d);
+            __atomic_fetch_add(&g_list.patches, 1, __ATOMIC_RELAXED);
+        }
+        // Demais eventos (conteúdo/atributos de um arquivo) não mudam a lista
+    }
+    pthread_mutex_unlock(&g_list.mu);
+}
+
+// -----------------------------------------------------------------------------
+// API
+// -----------------------------------------------------------------------------
+
+void listing_init(void) {
+    if (!cache_enabled()) return;
+    g_list.on = true;
+    cache_set_dir_listener(on_dir_event);
+}
+
+ListingBody *listing_find(const char *dir, ListingKind kind, const char *url, bool want_gzip) {
+    if (!g_list.on) return NULL;
+    ListingBody *b = NULL;
+    pthread_mutex_lock(&g_list.mu);
+    Dir *d = lookup_locked(dir);
+    if (d && !(kind == LISTING_HTML && dir_has_index(d))) {
+        if (g_list.lru_head != d) { lru_unlink(d); lru_push_front(d); }
+        b = dir_body(d, kind, url, want_gzip);
+    }
+    pthread_mutex_unlock(&g_list.mu);
+    if (b) __atomic_fetch_add(&g_list.hits, 1, __ATOMIC_RELAXED);
+    return b;
+}
+
+ListingBody *listing_get(const char *dir, int dfd, ListingKind kind, const char *url,
+                         bool want_gzip) {
+    ListingBody *b = listing_find(dir, kind, url, want_gzip);
+    if (b) return b;
+
+    // Observa antes de varrer: um evento no meio da varredura muda a época e
+    // o resultado serve só este request
+    uint64_t epoch = 0;
+    bool cacheable = g_list.on && cache_watch_dir(dir, &epoch);
+    if (g_list.on) __atomic_fetch_add(&g_list.misses, 1, __ATOMIC_RELAXED);
+
+    Dir *d = dir_scan(dir, dfd);
+    if (!d) return NULL;
+    cacheable = cacheable && d->nnames <= LISTING_MAX_NAMES;
+
+    pthread_mutex_lock(&g_list.mu);
+    b = dir_body(d, kind, url, want_gzip);
+    if (cacheable && cache_epoch() == epoch && !lookup_locked(dir)) {
+        insert_locked(d);
+        d = NULL;
+    }
+    pthread_mutex_unlock(&g_list.mu);
+    dir_free(d);
+    return b;
+}
+
+void listing_stats(ListingStats *out) {
+    out->hits    = __atomic_load_n(&g_list.hits, __ATOMIC_RELAXED);
+    out->misses  = __atomic_load_n(&g_list.misses, __ATOMIC_RELAXED);
+    out->patches = __atomic_load_n(&g_list.patches, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&g_list.mu);
+    out->dirs = g_list.ndirs;
+    pthread_mutex_unlock(&g_list.mu);
+}
+// -----------------------------------------------------------------------------
+// Leitura direta (getdents64)
+// -----------------------------------------------------------------------------
+
+// Registro devolvido pelo kernel (ver getdents64(2)).
+struct linux_dirent64 {
+    uint64_t       d_ino;
+    int64_t        d_off;     // posição da entrada seguinte
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[];
+};
+
+struct ListingStream {
+    int     fd;
+    size_t  pos, len;         // registros em buf[pos, len)
+    bool    eof, err;
+    int64_t cursor;           // d_off do último nome consumido
+    size_t  emitted;          // nomes já entregues (para as vírgulas)
+    bool    heap;             // alocado por listing_stream_open
+    char    buf[LISTING_BATCH] __attribute__((aligned(8)));
+};
+
+size_t listing_stream_size(void) {
+    return sizeof(ListingStream);
+}
+
+ListingStream *listing_stream_open_in(void *mem, int fd) {
+    if (fd < 0) return NULL;
+    if (!mem) { close(fd); return NULL; }
+    ListingStream *s = (ListingStream *)mem;
+    s->fd = fd;
+    s->pos = s->len = 0;
+    s->eof = s->err = false;
+    s->cursor = 0;
+    s->emitted = 0;
+    s->heap = false;
+    return s;
+}
+
+ListingStream *listing_stream_open(int fd) {
+    if (fd < 0) return NULL;
+    ListingStream *s = listing_stream_open_in(malloc(sizeof(ListingStream)), fd);
+    if (s) s->heap = true;
+    return s;
+}
+
+void listing_stream_close(ListingStream *s) {
+    if (!s) return;
+    close(s->fd);
+    if (s->heap) free(s);
+}
+
+static bool name_hidden(const char *name) {
+    return name[0] == '.' || !strcasecmp(name, "index.html");
+}
+
+static void stream_consume(ListingStream *s, const struct linux_dirent64 *d) {
+    s->pos += d->d_reclen;
+    s->cursor = d->d_off;
+}
+
+// Próximo nome visível, sem consumi-lo; NULL no fim ou em erro (s->err).
+static const struct linux_dirent64 *stream_peek(ListingStream *s) {
+    for (;;) {
+        if (s->pos >= s->len) {
+            if (s->eof || s->err) return NULL;
+            long n = syscall(SYS_getdents64, s->fd, s->buf, sizeof(s->buf));
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) { s->err = true; return NULL; }
+            if (n == 0) { s->eof = true; return NULL; }
+            s->pos = 0;
+            s->len = (size_t)n;
+        }
+        const struct linux_dirent64 *d = (const struct linux_dirent64 *)(s->buf + s->pos);
+        if (!name_hidden(d->d_name)) return d;
+        stream_consume(s, d);
+    }
+}
+
+bool listing_stream_seek(ListingStream *s, const char *cursor) {
+    char *end;
+    errno = 0;
+    unsigned long long v = strtoull(cursor, &end, 16);
+    if (errno || end == cursor || *end) return false;
+    if (lseek(s->fd, (off_t)v, SEEK_SET) < 0) return false;
+    s->pos = s->len = 0;
+    s->eof = false;
+    s->cursor = (int64_t)v;
+    return true;
+}
+
+void listing_stream_cursor(const ListingStream *s, char *buf, size_t cap) {
+    snprintf(buf, cap, "%llx", (unsigned long long)s->cursor);
+}
+
+bool listing_stream_skip(ListingStream *s, size_t n) {
+    const struct linux_dirent64 *d;
+    while (n > 0 && (d = stream_peek(s))) { stream_consume(s, d); n--; }
+    return !s->err;
+}
+
+ssize_t listing_stream_json(ListingStream *s, char *out, size_t cap, size_t *max_items) {
+    size_t len = 0;
+    const struct linux_dirent64 *d;
+    while (*max_items > 0 && (d = stream_peek(s))) {
+        size_t need = strlen(d->d_name) * 2 + 4;   // vírgula + aspas + NUL
+        if (len + need > cap) break;
+        if (s->emitted++) out[len++] = ',';
+        out[len++] = '"';
+        len += listing_json_escape(out + len, d->d_name);
+        out[len++] = '"';
+        stream_consume(s, d);
+        (*max_items)--;
+    }
+    return (s->err && len == 0) ? -1 : (ssize_t)len;
+}
+
+bool listing_stream_done(ListingStream *s) {
+    return stream_peek(s) == NULL;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+// server_files/listing.h
+// Cache de listagens de diretório. Os nomes de cada diretório listado ficam
+// em memória e são corrigidos pelos eventos de inotify (criação, remoção,
+// rename) em vez de uma nova varredura; os corpos JSON e HTML são
+// serializados sob demanda e reaproveitados até a próxima mudança.
+#ifndef LISTING_H
+#define LISTING_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef enum {
+    LISTING_JSON,     // ["a","b",...] sem index.html e sem ocultos
+    LISTING_HTML,     // página "Index of" (sem index.html)
+    LISTING_KINDS
+} ListingKind;
+
+// Corpo pronto e imutável; vive enquanto houver referência.
+typedef struct ListingBody {
+    int    refs;      // atômico
+    bool   gzip;      // data está comprimido com gzip
+    size_t len;
+    char   data[];
+} ListingBody;
+
+typedef struct {
+    uint64_t hits, misses, patches, dirs;
+} ListingStats;
+
+// Liga o cache (requer o cache de respostas ligado, de quem usa o inotify).
+void listing_init(void);
+
+// Corpo da listagem de `dir`, com uma referência (soltar com listing_release).
+// `dfd` é o diretório já aberto (O_RDONLY) por quem resolveu o caminho; só é
+// lido se a listagem não estiver em memória, e continua com o chamador.
+// `url` é o prefixo dos links da página HTML. Com `want_gzip`, devolve a
+// versão comprimida quando ela compensa (ver ->gzip). NULL quando `dir` não
+// é um diretório legível.
+ListingBody *listing_get(const char *dir, int dfd, ListingKind kind, const char *url,
+                         bool want_gzip);
+
+// Como listing_get, mas só consulta a memória: NULL se o diretório não está
+// em cache ou, para HTML, se ele tem index.html (que então deve ser servido).
+ListingBody *listing_find(const char *dir, ListingKind kind, const char *url, bool want_gzip);
+
+// Assinatura genérica (void *) para servir de callback de segmento.
+void listing_release(void *body);
+
+void listing_stats(ListingStats *out);
+
+// Serialização sem cache (benchmarks, pacote): `names` como o corpo de `kind`, num
+// buffer de malloc. NULL sem memória.
+char *listing_serialize(char *const *names, size_t n, ListingKind kind, const char *url, size_t *len);
+
+// JSON-escape simples para nomes (aspas e barra invertida). `dst` precisa
+// de 2 * strlen(src) + 1 bytes; devolve o comprimento escrito.
+size_t listing_json_escape(char *dst, const char *src);
+
+// -----------------------------------------------------------------------------
+// Leitura direta do disco, para diretórios grandes: lotes de getdents64 em
+// um buffer fixo, sem guardar nomes (memória constante). Entrega os mesmos
+// nomes da listagem JSON (sem index.html e sem ocultos), na ordem do disco.
+// -----------------------------------------------------------------------------
+typedef struct ListingStream ListingStream;
+
+// Assume a posse de `dfd` (diretório aberto com O_RDONLY), mesmo em erro.
+// NULL se dfd < 0 ou faltar memória.
+ListingStream *listing_stream_open(int dfd);
+// Mesmo, em `mem` (listing_stream_size() bytes, alinhados) fornecida pelo
+// chamador, por exemplo da arena da conexão; close só fecha o descritor.
+ListingStream *listing_stream_open_in(void *mem, int dfd);
+size_t listing_stream_size(void);
+void listing_stream_close(ListingStream *s);
+
+// Cursor opaco = posição logo depois do último nome entregue; retomar por
+// ele não depende de quantos nomes vieram antes. Formato: hex.
+bool listing_stream_seek(ListingStream *s, const char *cursor);
+void listing_stream_cursor(const ListingStream *s, char *buf, size_t cap);
+
+// Pula `n` nomes visíveis (paginação por offset).
+bool listing_stream_skip(ListingStream *s, size_t n);
+
+// Escreve em `out` até `*max_items` nomes como strings JSON separadas por
+// vírgula (a primeira do stream sem vírgula), sem passar de `cap` bytes, e
+// desconta de `*max_items` os escritos. Devolve os bytes escritos ou -1 em
+// erro de leitura.
+ssize_t listing_stream_json(ListingStream *s, char *out, size_t cap, size_t *max_items);
+
+// true quando não há mais nomes (pode ler o próximo lote para saber).
+bool listing_stream_done(ListingStream *s);
+
+#endif
\ No newline at end of file
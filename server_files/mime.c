@@ -0,0 +1,287 @@
+// Tabela de MIME types com hash perfeito (hash-and-displace).
+//
+// Cada extensão (minúsculas, até 15 bytes, completada com zeros até 16) tem
+// um hash de 64 bits. Os bits baixos escolhem um grupo; o deslocamento do
+// grupo (disp) é misturado ao hash para dar a posição final. O construtor
+// escolhe, grupo a grupo (maiores primeiro), o primeiro deslocamento que põe
+// todas as chaves do grupo em posições livres, então não há colisões e a
+// busca nunca sonda: calcula a posição e compara 16 bytes.
+//
+// A tabela padrão vem pronta de mime_table.h (gerado por tools/mime_gen.c a
+// partir de mime.types); mime_load() a reconstrói na partida com as entradas
+// extras.
+
+#include "mime.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mime_table.h"
+
+#define MIME_DEFAULT  "application/octet-stream"
+#define MIME_MAX_BITS 20
+
+static MimeTable g_table = {
+    MIME_TABLE_BITS, MIME_TABLE_DBITS, k_mime_disp, k_mime_slots
+};
+static size_t g_count = MIME_TABLE_COUNT;
+static bool   g_heap;   // g_table aponta para memória de mime_build
+
+// -----------------------------------------------------------------------------
+// Hash e normalização
+// -----------------------------------------------------------------------------
+
+uint64_t mime_hash(const char ext[MIME_EXT_MAX + 1]) {
+    uint64_t a, b;
+    memcpy(&a, ext, 8);
+    memcpy(&b, ext + 8, 8);
+    uint64_t h = a ^ (b * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return h;
+}
+
+unsigned mime_slot_of(uint64_t h, unsigned disp, unsigned bits) {
+    uint64_t x = (h >> 16) ^ ((uint64_t)disp * 0x9E3779B97F4A7C15ULL);
+    x ^= x >> 31;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 29;
+    return (unsigned)(x & ((1ULL << bits) - 1));
+}
+
+bool mime_normalize(const char *ext, size_t n, char out[MIME_EXT_MAX + 1]) {
+    memset(out, 0, MIME_EXT_MAX + 1);
+    if (n > MIME_EXT_MAX) return false;
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)ext[i];
+        // 'A'..'Z' ganha o bit 0x20; os demais passam intactos
+        out[i] = (char)(c | (((unsigned)(c - 'A') < 26u) << 5));
+    }
+    return true;
+}
+
+const char *mime_decorate(const char *type, char *buf, size_t cap) {
+    size_t tl = strlen(type);
+    bool text = !strncmp(type, "text/", 5) || !strcmp(type, "application/javascript") ||
+                (tl >= 4 && !strcmp(type + tl - 4, "json"));
+    if (!text || strchr(type, ';')) return type;
+    snprintf(buf, cap, "%s; charset=utf-8", type);
+    return buf;
+}
+
+// -----------------------------------------------------------------------------
+// Busca
+// -----------------------------------------------------------------------------
+
+const char *mime_lookup(const char *path) {
+    const char *dot = strrchr(path, '.');
+    if (!dot || strchr(dot, '/')) return MIME_DEFAULT;
+
+    char key[MIME_EXT_MAX + 1];
+    if (!mime_normalize(dot + 1, strlen(dot + 1), key)) return MIME_DEFAULT;
+
+    const MimeTable *t = &g_table;
+    uint64_t h = mime_hash(key);
+    const MimeSlot *s = &t->slots[mime_slot_of(h, t->disp[h & ((1u << t->dbits) - 1)], t->bits)];
+    return (s->type && !memcmp(s->ext, key, sizeof(key))) ? s->type : MIME_DEFAULT;
+}
+
+size_t mime_count(void) {
+    return g_count;
+}
+
+bool mime_compressible(const char *ctype) {
+    return !strncmp(ctype, "text/", 5) ||
+           !strncmp(ctype, "application/javascript", 22) ||
+           !strncmp(ctype, "application/json", 16) ||
+           !strncmp(ctype, "image/svg+xml", 13);
+}
+
+// -----------------------------------------------------------------------------
+// Construção
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    char        ext[MIME_EXT_MAX + 1];
+    const char *type;
+    uint64_t    h;
+} Key;
+
+typedef struct {
+    unsigned id, size;
+} Bucket;
+
+static int bucket_cmp(const void *a, const void *b) {
+    const Bucket *x = (const Bucket *)a, *y = (const Bucket *)b;
+    if (x->size != y->size) return x->size < y->size ? 1 : -1;
+    return x->id < y->id ? -1 : (x->id > y->id);
+}
+
+// Tenta montar com 2^bits posições; false se algum grupo não achar deslocamento.
+static bool build_with(const Key *keys, size_t nk, unsigned bits, unsigned dbits,
+                       uint16_t *disp, MimeSlot *slots) {
+    size_t nb = (size_t)1 << dbits, ns = (size_t)1 << bits;
+    Bucket *bk = (Bucket *)calloc(nb, sizeof(*bk));
+    size_t *order = (size_t *)malloc((nk ? nk : 1) * sizeof(*order));
+    unsigned *pos = (unsigned *)malloc((nk ? nk : 1) * sizeof(*pos));
+    bool ok = bk && order && pos;
+
+    if (ok) {
+        for (size_t b = 0; b < nb; b++) bk[b].id = (unsigned)b;
+        for (size_t i = 0; i < nk; i++) bk[keys[i].h & (nb - 1)].size++;
+        qsort(bk, nb, sizeof(*bk), bucket_cmp);
+        memset(disp, 0, nb * sizeof(*disp));
+        memset(slots, 0, ns * sizeof(*slots));
+    }
+
+    for (size_t b = 0; ok && b < nb && bk[b].size > 0; b++) {
+        // Chaves deste grupo
+        size_t m = 0;
+        for (size_t i = 0; i < nk; i++)
+            if ((keys[i].h & (nb - 1)) == bk[b].id) order[m++] = i;
+
+        bool placed = false;
+        for (unsigned d = 0; d < 65536 && !placed; d++) {
+            placed = true;
+            for (size_t j = 0; j < m && placed; j++) {
+                pos[j] = mime_slot_of(keys[order[j]].h, d, bits);
+                if (slots[pos[j]].type) placed = false;
+                for (size_t k = 0; k < j && placed; k++)
+                    if (pos[k] == pos[j]) placed = false;
+            }
+            if (placed) {
+                disp[bk[b].id] = (uint16_t)d;
+                for (size_t j = 0; j < m; j++) {
+                    memcpy(slots[pos[j]].ext, keys[order[j]].ext, MIME_EXT_MAX + 1);
+                    slots[pos[j]].type = keys[order[j]].type;
+                }
+            }
+        }
+        if (!placed) ok = false;
+    }
+    free(bk);
+    free(order);
+    free(pos);
+    return ok;
+}
+
+bool mime_build(const MimeEntry *in, size_t n, MimeTable *out) {
+    Key *keys = (Key *)malloc((n ? n : 1) * sizeof(*keys));
+    if (!keys) return false;
+
+    // Normaliza e remove repetidas (a última vence)
+    size_t nk = 0;
+    for (size_t i = 0; i < n; i++) {
+        Key k;
+        if (!mime_normalize(in[i].ext, strlen(in[i].ext), k.ext) || !k.ext[0]) continue;
+        k.type = in[i].type;
+        k.h = mime_hash(k.ext);
+        size_t j = 0;
+        while (j < nk && memcmp(keys[j].ext, k.ext, sizeof(k.ext))) j++;
+        keys[j] = k;
+        if (j == nk) nk++;
+    }
+
+    // ~80% de ocupação; em média duas chaves por grupo
+    unsigned bits = 2, dbits = 1;
+    while (((size_t)1 << bits) < nk + nk / 4) bits++;
+    while (((size_t)1 << dbits) < (nk + 1) / 2) dbits++;
+
+    for (; bits <= MIME_MAX_BITS; bits++) {
+        uint16_t *disp = (uint16_t *)malloc(((size_t)1 << dbits) * sizeof(*disp));
+        MimeSlot *slots = (MimeSlot *)malloc(((size_t)1 << bits) * sizeof(*slots));
+        if (!disp || !slots) { free(disp); free(slots); break; }
+        if (build_with(keys, nk, bits, dbits, disp, slots)) {
+            out->bits = bits;
+            out->dbits = dbits;
+            out->disp = disp;
+            out->slots = slots;
+            free(keys);
+            return true;
+        }
+        free(disp);
+        free(slots);
+    }
+    free(keys);
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Arquivo mime.types
+// -----------------------------------------------------------------------------
+
+int mime_parse_file(const char *file, MimeEntry **out) {
+    FILE *f = fopen(file, "r");
+    if (!f) return -1;
+
+    MimeEntry *v = NULL;
+    size_t n = 0, cap = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char *save = NULL;
+        const char *type = strtok_r(line, " \t\r\n", &save);
+        if (!type || !strchr(type, '/')) continue;
+
+        char buf[256];
+        const char *dec = mime_decorate(type, buf, sizeof(buf));
+        char *owned = NULL;   // compartilhado pelas extensões da linha
+
+        for (char *ext; (ext = strtok_r(NULL, " \t\r\n", &save)) != NULL; ) {
+            if (strlen(ext) > MIME_EXT_MAX) continue;
+            if (!owned && !(owned = strdup(dec))) break;
+            if (n == cap) {
+                size_t nc = cap ? cap * 2 : 256;
+                MimeEntry *tmp = (MimeEntry *)realloc(v, nc * sizeof(*tmp));
+                if (!tmp) break;
+                v = tmp; cap = nc;
+            }
+            char *e = strdup(ext);
+            if (!e) break;
+            v[n].ext = e;
+            v[n].type = owned;
+            n++;
+        }
+    }
+    fclose(f);
+    *out = v;
+    return (int)n;
+}
+
+int mime_load(const char *file) {
+    MimeEntry *extra = NULL;
+    int n = mime_parse_file(file, &extra);
+    if (n < 0) return -1;
+
+    // Atual + arquivo (o arquivo por último, para prevalecer)
+    size_t ns = (size_t)1 << g_table.bits;
+    MimeEntry *all = (MimeEntry *)malloc((g_count + (size_t)n + 1) * sizeof(*all));
+    if (!all) return -1;
+    size_t m = 0;
+    for (size_t i = 0; i < ns; i++) {
+        if (!g_table.slots[i].type) continue;
+        all[m].ext = g_table.slots[i].ext;
+        all[m].type = g_table.slots[i].type;
+        m++;
+    }
+    memcpy(all + m, extra, (size_t)n * sizeof(*all));
+    m += (size_t)n;
+
+    MimeTable t;
+    bool ok = mime_build(all, m, &t);
+    free(all);
+    if (!ok) return -1;
+
+    // As strings de tipo continuam em uso pela nova tabela; só a estrutura sai
+    size_t count = 0;
+    for (size_t i = 0; i < ((size_t)1 << t.bits); i++) count += t.slots[i].type != NULL;
+    if (g_heap) { free((void *)g_table.disp); free((void *)g_table.slots); }
+    g_table = t;
+    g_count = count;
+    g_heap = true;
+    return n;
+}
\ No newline at end of file
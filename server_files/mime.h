@@ -0,0 +1,69 @@
+// server_files/mime.h
+// Tabela extensão -> Content-Type com hash perfeito: a tabela padrão é gerada
+// em tempo de compilação (mime_table.h, a partir de mime.types) e pode ser
+// estendida na partida com um arquivo no formato mime.types, que é fundido e
+// reindexado na mesma estrutura. A busca é O(1): um hash, um deslocamento e
+// uma comparação de 16 bytes.
+#ifndef MIME_H
+#define MIME_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MIME_EXT_MAX 15   // extensões maiores nunca casam
+
+typedef struct {
+    char        ext[MIME_EXT_MAX + 1];   // minúsculas, completada com zeros
+    const char *type;                    // NULL = posição vazia
+} MimeSlot;
+
+typedef struct {
+    unsigned        bits;    // log2 do nº de posições
+    unsigned        dbits;   // log2 do nº de grupos de deslocamento
+    const uint16_t *disp;    // deslocamento por grupo
+    const MimeSlot *slots;
+} MimeTable;
+
+typedef struct {
+    const char *ext;
+    const char *type;
+} MimeEntry;
+
+// Content-Type pela extensão de `path` (application/octet-stream se nenhuma).
+const char *mime_lookup(const char *path);
+
+// Funde as entradas de um arquivo mime.types ("tipo ext1 ext2 ...", "#"
+// comenta) à tabela atual; as do arquivo prevalecem. Chamar antes de servir.
+// Devolve o nº de extensões lidas ou -1 em erro (a tabela fica como estava).
+int mime_load(const char *file);
+
+// Nº de extensões conhecidas.
+size_t mime_count(void);
+
+// Tipos que valem a pena comprimir (texto e formatos baseados em texto).
+bool mime_compressible(const char *ctype);
+
+// -----------------------------------------------------------------------------
+// Construção (usada na partida e pelo gerador tools/mime_gen.c)
+// -----------------------------------------------------------------------------
+
+// Hash de uma extensão já em minúsculas e completada com zeros.
+uint64_t mime_hash(const char ext[MIME_EXT_MAX + 1]);
+unsigned mime_slot_of(uint64_t h, unsigned disp, unsigned bits);
+
+// Minúsculas sem desvio por byte; false se `n` passar de MIME_EXT_MAX.
+bool mime_normalize(const char *ext, size_t n, char out[MIME_EXT_MAX + 1]);
+
+// Content-Type a servir para um tipo do mime.types (texto ganha charset).
+// Devolve `type` ou `buf`.
+const char *mime_decorate(const char *type, char *buf, size_t cap);
+
+// Lê um arquivo mime.types para um vetor alocado (tipos já decorados, em
+// memória própria). Devolve o nº de entradas ou -1 se não abrir.
+int mime_parse_file(const char *file, MimeEntry **out);
+
+// Monta um hash perfeito para `n` entradas (extensões repetidas: vale a
+// última). disp/slots alocados com malloc. false em falta de memória.
+bool mime_build(const MimeEntry *in, size_t n, MimeTable *out);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,104 @@
+// server_files/mime_table.h
+// Gerado por tools/mime_gen.c a partir de server_files/mime.types
+// (make mime-table). Não edite à mão.
+#define MIME_TABLE_BITS  7
+#define MIME_TABLE_DBITS 6
+#define MIME_TABLE_COUNT 86
+
+static const uint16_t k_mime_disp[64] = {
+    0, 0, 0, 2, 0, 0, 1, 0, 0, 1, 3, 0,
+    0, 0, 8, 0, 0, 0, 0, 1, 3, 0, 0, 0,
+    0, 0, 0, 0, 1, 2, 0, 1, 4, 1, 0, 1,
+    2, 0, 3, 2, 0, 1, 9, 0, 4, 1, 0, 1,
+    0, 0, 0, 0, 2, 0, 0, 1, 5, 10, 3, 0,
+    0, 0, 0, 0,
+};
+
+static const MimeSlot k_mime_slots[128] = {
+    [0] = { "exe", "application/octet-stream" },
+    [4] = { "ogv", "video/ogg" },
+    [6] = { "avi", "video/x-msvideo" },
+    [8] = { "woff2", "font/woff2" },
+    [9] = { "webmanifest", "application/manifest+json; charset=utf-8" },
+    [10] = { "ics", "text/calendar; charset=utf-8" },
+    [12] = { "7z", "application/x-7z-compressed" },
+    [15] = { "gz", "application/gzip" },
+    [16] = { "ts", "video/mp2t" },
+    [17] = { "wasm", "application/wasm" },
+    [18] = { "htm", "text/html; charset=utf-8" },
+    [21] = { "woff", "font/woff" },
+    [22] = { "svg", "image/svg+xml" },
+    [23] = { "zip", "application/zip" },
+    [26] = { "js", "application/javascript; charset=utf-8" },
+    [27] = { "markdown", "text/markdown; charset=utf-8" },
+    [28] = { "mp3", "audio/mpeg" },
+    [29] = { "swf", "application/x-shockwave-flash" },
+    [30] = { "svgz", "image/svg+xml" },
+    [32] = { "img", "application/octet-stream" },
+    [35] = { "jar", "application/java-archive" },
+    [37] = { "odp", "application/vnd.oasis.opendocument.presentation" },
+    [39] = { "tgz", "application/gzip" },
+    [42] = { "doc", "application/msword" },
+    [43] = { "odt", "application/vnd.oasis.opendocument.text" },
+    [44] = { "docx", "application/vnd.openxmlformats-officedocument.wordprocessingml.document" },
+    [45] = { "tar", "application/x-tar" },
+    [47] = { "jpe", "image/jpeg" },
+    [48] = { "ogg", "audio/ogg" },
+    [49] = { "xhtml", "application/xhtml+xml" },
+    [50] = { "iso", "application/octet-stream" },
+    [51] = { "ppt", "application/vnd.ms-powerpoint" },
+    [52] = { "rtf", "application/rtf" },
+    [53] = { "weba", "audio/webm" },
+    [54] = { "bmp", "image/bmp" },
+    [55] = { "jpeg", "image/jpeg" },
+    [56] = { "eot", "application/vnd.ms-fontobject" },
+    [58] = { "rss", "application/rss+xml" },
+    [59] = { "css", "text/css; charset=utf-8" },
+    [61] = { "ico", "image/x-icon" },
+    [63] = { "jsonld", "application/ld+json; charset=utf-8" },
+    [64] = { "xls", "application/vnd.ms-excel" },
+    [65] = { "gif", "image/gif" },
+    [66] = { "ods", "application/vnd.oasis.opendocument.spreadsheet" },
+    [68] = { "wav", "audio/wav" },
+    [70] = { "bz2", "application/x-bzip2" },
+    [71] = { "webp", "image/webp" },
+    [73] = { "apng", "image/apng" },
+    [76] = { "xml", "text/xml; charset=utf-8" },
+    [77] = { "pptx", "application/vnd.openxmlformats-officedocument.presentationml.presentation" },
+    [78] = { "md", "text/plain; charset=utf-8" },
+    [79] = { "csv", "text/csv; charset=utf-8" },
+    [81] = { "m4a", "audio/mp4" },
+    [83] = { "json", "application/json; charset=utf-8" },
+    [84] = { "ttf", "font/ttf" },
+    [85] = { "m4v", "video/mp4" },
+    [87] = { "mov", "video/quicktime" },
+    [90] = { "mjs", "application/javascript; charset=utf-8" },
+    [93] = { "opus", "audio/ogg" },
+    [94] = { "mkv", "video/x-matroska" },
+    [95] = { "png", "image/png" },
+    [96] = { "jpg", "image/jpeg" },
+    [97] = { "sh", "application/x-sh" },
+    [99] = { "epub", "application/epub+zip" },
+    [100] = { "map", "application/json; charset=utf-8" },
+    [101] = { "avif", "image/avif" },
+    [102] = { "bin", "application/octet-stream" },
+    [103] = { "zst", "application/zstd" },
+    [104] = { "aac", "audio/aac" },
+    [105] = { "otf", "font/otf" },
+    [106] = { "webm", "video/webm" },
+    [107] = { "tiff", "image/tiff" },
+    [109] = { "xz", "application/x-xz" },
+    [110] = { "pdf", "application/pdf" },
+    [111] = { "oga", "audio/ogg" },
+    [112] = { "dll", "application/octet-stream" },
+    [114] = { "tif", "image/tiff" },
+    [115] = { "mp4", "video/mp4" },
+    [116] = { "log", "text/plain; charset=utf-8" },
+    [117] = { "xlsx", "application/vnd.openxmlformats-officedocument.spreadsheetml.sheet" },
+    [119] = { "atom", "application/atom+xml" },
+    [120] = { "text", "text/plain; charset=utf-8" },
+    [122] = { "flac", "audio/flac" },
+    [124] = { "txt", "text/plain; charset=utf-8" },
+    [126] = { "html", "text/html; charset=utf-8" },
+    [127] = { "rar", "application/vnd.rar" },
+};
\ No newline at end of file
@@ -0,0 +1,189 @@
+// Parser incremental de requests HTTP/1.x (RFC 9112).
+//
+// Máquina de estados por token: cada estado avança com um laço apertado até
+// o próximo delimitador (espaço, ':', CR/LF; ver scan.h, com versões SIMD)
+// e só então decide o que fazer,
+// então cada byte é examinado uma vez mesmo quando o request chega em
+// pedaços: ao faltar dados, o estado e a posição ficam em HttpRequest e a
+// próxima chamada continua do mesmo ponto.
+//
+// Aceita fim de linha CRLF ou LF sozinho, ignora linhas vazias antes da linha
+// de request e recusa obs-fold (cabeçalho continuado na linha seguinte).
+
+#include "request.h"
+#include "scan.h"
+
+#include <string.h>
+#include <strings.h>
+
+enum {
+    RS_START,        // antes da linha de request (pula CR/LF soltos)
+    RS_METHOD,
+    RS_TARGET,
+    RS_VERSION,
+    RS_LINE_END,     // em CR ou LF de uma linha
+    RS_HEADER_START, // início de linha: cabeçalho ou fim do bloco
+    RS_HDR_NAME,
+    RS_HDR_WS,       // espaços depois de ':'
+    RS_HDR_VALUE,
+    RS_END_LF        // CR da linha vazia final, falta o LF
+};
+
+// -----------------------------------------------------------------------------
+// API
+// -----------------------------------------------------------------------------
+
+void req_reset(HttpRequest *r) {
+    r->method = r->target = r->version = (StrView){ NULL, 0 };
+    r->minor = 0;
+    r->nheaders = 0;
+    r->head_len = 0;
+    r->state = RS_START;
+    r->pos = 0;
+    r->tok = 0;
+}
+
+ReqStatus req_parse(HttpRequest *r, const char *buf, size_t len, const ReqLimits *lim) {
+    // Nada além do limite é examinado: o que não coube nele é 431
+    bool clipped = len > lim->max_head;
+    const char *end = buf + (clipped ? lim->max_head : len);
+    const char *p = buf + r->pos;
+    const char *q;
+
+    for (;;) {
+        switch (r->state) {
+        case RS_START:
+            while (p < end && (*p == '\r' || *p == '\n')) p++;
+            if (p == end) goto again;
+            r->tok = (size_t)(p - buf);
+            r->state = RS_METHOD;
+            /* fallthrough */
+
+        case RS_METHOD:
+            q = g_scan.tchar(p, end);
+            if (q == end) { p = q; goto again; }
+            if (*q != ' ' || q == buf + r->tok) return REQ_BAD;
+            r->method = (StrView){ buf + r->tok, (size_t)(q - (buf + r->tok)) };
+            p = q + 1;
+            r->tok = (size_t)(p - buf);
+            r->state = RS_TARGET;
+            /* fallthrough */
+
+        case RS_TARGET:
+            q = g_scan.target(p, end);
+            if ((size_t)(q - (buf + r->tok)) > lim->max_uri) return REQ_URI_TOO_LONG;
+            if (q == end) { p = q; goto again; }
+            if (q == buf + r->tok) return REQ_BAD;
+            r->target = (StrView){ buf + r->tok, (size_t)(q - (buf + r->tok)) };
+            if (*q == '\r' || *q == '\n') {
+                // "GET /" sem versão: trata como HTTP/1.0
+                p = q;
+                r->state = RS_LINE_END;
+                continue;
+            }
+            if (*q != ' ') return REQ_BAD;
+            p = q + 1;
+            r->tok = (size_t)(p - buf);
+            r->state = RS_VERSION;
+            /* fallthrough */
+
+        case RS_VERSION:
+            q = g_scan.target(p, end);
+            if (q == end) { p = q; goto again; }
+            if (*q != '\r' && *q != '\n') return REQ_BAD;
+            r->version = (StrView){ buf + r->tok, (size_t)(q - (buf + r->tok)) };
+            if (r->version.len != 8 || memcmp(r->version.p, "HTTP/1.", 7) ||
+                r->version.p[7] < '0' || r->version.p[7] > '9') {
+                return (r->version.len >= 5 && !memcmp(r->version.p, "HTTP/", 5))
+                       ? REQ_BAD_VERSION : REQ_BAD;
+            }
+            r->minor = r->version.p[7] - '0';
+            p = q;
+            r->state = RS_LINE_END;
+            /* fallthrough */
+
+        case RS_LINE_END:
+            if (*p == '\r') {
+                if (p + 1 == end) goto again;
+                if (p[1] != '\n') return REQ_BAD;
+                p++;
+            }
+            p++;
+            r->state = RS_HEADER_START;
+            /* fallthrough */
+
+        case RS_HEADER_START:
+            if (p == end) goto again;
+            if (*p == '\n') { p++; goto done; }
+            if (*p == '\r') { p++; r->state = RS_END_LF; continue; }
+            r->tok = (size_t)(p - buf);
+            r->state = RS_HDR_NAME;
+            /* fallthrough */
+
+        case RS_HDR_NAME:
+            q = g_scan.tchar(p, end);
+            if (q == end) { p = q; goto again; }
+            // Nome vazio cobre obs-fold (linha começando com espaço)
+            if (*q != ':' || q == buf + r->tok) return REQ_BAD;
+            if (r->nheaders >= lim->max_headers || r->nheaders >= REQ_MAX_HEADERS)
+                return REQ_HEAD_TOO_LARGE;
+            r->headers[r->nheaders].name = (StrView){ buf + r->tok, (size_t)(q - (buf + r->tok)) };
+            p = q + 1;
+            r->state = RS_HDR_WS;
+            /* fallthrough */
+
+        case RS_HDR_WS:
+            while (p < end && (*p == ' ' || *p == '\t')) p++;
+            if (p == end) goto again;
+            r->tok = (size_t)(p - buf);
+            r->state = RS_HDR_VALUE;
+            /* fallthrough */
+
+        case RS_HDR_VALUE: {
+            q = g_scan.value(p, end);
+            if (q == end) { p = q; goto again; }
+            if (*q != '\r' && *q != '\n') return REQ_BAD;
+            const char *v = buf + r->tok, *ve = q;
+            while (ve > v && (ve[-1] == ' ' || ve[-1] == '\t')) ve--;
+            r->headers[r->nheaders++].value = (StrView){ v, (size_t)(ve - v) };
+            p = q;
+            r->state = RS_LINE_END;
+            continue;
+        }
+
+        case RS_END_LF:
+            if (p == end) goto again;
+            if (*p != '\n') return REQ_BAD;
+            p++;
+            goto done;
+
+        default:
+            return REQ_BAD;
+        }
+    }
+
+done:
+    r->pos = r->head_len = (size_t)(p - buf);
+    return REQ_DONE;
+
+again:
+    r->pos = (size_t)(p - buf);
+    return (clipped || len >= lim->max_head) ? REQ_HEAD_TOO_LARGE : REQ_AGAIN;
+}
+
+const char *req_header(const HttpRequest *r, const char *name, size_t *len) {
+    size_t nl = strlen(name);
+    for (size_t i = 0; i < r->nheaders; i++) {
+        const HttpHeader *h = &r->headers[i];
+        if (h->name.len == nl && !strncasecmp(h->name.p, name, nl)) {
+            *len = h->value.len;
+            return h->value.p;
+        }
+    }
+    return NULL;
+}
+
+bool req_view_eq(StrView v, const char *s) {
+    size_t n = strlen(s);
+    return v.len == n && !memcmp(v.p, s, n);
+}
\ No newline at end of file
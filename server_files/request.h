@@ -0,0 +1,63 @@
+// server_files/request.h
+// Parser incremental de requests HTTP/1.x. Percorre cada byte uma vez, pode
+// ser retomado quando chegam mais dados e não aloca: método, alvo, versão e
+// cabeçalhos são visões (ponteiro + tamanho) dentro do buffer da conexão.
+#ifndef REQUEST_H
+#define REQUEST_H
+#include <stdbool.h>
+#include <stddef.h>
+
+#define REQ_MAX_HEADERS 64   // teto fixo do vetor de cabeçalhos
+
+// Trecho do buffer de entrada (não terminado em NUL).
+typedef struct {
+    const char *p;
+    size_t      len;
+} StrView;
+
+typedef struct {
+    StrView name, value;     // valor já sem espaços nas pontas
+} HttpHeader;
+
+typedef struct {
+    size_t max_uri;          // tamanho máximo do alvo (request-target)
+    size_t max_headers;      // número máximo de cabeçalhos (<= REQ_MAX_HEADERS)
+    size_t max_head;         // linha + cabeçalhos + linha vazia, em bytes
+} ReqLimits;
+
+typedef enum {
+    REQ_DONE,                // request completo; ver head_len
+    REQ_AGAIN,               // faltam bytes
+    REQ_BAD,                 // sintaxe inválida -> 400
+    REQ_URI_TOO_LONG,        // -> 414
+    REQ_HEAD_TOO_LARGE,      // -> 431
+    REQ_BAD_VERSION          // não é HTTP/1.x -> 505
+} ReqStatus;
+
+typedef struct HttpRequest {
+    StrView    method, target, version;   // version vazio = "GET /" sem versão
+    int        minor;                     // HTTP/1.<minor>
+    HttpHeader headers[REQ_MAX_HEADERS];
+    size_t     nheaders;
+    size_t     head_len;                  // bytes consumidos (REQ_DONE)
+
+    // Estado para retomar
+    int        state;
+    size_t     pos;                       // próximo byte a examinar
+    size_t     tok;                       // início do token corrente
+} HttpRequest;
+
+// Prepara para um novo request.
+void req_reset(HttpRequest *r);
+
+// Continua o parsing sobre buf[0, len). Entre chamadas, `buf` deve ser o
+// mesmo buffer, só crescendo; as visões apontam para dentro dele.
+ReqStatus req_parse(HttpRequest *r, const char *buf, size_t len, const ReqLimits *lim);
+
+// Valor do cabeçalho `name` (sem diferenciar maiúsculas), ou NULL.
+const char *req_header(const HttpRequest *r, const char *name, size_t *len);
+
+// Compara uma visão com uma string C.
+bool req_view_eq(StrView v, const char *s);
+
+#endif
\ No newline at end of file
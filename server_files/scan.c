@@ -0,0 +1,289 @@
+// Busca de delimitadores com SIMD e escolha em tempo de execução.
+//
+// Os três laços do parser (tchar, alvo, valor) procuram o primeiro byte de um
+// conjunto "de parada". Em x86-64:
+//   - SSE4.2: PCMPESTRI em modo de faixas, 16 bytes por instrução. Só cabem 8
+//     faixas, então para tchar a versão vetorial também para em '|' e '~'
+//     (tchars raros em nomes de cabeçalho) e o laço confere na tabela;
+//   - AVX2: 32 bytes por iteração; alvo e valor com comparações, tchar com a
+//     classificação por nibbles (duas tabelas de 16 entradas via PSHUFB).
+// As funções vetoriais são compiladas com __attribute__((target)), então o
+// binário roda em qualquer x86-64 e o resto do programa não depende de -m*.
+// O final do buffer (menos que um vetor) desce para a largura seguinte e,
+// por fim, para o laço escalar; tokens curtos (a maioria dos nomes de
+// cabeçalho) quase só passam pelo bloco de 16 bytes.
+//
+// Largura maior não é garantia de ganho: com tokens curtos o AVX2 pode
+// perder para o SSE4.2 (troca de frequência, blocos parciais). Por isso
+// scan_init() mede as versões disponíveis num request típico e fica com a
+// mais rápida nesta máquina.
+
+#include "scan.h"
+
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_X86 1
+#endif
+
+const unsigned char scan_tchar_map[256] = {
+    ['!'] = 1, ['#'] = 1, ['$'] = 1, ['%'] = 1, ['&'] = 1, ['\''] = 1, ['*'] = 1,
+    ['+'] = 1, ['-'] = 1, ['.'] = 1, ['^'] = 1, ['_'] = 1, ['`'] = 1, ['|'] = 1, ['~'] = 1,
+    ['0'] = 1, ['1'] = 1, ['2'] = 1, ['3'] = 1, ['4'] = 1, ['5'] = 1, ['6'] = 1, ['7'] = 1,
+    ['8'] = 1, ['9'] = 1,
+    ['A'] = 1, ['B'] = 1, ['C'] = 1, ['D'] = 1, ['E'] = 1, ['F'] = 1, ['G'] = 1, ['H'] = 1,
+    ['I'] = 1, ['J'] = 1, ['K'] = 1, ['L'] = 1, ['M'] = 1, ['N'] = 1, ['O'] = 1, ['P'] = 1,
+    ['Q'] = 1, ['R'] = 1, ['S'] = 1, ['T'] = 1, ['U'] = 1, ['V'] = 1, ['W'] = 1, ['X'] = 1,
+    ['Y'] = 1, ['Z'] = 1,
+    ['a'] = 1, ['b'] = 1, ['c'] = 1, ['d'] = 1, ['e'] = 1, ['f'] = 1, ['g'] = 1, ['h'] = 1,
+    ['i'] = 1, ['j'] = 1, ['k'] = 1, ['l'] = 1, ['m'] = 1, ['n'] = 1, ['o'] = 1, ['p'] = 1,
+    ['q'] = 1, ['r'] = 1, ['s'] = 1, ['t'] = 1, ['u'] = 1, ['v'] = 1, ['w'] = 1, ['x'] = 1,
+    ['y'] = 1, ['z'] = 1,
+};
+
+// -----------------------------------------------------------------------------
+// Escalar
+// -----------------------------------------------------------------------------
+
+static const char *tchar_scalar(const char *p, const char *end) {
+    while (p < end && scan_tchar_map[(unsigned char)*p]) p++;
+    return p;
+}
+
+static const char *target_scalar(const char *p, const char *end) {
+    while (p < end && (unsigned char)*p > 0x20 && *p != 0x7f) p++;
+    return p;
+}
+
+static const char *value_scalar(const char *p, const char *end) {
+    while (p < end) {
+        unsigned char ch = (unsigned char)*p;
+        if ((ch < 0x20 && ch != '\t') || ch == 0x7f) break;
+        p++;
+    }
+    return p;
+}
+
+static const ScanImpl k_scalar = { "scalar", tchar_scalar, target_scalar, value_scalar };
+
+ScanImpl g_scan = { "scalar", tchar_scalar, target_scalar, value_scalar };
+
+#ifdef SCAN_X86
+
+// -----------------------------------------------------------------------------
+// SSE4.2 (PCMPESTRI, faixas de bytes de parada)
+// -----------------------------------------------------------------------------
+
+#define SIDD_FLAGS (_SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT)
+
+static const char k_rng_tchar[16]  = "\x00\x20\"\"(),,//:@[]{\xff";   // + '|' e '~'
+static const char k_rng_target[16] = "\x00\x20\x7f\x7f";
+static const char k_rng_value[16]  = "\x00\x08\x0a\x1f\x7f\x7f";
+
+__attribute__((target("sse4.2")))
+static inline const char *ranges_sse42(const char *p, const char *end,
+                                       const char *rng, int nrng) {
+    const __m128i r = _mm_loadu_si128((const __m128i *)rng);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        int i = _mm_cmpestri(r, nrng, v, 16, SIDD_FLAGS);
+        if (i != 16) return p + i;
+        p += 16;
+    }
+    return p;
+}
+
+__attribute__((target("sse4.2")))
+static const char *tchar_sse42(const char *p, const char *end) {
+    for (;;) {
+        p = ranges_sse42(p, end, k_rng_tchar, 16);
+        if (end - p < 16) return tchar_scalar(p, end);
+        if (!scan_tchar_map[(unsigned char)*p]) return p;
+        p++;   // '|' ou '~': continua
+    }
+}
+
+__attribute__((target("sse4.2")))
+static const char *target_sse42(const char *p, const char *end) {
+    p = ranges_sse42(p, end, k_rng_target, 4);
+    return (end - p < 16) ? target_scalar(p, end) : p;
+}
+
+__attribute__((target("sse4.2")))
+static const char *value_sse42(const char *p, const char *end) {
+    p = ranges_sse42(p, end, k_rng_value, 6);
+    return (end - p < 16) ? value_scalar(p, end) : p;
+}
+
+// -----------------------------------------------------------------------------
+// AVX2
+// -----------------------------------------------------------------------------
+
+// Classificação de tchar por nibbles: o byte b é tchar se
+// nib_lo[b & 15] & nib_hi[b >> 4] != 0 (bit h de nib_lo[l] = tchar(h<<4 | l)).
+// Cada tabela aparece duas vezes: PSHUFB indexa dentro de cada metade de 128 bits.
+static unsigned char g_nib_lo[32], g_nib_hi[32];
+
+static void nib_tables_init(void) {
+    memset(g_nib_lo, 0, sizeof(g_nib_lo));
+    memset(g_nib_hi, 0, sizeof(g_nib_hi));
+    for (int b = 0; b < 128; b++) {
+        if (!scan_tchar_map[b]) continue;
+        g_nib_lo[b & 15] |= (unsigned char)(1u << (b >> 4));
+        g_nib_lo[16 + (b & 15)] = g_nib_lo[b & 15];
+    }
+    for (int h = 0; h < 8; h++) g_nib_hi[h] = g_nib_hi[16 + h] = (unsigned char)(1u << h);
+}
+
+__attribute__((target("avx2,sse4.2")))
+static const char *tchar_avx2(const char *p, const char *end) {
+    const __m256i lo_t = _mm256_loadu_si256((const __m256i *)g_nib_lo);
+    const __m256i hi_t = _mm256_loadu_si256((const __m256i *)g_nib_hi);
+    const __m256i m0f  = _mm256_set1_epi8(0x0f);
+    while (end - p >= 32) {
+        __m256i v  = _mm256_loadu_si256((const __m256i *)p);
+        __m256i lo = _mm256_shuffle_epi8(lo_t, _mm256_and_si256(v, m0f));
+        __m256i hi = _mm256_shuffle_epi8(hi_t, _mm256_and_si256(_mm256_srli_epi16(v, 4), m0f));
+        __m256i bad = _mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256());
+        unsigned m = (unsigned)_mm256_movemask_epi8(bad);
+        if (m) return p + __builtin_ctz(m);
+        p += 32;
+    }
+    _mm256_zeroupper();        // evita a troca AVX -> SSE legado no resto
+    return tchar_sse42(p, end);   // resto: blocos de 16 e depois escalar
+}
+
+__attribute__((target("avx2,sse4.2")))
+static const char *target_avx2(const char *p, const char *end) {
+    const __m256i c21 = _mm256_set1_epi8(0x21);
+    const __m256i c7f = _mm256_set1_epi8(0x7f);
+    const __m256i zero = _mm256_setzero_si256();
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        // Com sinal: 0x80..0xff são negativos (obs-text, aceitos)
+        __m256i low = _mm256_andnot_si256(_mm256_cmpgt_epi8(zero, v), _mm256_cmpgt_epi8(c21, v));
+        __m256i bad = _mm256_or_si256(low, _mm256_cmpeq_epi8(v, c7f));
+        unsigned m = (unsigned)_mm256_movemask_epi8(bad);
+        if (m) return p + __builtin_ctz(m);
+        p += 32;
+    }
+    _mm256_zeroupper();        // evita a troca AVX -> SSE legado no resto
+    return target_sse42(p, end);   // resto: blocos de 16 e depois escalar
+}
+
+__attribute__((target("avx2,sse4.2")))
+static const char *value_avx2(const char *p, const char *end) {
+    const __m256i c20 = _mm256_set1_epi8(0x20);
+    const __m256i c7f = _mm256_set1_epi8(0x7f);
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i zero = _mm256_setzero_si256();
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i ctl = _mm256_andnot_si256(_mm256_cmpgt_epi8(zero, v), _mm256_cmpgt_epi8(c20, v));
+        ctl = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, tab), ctl);
+        __m256i bad = _mm256_or_si256(ctl, _mm256_cmpeq_epi8(v, c7f));
+        unsigned m = (unsigned)_mm256_movemask_epi8(bad);
+        if (m) return p + __builtin_ctz(m);
+        p += 32;
+    }
+    _mm256_zeroupper();        // evita a troca AVX -> SSE legado no resto
+    return value_sse42(p, end);   // resto: blocos de 16 e depois escalar
+}
+
+static const ScanImpl k_sse42 = { "sse4.2", tchar_sse42, target_sse42, value_sse42 };
+static const ScanImpl k_avx2  = { "avx2",   tchar_avx2,  target_avx2,  value_avx2  };
+
+#endif  // SCAN_X86
+
+// -----------------------------------------------------------------------------
+// Escolha
+// -----------------------------------------------------------------------------
+
+int scan_available(const ScanImpl **out, int max) {
+    int n = 0;
+    if (n < max) out[n++] = &k_scalar;
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+    if (n < max && __builtin_cpu_supports("sse4.2")) out[n++] = &k_sse42;
+    if (n < max && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.2")) {
+        nib_tables_init();
+        out[n++] = &k_avx2;
+    }
+#endif
+    return n;
+}
+
+// Calibração: um request de navegador percorrido como o parser faz (método,
+// alvo, versão e cada cabeçalho nome/valor), cem vezes por rodada.
+static const char k_sample[] =
+    "GET /docs/relatorio-2024.html?ref=menu HTTP/1.1\r\n"
+    "Host: arquivos.exemplo.com.br:5050\r\n"
+    "Connection: keep-alive\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "Referer: http://arquivos.exemplo.com.br:5050/docs/\r\n"
+    "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+    "Accept-Language: pt-BR,pt;q=0.9,en-US;q=0.8,en;q=0.7\r\n"
+    "Cookie: _ga=GA1.1.1234567890.1700000000; sessao=9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08; tema=escuro\r\n"
+    "If-None-Match: \"ce8019-16fc-18df293c8d4499ec\"\r\n"
+    "\r\n";
+
+#define CAL_WALKS  100
+#define CAL_ROUNDS 5
+
+static size_t walk(const ScanImpl *s) {
+    const char *p = k_sample, *end = k_sample + sizeof(k_sample) - 1;
+    p = s->tchar(p, end) + 1;
+    p = s->target(p, end) + 1;
+    p = s->target(p, end);
+    while (end - p > 2 && p[2] != '\r') {
+        p = s->tchar(p + 2, end);
+        if (end - p < 2) break;
+        p = s->value(p + 2, end);
+    }
+    return (size_t)(p - k_sample);
+}
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void scan_init(void) {
+    const ScanImpl *impl[3];
+    int n = scan_available(impl, 3);
+    long long best[3];
+    volatile size_t sink = 0;
+
+    // Rodadas intercaladas (a primeira só aquece), mínimo de cada versão
+    for (int r = 0; r <= CAL_ROUNDS; r++) {
+        for (int i = 0; i < n; i++) {
+            long long t0 = now_ns();
+            for (int k = 0; k < CAL_WALKS; k++) sink += walk(impl[i]);
+            long long t = now_ns() - t0;
+            if (r == 1 || (r > 1 && t < best[i])) best[i] = t;
+        }
+    }
+    (void)sink;
+
+    // Uma versão mais larga só ganha com folga (5%): empate fica com a mais
+    // estreita, que não oscila com ruído nem paga a troca de frequência
+    int pick = 0;
+    for (int i = 1; i < n; i++)
+        if (best[i] * 20 < best[pick] * 19) pick = i;
+    g_scan = *impl[pick];
+}
+
+bool scan_select(const char *name) {
+    const ScanImpl *impl[3];
+    int n = scan_available(impl, 3);
+    for (int i = 0; i < n; i++) {
+        if (!strcmp(impl[i]->name, name)) { g_scan = *impl[i]; return true; }
+    }
+    return false;
+}
\ No newline at end of file
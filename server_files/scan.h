@@ -0,0 +1,35 @@
+// server_files/scan.h
+// Busca de delimitadores do parser de requests: cada função devolve o
+// primeiro byte em [p, end) que encerra o token (ou `end`). Há versões
+// escalar, SSE4.2 e AVX2; scan_init() mede as suportadas pela CPU e fica
+// com a mais rápida.
+#ifndef SCAN_H
+#define SCAN_H
+#include <stdbool.h>
+
+typedef const char *(*ScanFn)(const char *p, const char *end);
+
+typedef struct {
+    const char *name;      // "scalar", "sse4.2" ou "avx2"
+    ScanFn      tchar;     // método / nome de cabeçalho: para no 1º não-tchar
+    ScanFn      target;    // alvo / versão: para em espaço, controle ou DEL
+    ScanFn      value;     // valor de cabeçalho: para em controle (exceto HTAB) ou DEL
+} ScanImpl;
+
+// Implementação em uso (escalar até scan_init).
+extern ScanImpl g_scan;
+
+// Detecta a CPU e escolhe, por uma calibração curta (~1 ms), a implementação
+// mais rápida disponível.
+void scan_init(void);
+
+// Força uma implementação pelo nome (benchmarks); false se indisponível.
+bool scan_select(const char *name);
+
+// Implementações disponíveis nesta CPU, da mais simples à mais larga.
+int scan_available(const ScanImpl **out, int max);
+
+// Tabela de tchar (RFC 9110 §5.6.2).
+extern const unsigned char scan_tchar_map[256];
+
+#endif
\ No newline at end of file
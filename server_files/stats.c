@@ -0,0 +1,326 @@
+// Métricas por worker, somadas na leitura.
+//
+// Cada thread tem seu fragmento (StatsShard) em memória local de thread; só
+// ela escreve nele, com stores relaxados (sem lock nem instrução atômica de
+// leitura-modificação-escrita), então contar um request custa o mesmo que
+// somar numa variável local e nenhuma linha de cache é disputada entre
+// workers. Quem atende /__stats percorre os fragmentos registrados e soma:
+// o retrato pode misturar instantes vizinhos, o que basta para métricas.
+//
+// Latências vão para histogramas log-lineares no estilo HDR: 16 faixas por
+// potência de 2 (erro relativo < 6%), de 1 ns a 2^40 ns, com memória fixa e
+// registro O(1). Os quantis saem da soma dos histogramas de todos os workers.
+
+#define _GNU_SOURCE
+#include "stats.h"
+#include "accesslog.h"
+#include "cache.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SUB_BITS     4
+#define SUB          (1 << SUB_BITS)                        // faixas por potência de 2
+#define HIST_EXP     40                                     // até 2^40 ns (~18 min)
+#define HIST_BUCKETS ((HIST_EXP - SUB_BITS + 1) * SUB)
+#define OUT_MIN_CAP  4096
+
+// Status contados um a um; o resto vai para "other".
+static const int g_codes[] = { 200, 206, 304, 400, 404, 405, 414, 416, 431, 505 };
+#define NCODES (sizeof(g_codes) / sizeof(g_codes[0]))
+
+static const char *const g_phase_names[STATS_PHASES] = { "parse", "resolve", "send" };
+
+typedef struct {
+    uint64_t count, sum;   // sum em ns
+    uint64_t b[HIST_BUCKETS];
+} Hist;
+
+typedef struct {
+    uint64_t status[NCODES + 1];
+    uint64_t bytes, opened, closed;
+    Hist     h[STATS_PHASES];
+} StatsShard;
+
+static __thread StatsShard t_shard;
+static __thread bool       t_registered;
+
+static StatsShard    **g_shards;
+static size_t          g_nshards;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool            g_timing;
+
+void stats_enable(void) {
+    g_timing = true;
+}
+
+bool stats_enabled(void) {
+    return g_timing;
+}
+
+void stats_register(void) {
+    if (t_registered) return;
+    pthread_mutex_lock(&g_lock);
+    StatsShard **tmp = (StatsShard **)realloc(g_shards, (g_nshards + 1) * sizeof(*tmp));
+    if (tmp) {
+        g_shards = tmp;
+        g_shards[g_nshards++] = &t_shard;
+        t_registered = true;
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+// Único escritor: lê o próprio valor normalmente e publica com store relaxado.
+static inline void add(uint64_t *p, uint64_t n) {
+    __atomic_store_n(p, *p + n, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t get(const uint64_t *p) {
+    return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+uint64_t stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Faixa de `v`: valores < 16 têm faixa própria; acima, o expoente escolhe a
+// potência de 2 e os 4 bits seguintes ao mais alto, a subfaixa.
+static unsigned bucket_of(uint64_t v) {
+    if (v < SUB) return (unsigned)v;
+    unsigned e = 63u - (unsigned)__builtin_clzll(v);
+    if (e >= HIST_EXP) return HIST_BUCKETS - 1;
+    return (e - SUB_BITS + 1) * SUB + (unsigned)((v >> (e - SUB_BITS)) & (SUB - 1));
+}
+
+// Meio da faixa `i` (o inverso de bucket_of).
+static uint64_t bucket_value(unsigned i) {
+    if (i < SUB) return i;
+    unsigned e = i / SUB + SUB_BITS - 1;
+    uint64_t width = 1ull << (e - SUB_BITS);
+    return (uint64_t)(SUB + i % SUB) * width + width / 2;
+}
+
+void stats_record(StatsPhase ph, uint64_t ns) {
+    Hist *h = &t_shard.h[ph];
+    add(&h->count, 1);
+    add(&h->sum, ns);
+    add(&h->b[bucket_of(ns)], 1);
+}
+
+void stats_count_status(int status) {
+    size_t i = 0;
+    while (i < NCODES && g_codes[i] != status) i++;
+    add(&t_shard.status[i], 1);
+}
+
+void stats_count_bytes(size_t n) {
+    add(&t_shard.bytes, n);
+}
+
+void stats_conn_opened(void) {
+    add(&t_shard.opened, 1);
+}
+
+void stats_conn_closed(void) {
+    add(&t_shard.closed, 1);
+}
+
+// -----------------------------------------------------------------------------
+// Leitura
+// -----------------------------------------------------------------------------
+
+static void sum_shards(StatsShard *t) {
+    memset(t, 0, sizeof(*t));
+    pthread_mutex_lock(&g_lock);
+    for (size_t k = 0; k < g_nshards; k++) {
+        const StatsShard *s = g_shards[k];
+        for (size_t i = 0; i <= NCODES; i++) t->status[i] += get(&s->status[i]);
+        t->bytes  += get(&s->bytes);
+        t->opened += get(&s->opened);
+        t->closed += get(&s->closed);
+        for (int p = 0; p < STATS_PHASES; p++) {
+            t->h[p].count += get(&s->h[p].count);
+            t->h[p].sum   += get(&s->h[p].sum);
+            for (unsigned i = 0; i < HIST_BUCKETS; i++) t->h[p].b[i] += get(&s->h[p].b[i]);
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+// Valor no quantil `q` (ns). A contagem é refeita a partir das faixas, que
+// podem estar um pouco adiante de h->count lido em outro instante.
+static uint64_t quantile(const Hist *h, double q) {
+    uint64_t n = 0;
+    for (unsigned i = 0; i < HIST_BUCKETS; i++) n += h->b[i];
+    if (n == 0) return 0;
+    uint64_t rank = (uint64_t)(q * (double)n + 0.999999);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->b[i];
+        if (seen >= rank) return bucket_value(i);
+    }
+    return bucket_value(HIST_BUCKETS - 1);
+}
+
+// Texto crescendo dentro da arena.
+typedef struct {
+    Arena  *a;
+    char   *p;
+    size_t  len, cap;
+    bool    fail;
+} Out;
+
+static void out(Out *o, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void out(Out *o, const char *fmt, ...) {
+    if (o->fail) return;
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(o->p + o->len, o->cap - o->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) { o->fail = true; return; }
+        if ((size_t)n < o->cap - o->len) { o->len += (size_t)n; return; }
+
+        size_t cap = o->cap * 2;
+        while (cap - o->len <= (size_t)n) cap *= 2;
+        char *p = (char *)arena_grow(o->a, o->p, o->cap, cap);
+        if (!p) { o->fail = true; return; }
+        o->p = p;
+        o->cap = cap;
+    }
+}
+
+static const double g_quantiles[] = { 0.5, 0.99, 0.999 };
+
+static void render_prometheus(Out *o, const StatsShard *t, const CacheStats *cs,
+                              const ArenaStats *as) {
+    out(o, "# HELP httptools_requests_total Requests atendidos, por status.\n"
+           "# TYPE httptools_requests_total counter\n");
+    for (size_t i = 0; i < NCODES; i++)
+        out(o, "httptools_requests_total{code=\"%d\"} %llu\n",
+            g_codes[i], (unsigned long long)t->status[i]);
+    out(o, "httptools_requests_total{code=\"other\"} %llu\n",
+        (unsigned long long)t->status[NCODES]);
+
+    out(o, "# HELP httptools_sent_bytes_total Bytes entregues aos sockets.\n"
+           "# TYPE httptools_sent_bytes_total counter\n"
+           "httptools_sent_bytes_total %llu\n", (unsigned long long)t->bytes);
+    out(o, "# HELP httptools_connections_active Conexões abertas agora.\n"
+           "# TYPE httptools_connections_active gauge\n"
+           "httptools_connections_active %llu\n"
+           "# HELP httptools_connections_total Conexões aceitas.\n"
+           "# TYPE httptools_connections_total counter\n"
+           "httptools_connections_total %llu\n",
+        (unsigned long long)(t->opened - t->closed), (unsigned long long)t->opened);
+
+    if (cs) {
+        uint64_t total = cs->hits + cs->misses;
+        out(o, "# HELP httptools_cache_hits_total Acertos do cache de respostas.\n"
+               "# TYPE httptools_cache_hits_total counter\n"
+               "httptools_cache_hits_total %llu\n"
+               "# HELP httptools_cache_misses_total Faltas do cache de respostas.\n"
+               "# TYPE httptools_cache_misses_total counter\n"
+               "httptools_cache_misses_total %llu\n"
+               "# HELP httptools_cache_hit_ratio Acertos / consultas desde a partida.\n"
+               "# TYPE httptools_cache_hit_ratio gauge\n"
+               "httptools_cache_hit_ratio %.4f\n"
+               "# HELP httptools_cache_bytes Bytes no cache.\n"
+               "# TYPE httptools_cache_bytes gauge\n"
+               "httptools_cache_bytes %zu\n",
+            (unsigned long long)cs->hits, (unsigned long long)cs->misses,
+            total ? (double)cs->hits / (double)total : 0.0, cs->bytes);
+    }
+
+    if (accesslog_enabled()) {
+        AccessLogStats ls;
+        accesslog_stats(&ls);
+        out(o, "# HELP httptools_log_dropped_total Registros do log de acesso descartados (anel cheio).\n"
+               "# TYPE httptools_log_dropped_total counter\n"
+               "httptools_log_dropped_total %llu\n", (unsigned long long)ls.dropped);
+    }
+
+    out(o, "# HELP httptools_heap_allocs_total mallocs feitos por arenas e pools.\n"
+           "# TYPE httptools_heap_allocs_total counter\n"
+           "httptools_heap_allocs_total %llu\n", (unsigned long long)as->heap_allocs);
+
+    out(o, "# HELP httptools_phase_seconds Latência por fase do atendimento.\n"
+           "# TYPE httptools_phase_seconds summary\n");
+    for (int p = 0; p < STATS_PHASES; p++) {
+        const Hist *h = &t->h[p];
+        for (size_t k = 0; k < sizeof(g_quantiles) / sizeof(g_quantiles[0]); k++)
+            out(o, "httptools_phase_seconds{phase=\"%s\",quantile=\"%g\"} %.9f\n",
+                g_phase_names[p], g_quantiles[k], (double)quantile(h, g_quantiles[k]) / 1e9);
+        out(o, "httptools_phase_seconds_sum{phase=\"%s\"} %.9f\n"
+               "httptools_phase_seconds_count{phase=\"%s\"} %llu\n",
+            g_phase_names[p], (double)h->sum / 1e9,
+            g_phase_names[p], (unsigned long long)h->count);
+    }
+}
+
+static void render_json(Out *o, const StatsShard *t, const CacheStats *cs,
+                        const ArenaStats *as) {
+    out(o, "{\"requests\":{");
+    for (size_t i = 0; i < NCODES; i++)
+        out(o, "\"%d\":%llu,", g_codes[i], (unsigned long long)t->status[i]);
+    out(o, "\"other\":%llu},", (unsigned long long)t->status[NCODES]);
+    out(o, "\"bytes_sent\":%llu,\"connections\":{\"active\":%llu,\"total\":%llu},",
+        (unsigned long long)t->bytes, (unsigned long long)(t->opened - t->closed),
+        (unsigned long long)t->opened);
+
+    if (cs) {
+        uint64_t total = cs->hits + cs->misses;
+        out(o, "\"cache\":{\"hits\":%llu,\"misses\":%llu,\"hit_ratio\":%.4f,"
+               "\"entries\":%zu,\"bytes\":%zu},",
+            (unsigned long long)cs->hits, (unsigned long long)cs->misses,
+            total ? (double)cs->hits / (double)total : 0.0, cs->entries, cs->bytes);
+    } else {
+        out(o, "\"cache\":null,");
+    }
+    out(o, "\"heap_allocs\":%llu,", (unsigned long long)as->heap_allocs);
+    if (accesslog_enabled()) {
+        AccessLogStats ls;
+        accesslog_stats(&ls);
+        out(o, "\"log\":{\"written\":%llu,\"dropped\":%llu},",
+            (unsigned long long)ls.written, (unsigned long long)ls.dropped);
+    }
+
+    out(o, "\"latency_us\":{");
+    for (int p = 0; p < STATS_PHASES; p++) {
+        const Hist *h = &t->h[p];
+        out(o, "%s\"%s\":{\"count\":%llu,\"mean\":%.3f,\"p50\":%.3f,\"p99\":%.3f,\"p999\":%.3f}",
+            p ? "," : "", g_phase_names[p], (unsigned long long)h->count,
+            h->count ? (double)h->sum / (double)h->count / 1e3 : 0.0,
+            (double)quantile(h, 0.5) / 1e3, (double)quantile(h, 0.99) / 1e3,
+            (double)quantile(h, 0.999) / 1e3);
+    }
+    out(o, "}}");
+}
+
+char *stats_render(Arena *a, bool json, size_t *len) {
+    StatsShard *t = (StatsShard *)arena_alloc(a, sizeof(*t));
+    if (!t) return NULL;
+    sum_shards(t);
+
+    CacheStats cs;
+    bool cached = cache_enabled();
+    if (cached) cache_stats(&cs);
+    ArenaStats as;
+    arena_stats(&as);
+
+    Out o = { .a = a, .cap = OUT_MIN_CAP };
+    o.p = (char *)arena_alloc(a, o.cap);
+    if (!o.p) return NULL;
+    o.p[0] = '\0';
+    if (json) render_json(&o, t, cached ? &cs : NULL, &as);
+    else      render_prometheus(&o, t, cached ? &cs : NULL, &as);
+    if (o.fail) return NULL;
+    *len = o.len;
+    return o.p;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+// server_files/stats.h
+// Métricas do servidor: requests por status, bytes enviados, conexões ativas
+// e histogramas de latência por fase. Cada worker escreve só no seu próprio
+// fragmento (sem travas nem atômicos com lock); a leitura soma todos.
+#ifndef STATS_H
+#define STATS_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+typedef enum {
+    STATS_PARSE,     // tempo dentro do parser até o request ficar completo
+    STATS_RESOLVE,   // request completo -> resposta enfileirada (caminho, cache, open)
+    STATS_SEND,      // resposta enfileirada -> fila de saída vazia
+    STATS_PHASES
+} StatsPhase;
+
+// Liga a medição de tempos (os contadores estão sempre ativos: custam uma
+// soma na memória da própria thread).
+void stats_enable(void);
+bool stats_enabled(void);
+
+// Inclui o fragmento da thread atual na soma. Chamado por cada worker ao subir.
+void stats_register(void);
+
+uint64_t stats_now(void);                       // ns, CLOCK_MONOTONIC
+void stats_record(StatsPhase ph, uint64_t ns);
+void stats_count_status(int status);
+void stats_count_bytes(size_t n);
+void stats_conn_opened(void);
+void stats_conn_closed(void);
+
+// Relatório em texto do Prometheus (ou JSON), montado na arena.
+char *stats_render(Arena *a, bool json, size_t *len);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+// Roda de temporizadores hierárquica.
+//
+// Nível 0 tem uma posição por tick; cada nível acima cobre 64 vezes mais
+// tempo por posição. Um temporizador entra no nível mais baixo cujo alcance
+// contém o prazo, na posição dada pelos bits do tick absoluto de expiração.
+// Quando o índice de um nível dá a volta, a posição correspondente do nível
+// acima desce (cascata) e cada temporizador é reposto mais perto do nível 0.
+// Armar e desarmar são inserção/remoção em lista duplamente ligada; cada
+// tick visita uma posição por nível que deu a volta. Um temporizador desce no
+// máximo TW_LEVELS - 1 vezes, e a maioria (prazos que são renovados ou
+// desarmados antes de vencer) nunca desce.
+
+#include "timer.h"
+
+#define TW_MASK (TW_SLOTS - 1)
+
+static void list_init(Timer *head) {
+    head->next = head->prev = head;
+}
+
+static void list_unlink(Timer *t) {
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
+    t->next = t->prev = NULL;
+}
+
+// Posição de `t` conforme a distância entre o prazo e tw->now.
+static void place(TimerWheel *tw, Timer *t) {
+    uint64_t delta = t->expires - tw->now;
+    int lvl = 0;
+    while (lvl < TW_LEVELS - 1 && delta >= (uint64_t)1 << (TW_BITS * (lvl + 1))) lvl++;
+
+    Timer *head = &tw->slots[lvl][(t->expires >> (TW_BITS * lvl)) & TW_MASK];
+    t->prev = head->prev;
+    t->next = head;
+    head->prev->next = t;
+    head->prev = t;
+}
+
+void timer_wheel_init(TimerWheel *tw, uint64_t now) {
+    tw->now = now;
+    tw->count = 0;
+    for (int l = 0; l < TW_LEVELS; l++)
+        for (unsigned s = 0; s < TW_SLOTS; s++) list_init(&tw->slots[l][s]);
+}
+
+void timer_add(TimerWheel *tw, Timer *t, uint64_t expires) {
+    if (timer_armed(t)) list_unlink(t); else tw->count++;
+
+    uint64_t max = tw->now + ((uint64_t)1 << (TW_BITS * TW_LEVELS)) - 1;
+    if (expires <= tw->now) expires = tw->now + 1;
+    if (expires > max) expires = max;
+    t->expires = expires;
+    place(tw, t);
+}
+
+void timer_del(TimerWheel *tw, Timer *t) {
+    if (!timer_armed(t)) return;
+    list_unlink(t);
+    tw->count--;
+}
+
+// Desce a posição `slot` do nível `lvl`: todos os prazos nela vencem dentro
+// do alcance dos níveis abaixo.
+static void cascade(TimerWheel *tw, int lvl, unsigned slot) {
+    Timer *head = &tw->slots[lvl][slot];
+    while (head->next != head) {
+        Timer *t = head->next;
+        list_unlink(t);
+        place(tw, t);
+    }
+}
+
+void timer_advance(TimerWheel *tw, uint64_t now, TimerFn fn, void *arg) {
+    while (tw->now < now) {
+        // Roda vazia: nada a descer nem a expirar, salta direto
+        if (tw->count == 0) { tw->now = now; return; }
+
+        uint64_t tick = ++tw->now;
+
+        // Do nível mais alto que deu a volta para baixo: o que desce do nível
+        // 2 pode cair justamente na posição do nível 1 que desce agora
+        int top = 0;
+        while (top < TW_LEVELS - 1 && (tick & (((uint64_t)1 << (TW_BITS * (top + 1))) - 1)) == 0) top++;
+        for (int l = top; l >= 1; l--)
+            cascade(tw, l, (unsigned)(tick >> (TW_BITS * l)) & TW_MASK);
+
+        // Quem fn rearmar vai para um tick futuro, nunca para esta posição
+        Timer *head = &tw->slots[0][tick & TW_MASK];
+        while (head->next != head) {
+            Timer *t = head->next;
+            list_unlink(t);
+            tw->count--;
+            fn(t, arg);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+// server_files/timer.h
+// Roda de temporizadores hierárquica (um por worker): armar, desarmar e
+// expirar custam O(1), sem chamada de sistema por temporizador. O tempo é
+// contado em ticks; quem usa decide a duração de um tick e avança a roda.
+#ifndef TIMER_H
+#define TIMER_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TW_BITS   6
+#define TW_SLOTS  (1u << TW_BITS)   // posições por nível
+#define TW_LEVELS 4                 // alcance: 64^4 ticks (prazos maiores são truncados)
+
+// Intrusivo: embutido no objeto que expira (ver Conn). Zerado = desarmado.
+typedef struct Timer {
+    struct Timer *next, *prev;
+    uint64_t      expires;   // tick absoluto
+} Timer;
+
+typedef struct {
+    uint64_t now;                          // último tick processado
+    size_t   count;                        // temporizadores armados
+    Timer    slots[TW_LEVELS][TW_SLOTS];   // sentinelas das listas
+} TimerWheel;
+
+typedef void (*TimerFn)(Timer *t, void *arg);
+
+void timer_wheel_init(TimerWheel *tw, uint64_t now);
+
+// Arma (ou rearma) `t` para o tick `expires`; um prazo já vencido expira no
+// próximo tick.
+void timer_add(TimerWheel *tw, Timer *t, uint64_t expires);
+void timer_del(TimerWheel *tw, Timer *t);
+
+static inline bool timer_armed(const Timer *t) {
+    return t->next != NULL;
+}
+
+// Processa os ticks até `now`, chamando fn(t, arg) para cada vencido. O
+// temporizador já está desarmado na chamada; fn pode rearmá-lo ou liberar o
+// objeto que o contém.
+void timer_advance(TimerWheel *tw, uint64_t now, TimerFn fn, void *arg);
+
+#endif
\ No newline at end of file
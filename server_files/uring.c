@@ -0,0 +1,231 @@
+// io_uring por syscalls cruas (o projeto não usa bibliotecas externas).
+//
+// Os três mapeamentos seguem io_uring_setup(2): anel de submissão (índices +
+// vetor de posições), vetor de SQEs e anel de conclusão, que na maioria dos
+// kernels vem no mesmo mapeamento do primeiro (IORING_FEAT_SINGLE_MMAP). As
+// posições do vetor de submissão são fixadas uma vez (identidade), então
+// enfileirar é só preencher a SQE e avançar a cauda.
+
+#define _GNU_SOURCE
+#include "uring.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int sys_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_enter(int fd, unsigned submit, unsigned wait_nr, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, submit, wait_nr, flags, NULL, 0);
+}
+
+static int sys_register(int fd, unsigned op, void *arg, unsigned n) {
+    return (int)syscall(__NR_io_uring_register, fd, op, arg, n);
+}
+
+// -----------------------------------------------------------------------------
+// Anel
+// -----------------------------------------------------------------------------
+
+static int setup_with(unsigned entries, unsigned flags, struct io_uring_params *p) {
+    memset(p, 0, sizeof(*p));
+    p->flags = flags | IORING_SETUP_CQSIZE;
+    p->cq_entries = entries * 4;   // folga para rajadas de conclusões
+    return sys_setup(entries, p);
+}
+
+bool uring_init(Uring *r, unsigned entries) {
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+
+    static const unsigned tries[] = {
+        IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN,   // 6.1+
+        IORING_SETUP_COOP_TASKRUN,                                  // 5.19+
+        0,
+    };
+    struct io_uring_params p;
+    for (size_t i = 0; i < sizeof(tries) / sizeof(tries[0]) && r->fd < 0; i++) {
+        r->fd = setup_with(entries, tries[i], &p);
+        r->setup_flags = tries[i];
+    }
+    if (r->fd < 0) return false;
+
+    r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+        if (r->cq_len > r->sq_len) r->sq_len = r->cq_len;
+        r->cq_len = r->sq_len;
+    }
+
+    r->sq_ptr = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     r->fd, IORING_OFF_SQ_RING);
+    if (r->sq_ptr == MAP_FAILED) { r->sq_ptr = NULL; uring_exit(r); return false; }
+    if (single) {
+        r->cq_ptr = r->sq_ptr;
+    } else {
+        r->cq_ptr = mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         r->fd, IORING_OFF_CQ_RING);
+        if (r->cq_ptr == MAP_FAILED) { r->cq_ptr = NULL; uring_exit(r); return false; }
+    }
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = (struct io_uring_sqe *)mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE,
+                                          MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) { r->sqes = NULL; uring_exit(r); return false; }
+
+    char *sq = (char *)r->sq_ptr, *cq = (char *)r->cq_ptr;
+    r->sq_head    = (unsigned *)(sq + p.sq_off.head);
+    r->sq_tail    = (unsigned *)(sq + p.sq_off.tail);
+    r->sq_mask    = (unsigned *)(sq + p.sq_off.ring_mask);
+    r->sq_array   = (unsigned *)(sq + p.sq_off.array);
+    r->sq_entries = p.sq_entries;
+    r->cq_head    = (unsigned *)(cq + p.cq_off.head);
+    r->cq_tail    = (unsigned *)(cq + p.cq_off.tail);
+    r->cq_mask    = (unsigned *)(cq + p.cq_off.ring_mask);
+    r->cqes       = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    for (unsigned i = 0; i < p.sq_entries; i++) r->sq_array[i] = i;
+    r->sqe_tail = *r->sq_tail;
+    return true;
+}
+
+void uring_exit(Uring *r) {
+    if (r->sqes) munmap(r->sqes, r->sqes_len);
+    if (r->cq_ptr && r->cq_ptr != r->sq_ptr) munmap(r->cq_ptr, r->cq_len);
+    if (r->sq_ptr) munmap(r->sq_ptr, r->sq_len);
+    if (r->fd >= 0) close(r->fd);
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+}
+
+struct io_uring_sqe *uring_sqe(Uring *r) {
+    for (;;) {
+        unsigned head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+        if (r->sqe_tail - head < r->sq_entries) {
+            struct io_uring_sqe *sqe = &r->sqes[r->sqe_tail & *r->sq_mask];
+            r->sqe_tail++;
+            memset(sqe, 0, sizeof(*sqe));
+            return sqe;
+        }
+        int s = uring_submit(r, 0);
+        if (s < 0 && s != -EINTR && s != -EBUSY) return NULL;
+    }
+}
+
+bool uring_reserve(Uring *r, unsigned n) {
+    for (;;) {
+        unsigned head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+        if (r->sq_entries - (r->sqe_tail - head) >= n) return true;
+        int s = uring_submit(r, 0);
+        if (s < 0 && s != -EINTR && s != -EBUSY) return false;
+    }
+}
+
+int uring_submit(Uring *r, unsigned wait_nr) {
+    __atomic_store_n(r->sq_tail, r->sqe_tail, __ATOMIC_RELEASE);
+    unsigned pending = r->sqe_tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+    unsigned flags = wait_nr ? IORING_ENTER_GETEVENTS : 0;
+    // DEFER_TASKRUN só completa trabalho pendente quando pedimos eventos
+    if (r->setup_flags & IORING_SETUP_DEFER_TASKRUN) flags |= IORING_ENTER_GETEVENTS;
+    int n = sys_enter(r->fd, pending, wait_nr, flags);
+    return n < 0 ? -errno : n;
+}
+
+struct io_uring_cqe *uring_cqe(Uring *r) {
+    unsigned head = *r->cq_head;
+    if (head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) return NULL;
+    return &r->cqes[head & *r->cq_mask];
+}
+
+void uring_cqe_seen(Uring *r) {
+    __atomic_store_n(r->cq_head, *r->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+// -----------------------------------------------------------------------------
+// Buffers fornecidos
+// -----------------------------------------------------------------------------
+
+bool uring_bufs_init(Uring *r, UringBufs *b, uint16_t bgid, unsigned entries, size_t size) {
+    memset(b, 0, sizeof(*b));
+    size_t ring_len = entries * sizeof(struct io_uring_buf);
+    void *ring = mmap(NULL, ring_len, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    void *mem = mmap(NULL, entries * size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (ring == MAP_FAILED || mem == MAP_FAILED) {
+        if (ring != MAP_FAILED) munmap(ring, ring_len);
+        if (mem != MAP_FAILED) munmap(mem, entries * size);
+        return false;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)ring;
+    reg.ring_entries = entries;
+    reg.bgid = bgid;
+    if (sys_register(r->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        munmap(ring, ring_len);
+        munmap(mem, entries * size);
+        return false;
+    }
+
+    b->br = (struct io_uring_buf_ring *)ring;
+    b->mem = (char *)mem;
+    b->entries = entries;
+    b->size = size;
+    b->bgid = bgid;
+    for (unsigned i = 0; i < entries; i++) uring_buf_recycle(b, i);
+    return true;
+}
+
+char *uring_buf(const UringBufs *b, unsigned bid) {
+    return b->mem + (size_t)bid * b->size;
+}
+
+void uring_buf_recycle(UringBufs *b, unsigned bid) {
+    struct io_uring_buf *e = &b->br->bufs[b->tail & (b->entries - 1)];
+    e->addr = (uint64_t)(uintptr_t)uring_buf(b, bid);
+    e->len = (uint32_t)b->size;
+    e->bid = (uint16_t)bid;
+    b->tail++;
+    __atomic_store_n(&b->br->tail, b->tail, __ATOMIC_RELEASE);
+}
+
+// -----------------------------------------------------------------------------
+// Sondagem
+// -----------------------------------------------------------------------------
+
+bool uring_supported(const char **why) {
+    Uring r;
+    if (!uring_init(&r, 8)) {
+        *why = (errno == ENOSYS) ? "kernel sem io_uring" : "io_uring_setup recusado";
+        return false;
+    }
+
+    // Operações usadas pelo backend
+    static const unsigned ops[] = {
+        IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SENDMSG, IORING_OP_SPLICE, IORING_OP_TIMEOUT,
+    };
+    size_t plen = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    char pbuf[sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op)];
+    memset(pbuf, 0, plen);
+    struct io_uring_probe *probe = (struct io_uring_probe *)pbuf;
+    bool ok = sys_register(r.fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+    for (size_t i = 0; ok && i < sizeof(ops) / sizeof(ops[0]); i++)
+        ok = ops[i] <= probe->last_op && (probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED);
+    if (!ok) { *why = "operações necessárias ausentes"; uring_exit(&r); return false; }
+
+    // Anel de buffers e aceitação multishot chegaram juntos (5.19)
+    UringBufs b;
+    if (!uring_bufs_init(&r, &b, 0, 8, 64)) {
+        *why = "sem anel de buffers (kernel < 5.19)";
+        uring_exit(&r);
+        return false;
+    }
+    uring_exit(&r);
+    munmap(b.br, b.entries * sizeof(struct io_uring_buf));
+    munmap(b.mem, b.entries * b.size);
+    return true;
+}
\ No newline at end of file
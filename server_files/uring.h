@@ -0,0 +1,73 @@
+// server_files/uring.h
+// Acesso mínimo ao io_uring sem liburing: syscalls cruas, anéis mapeados com
+// mmap e um anel de buffers fornecidos (provided buffers) para recepção.
+#ifndef URING_H
+#define URING_H
+#include <linux/io_uring.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    int       fd;
+    // Fila de submissão
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned  sq_entries;
+    unsigned  sqe_tail;                 // próxima SQE livre (local)
+    struct io_uring_sqe *sqes;
+    // Fila de conclusão
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+    // Mapeamentos (para desfazer)
+    void     *sq_ptr, *cq_ptr;
+    size_t    sq_len, cq_len, sqes_len;
+    unsigned  setup_flags;
+} Uring;
+
+// Anel de buffers fornecidos: o kernel escolhe um buffer livre a cada
+// recepção (IOSQE_BUFFER_SELECT) e o devolve pelo id no CQE.
+typedef struct {
+    struct io_uring_buf_ring *br;
+    char     *mem;
+    unsigned  entries;
+    size_t    size;                     // bytes por buffer
+    uint16_t  bgid, tail;
+} UringBufs;
+
+// Cria um anel com `entries` SQEs. Tenta primeiro o modo de emissor único
+// (SINGLE_ISSUER + DEFER_TASKRUN), que exige ser chamado na thread que vai
+// usar o anel. false (errno) se o kernel não tem io_uring.
+bool uring_init(Uring *r, unsigned entries);
+void uring_exit(Uring *r);
+
+// Próxima SQE zerada; se a fila estiver cheia, submete o que houver antes.
+struct io_uring_sqe *uring_sqe(Uring *r);
+
+// Garante `n` SQEs livres, submetendo antes se preciso: uma cadeia
+// IOSQE_IO_LINK não pode ser cortada por uma submissão no meio.
+bool uring_reserve(Uring *r, unsigned n);
+
+// Submete as SQEs pendentes e espera ao menos `wait_nr` conclusões.
+// Devolve o nº de SQEs aceitas ou -errno (EINTR incluído).
+int uring_submit(Uring *r, unsigned wait_nr);
+
+// Próximo CQE pronto (NULL se nenhum); uring_cqe_seen() o consome.
+struct io_uring_cqe *uring_cqe(Uring *r);
+void uring_cqe_seen(Uring *r);
+
+bool uring_bufs_init(Uring *r, UringBufs *b, uint16_t bgid, unsigned entries, size_t size);
+char *uring_buf(const UringBufs *b, unsigned bid);
+void uring_buf_recycle(UringBufs *b, unsigned bid);
+
+// Confere se o kernel tem tudo o que o backend usa (aceitação multishot,
+// anel de buffers, splice); em caso negativo preenche `why`.
+bool uring_supported(const char **why);
+
+// user_data: ponteiro (alinhado a 8) + tipo da operação nos 3 bits baixos.
+static inline uint64_t uring_tag(const void *p, unsigned op) {
+    return (uint64_t)(uintptr_t)p | op;
+}
+static inline void *uring_tag_ptr(uint64_t ud) { return (void *)(uintptr_t)(ud & ~(uint64_t)7); }
+static inline unsigned uring_tag_op(uint64_t ud) { return (unsigned)(ud & 7); }
+
+#endif
\ No newline at end of file
@@ -1,51 +1,30 @@
-// Utilitários do servidor: MIME type, URL decode e respostas HTTP básicas.
+// Utilitários do servidor: MIME type, URL decode, cabeçalhos de request,
+// validadores (ETag/Last-Modified) e respostas HTTP básicas.
 
+#define _GNU_SOURCE
 #include "util.h"
+#include "mime.h"
 
 #include <ctype.h>      
-#include <stdarg.h>     
 #include <stdbool.h>
 #include <stdio.h>      
 #include <stdlib.h>     
 #include <string.h>     
 #include <strings.h>    
-#include <sys/socket.h> 
-
-#define SEND_BUF 8192
+#include <time.h>
 
 // -----------------------------------------------------------------------------
-// Helper: envia uma string formatada direto no socket (printf-like).
+// Deduz o Content-Type pela extensão do arquivo (tabela em mime.c).
 // -----------------------------------------------------------------------------
-static void sendf(int fd, const char *fmt, ...) {
-    char buf[SEND_BUF];
-    va_list ap;
-    va_start(ap, fmt);
-    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
-    va_end(ap);
-    if (n > 0) (void)send(fd, buf, (size_t)n, 0);
+const char *util_mime_type(const char *path) {
+    return mime_lookup(path);
 }
 
 // -----------------------------------------------------------------------------
-// Deduz um Content-Type simples pela extensão do arquivo.
+// Tipos que valem a pena comprimir (texto e formatos baseados em texto).
 // -----------------------------------------------------------------------------
-const char *util_mime_type(const char *path) {
-    const char *ext = strrchr(path, '.');
-    if (!ext) return "application/octet-stream";
-    ext++; // pula o ponto
-
-    if (!strcasecmp(ext, "html") || !strcasecmp(ext, "htm")) return "text/html; charset=utf-8";
-    if (!strcasecmp(ext, "css"))  return "text/css; charset=utf-8";
-    if (!strcasecmp(ext, "js"))   return "application/javascript; charset=utf-8";
-    if (!strcasecmp(ext, "json")) return "application/json; charset=utf-8";
-    if (!strcasecmp(ext, "txt"))  return "text/plain; charset=utf-8";
-    if (!strcasecmp(ext, "png"))  return "image/png";
-    if (!strcasecmp(ext, "jpg") || !strcasecmp(ext, "jpeg")) return "image/jpeg";
-    if (!strcasecmp(ext, "gif"))  return "image/gif";
-    if (!strcasecmp(ext, "svg"))  return "image/svg+xml";
-    if (!strcasecmp(ext, "pdf"))  return "application/pdf";
-    if (!strcasecmp(ext, "ico"))  return "image/x-icon";
-
-    return "application/octet-stream";
+bool util_mime_compressible(const char *ctype) {
+    return mime_compressible(ctype);
 }
 
 // -----------------------------------------------------------------------------
@@ -66,47 +45,339 @@ void util_url_decode(char *s) {
 }
 
 // -----------------------------------------------------------------------------
-// Envia cabeçalhos HTTP básicos e a linha em branco final.
+// Copia para `out` o valor (cru, sem decodificar) do parâmetro `name` na
+// query string "a=1&b=2". Parâmetro sem "=" vale "". false se ausente ou
+// maior que `cap`.
+// -----------------------------------------------------------------------------
+bool util_query_param(const char *query, const char *name, char *out, size_t cap) {
+    size_t nl = strlen(name);
+    const char *p = query;
+    while (p && *p) {
+        const char *amp = strchr(p, '&');
+        size_t len = amp ? (size_t)(amp - p) : strlen(p);
+        if (len >= nl && !strncmp(p, name, nl) && (len == nl || p[nl] == '=')) {
+            size_t vl = (len == nl) ? 0 : len - nl - 1;
+            if (vl >= cap) return false;
+            memcpy(out, p + len - vl, vl);
+            out[vl] = '\0';
+            return true;
+        }
+        p = amp ? amp + 1 : NULL;
+    }
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Valor do cabeçalho `name` no request já interpretado (sem espaços nas
+// pontas, não terminado em NUL) e seu tamanho; NULL se ausente.
 // -----------------------------------------------------------------------------
-void util_send_headers(int fd, const char *status, const char *ctype, long content_length) {
-    sendf(fd,
+const char *util_find_header(const HttpRequest *req, const char *name, size_t *len) {
+    return req_header(req, name, len);
+}
+
+// -----------------------------------------------------------------------------
+// true se a lista separada por vírgulas `v` contém `token` (sem diferenciar caixa).
+// -----------------------------------------------------------------------------
+bool util_header_has_token(const char *v, size_t len, const char *token) {
+    size_t tl = strlen(token);
+    const char *end = v + len;
+    while (v < end) {
+        while (v < end && (*v == ' ' || *v == ',')) v++;
+        const char *t = v;
+        while (v < end && *v != ',') v++;
+        const char *te = v;
+        while (te > t && te[-1] == ' ') te--;
+        if ((size_t)(te - t) == tl && !strncasecmp(t, token, tl)) return true;
+    }
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Accept-Encoding -> máscara ENC_*. Codificações com "q=0" são recusadas;
+// "*" vale como gzip.
+// -----------------------------------------------------------------------------
+unsigned util_accept_encoding(const HttpRequest *req) {
+    if (!req) return 0;
+    size_t len;
+    const char *v = util_find_header(req, "Accept-Encoding", &len);
+    if (!v) return 0;
+
+    unsigned mask = 0;
+    const char *end = v + len;
+    while (v < end) {
+        while (v < end && (*v == ' ' || *v == ',')) v++;
+        const char *t = v;
+        while (v < end && *v != ',' && *v != ';' && *v != ' ') v++;
+        size_t tl = (size_t)(v - t);
+
+        // Parâmetro q (apenas "q=0", "q=0.0"... importa)
+        bool refused = false;
+        const char *item_end = v;
+        while (item_end < end && *item_end != ',') item_end++;
+        const char *q = t;
+        while (q + 1 < item_end && !(q[0] == 'q' && q[1] == '=')) q++;
+        if (q + 1 < item_end) {
+            q += 2;
+            refused = (*q == '0');
+            for (q++; refused && q < item_end && *q != ' '; q++)
+                if (*q != '.' && *q != '0') refused = false;
+        }
+        v = item_end;
+        if (refused) continue;
+
+        if ((tl == 4 && !strncasecmp(t, "gzip", 4)) || (tl == 1 && *t == '*')) mask |= ENC_GZIP;
+        else if (tl == 2 && !strncasecmp(t, "br", 2)) mask |= ENC_BR;
+    }
+    return mask;
+}
+
+// -----------------------------------------------------------------------------
+// ETag (inode + tamanho + mtime em ns) e Last-Modified de um arquivo.
+// -----------------------------------------------------------------------------
+void util_validators(const struct stat *st, Validators *v) {
+    unsigned long long mtime_ns =
+        (unsigned long long)st->st_mtim.tv_sec * 1000000000ULL + (unsigned long long)st->st_mtim.tv_nsec;
+    snprintf(v->etag, sizeof(v->etag), "\"%llx-%llx-%llx\"",
+             (unsigned long long)st->st_ino, (unsigned long long)st->st_size, mtime_ns);
+
+    struct tm tm;
+    v->mtime = st->st_mtim.tv_sec;
+    gmtime_r(&v->mtime, &tm);
+    strftime(v->last_modified, sizeof(v->last_modified), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+}
+
+// Cabeçalhos de representação de um arquivo: "ETag", "Last-Modified" e
+// "Accept-Ranges"; retorna o tamanho ou -1 se não couber.
+int util_format_file_headers(char *buf, size_t cap, const Validators *v) {
+    int n = snprintf(buf, cap, "ETag: %s\r\nLast-Modified: %s\r\nAccept-Ranges: bytes\r\n",
+                     v->etag, v->last_modified);
+    return (n < 0 || (size_t)n >= cap) ? -1 : n;
+}
+
+// Converte um HTTP-date (IMF-fixdate) em time_t; false se inválido.
+static bool parse_http_date(const char *s, size_t len, time_t *out) {
+    char tmp[64];
+    if (len >= sizeof(tmp)) return false;
+    memcpy(tmp, s, len); tmp[len] = '\0';
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    const char *end = strptime(tmp, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    if (!end || *end) return false;
+    *out = timegm(&tm);
+    return true;
+}
+
+// Compara uma entity-tag da lista com a nossa (comparação fraca: ignora "W/").
+static bool etag_matches(const char *t, size_t tl, const char *etag) {
+    if (tl >= 2 && t[0] == 'W' && t[1] == '/') { t += 2; tl -= 2; }
+    return tl == strlen(etag) && !memcmp(t, etag, tl);
+}
+
+// -----------------------------------------------------------------------------
+// Avalia If-None-Match / If-Modified-Since (RFC 9110 §13.1). If-None-Match tem
+// precedência: se presente, If-Modified-Since é ignorado.
+// -----------------------------------------------------------------------------
+bool util_not_modified(const HttpRequest *req, const Validators *v) {
+    if (!req) return false;
+    size_t len;
+    const char *inm = util_find_header(req, "If-None-Match", &len);
+    if (inm) {
+        const char *end = inm + len;
+        while (inm < end) {
+            while (inm < end && (*inm == ' ' || *inm == ',')) inm++;
+            const char *t = inm;
+            while (inm < end && *inm != ',') inm++;
+            const char *te = inm;
+            while (te > t && te[-1] == ' ') te--;
+            if ((te - t == 1 && *t == '*') || etag_matches(t, (size_t)(te - t), v->etag))
+                return true;
+        }
+        return false;
+    }
+
+    const char *ims = util_find_header(req, "If-Modified-Since", &len);
+    time_t t;
+    if (ims && parse_http_date(ims, len, &t)) return v->mtime <= t;
+    return false;   // ausente ou data inválida: ignora o cabeçalho
+}
+
+// Lê um inteiro decimal não negativo em [*p, end); false se não houver dígitos.
+static bool parse_off(const char **p, const char *end, off_t *out) {
+    const char *s = *p;
+    off_t v = 0;
+    while (s < end && *s >= '0' && *s <= '9') {
+        if (v > (off_t)(0x7fffffffffffffffLL / 10) - 1) return false;
+        v = v * 10 + (*s - '0');
+        s++;
+    }
+    if (s == *p) return false;
+    *p = s; *out = v;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Interpreta "Range: bytes=..." (RFC 9110 §14) para um corpo de `size` bytes.
+// Aceita "a-b", "a-" e sufixos "-n". Retorna o nº de faixas válidas, 0 para
+// responder o arquivo inteiro (sem Range, If-Range desatualizado, sintaxe
+// desconhecida ou faixas demais) e -1 se nenhuma faixa é satisfatível (416).
+// -----------------------------------------------------------------------------
+int util_parse_ranges(const HttpRequest *req, off_t size, const Validators *v, ByteRange *out, int max) {
+    if (!req) return 0;
+    size_t len;
+    const char *p = util_find_header(req, "Range", &len);
+    if (!p) return 0;
+
+    // If-Range: só vale a faixa se a representação for a mesma que o cliente tem
+    size_t il;
+    const char *ir = util_find_header(req, "If-Range", &il);
+    if (ir) {
+        if (ir[0] == '"') {
+            if (il != strlen(v->etag) || memcmp(ir, v->etag, il)) return 0;
+        } else {
+            time_t t;
+            if (!parse_http_date(ir, il, &t) || t != v->mtime) return 0;
+        }
+    }
+
+    const char *end = p + len;
+    if (len < 6 || strncasecmp(p, "bytes=", 6)) return 0;
+    p += 6;
+
+    int n = 0;
+    bool any = false;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == ',')) p++;
+        if (p >= end) break;
+        any = true;
+
+        off_t first, last;
+        if (*p == '-') {
+            // Sufixo: últimos N bytes
+            p++;
+            off_t suffix;
+            if (!parse_off(&p, end, &suffix)) return 0;
+            if (suffix == 0 || size == 0) goto next;
+            first = suffix >= size ? 0 : size - suffix;
+            last = size - 1;
+        } else {
+            if (!parse_off(&p, end, &first)) return 0;
+            if (p >= end || *p != '-') return 0;
+            p++;
+            if (p < end && *p >= '0' && *p <= '9') {
+                if (!parse_off(&p, end, &last) || last < first) return 0;
+                if (last >= size) last = size - 1;
+            } else {
+                last = size - 1;
+            }
+            if (first >= size) goto next;   // esta faixa não é satisfatível
+        }
+        if (n == max) return 0;
+        out[n].first = first;
+        out[n].last = last;
+        n++;
+    next:
+        while (p < end && *p == ' ') p++;
+        if (p < end && *p != ',') return 0;
+    }
+    if (!any) return 0;
+    return n > 0 ? n : -1;
+}
+
+// -----------------------------------------------------------------------------
+// 304 Not Modified: só validadores, sem corpo. Uma representação negociada
+// repete o Vary da 200 (RFC 9110 §15.4.5).
+// -----------------------------------------------------------------------------
+void util_send_304(Conn *c, const Validators *v, bool vary) {
+    char hdr[256];
+    int n = util_format_file_headers(hdr, sizeof(hdr), v);
+    conn_out_write(c, "HTTP/1.1 304 Not Modified\r\n", 27);
+    if (vary) conn_out_write(c, "Vary: Accept-Encoding\r\n", 23);
+    if (n > 0) conn_out_write(c, hdr, (size_t)n);
+    util_end_headers(c);
+}
+
+// -----------------------------------------------------------------------------
+// Formata linha de status + cabeçalhos de conteúdo, sem "Connection" nem a
+// linha em branco (assim o bloco pode ser guardado no cache e reaproveitado).
+// Retorna o tamanho escrito, ou -1 se não couber.
+// -----------------------------------------------------------------------------
+int util_format_headers(char *buf, size_t cap, const char *status, const char *ctype,
+                        long content_length) {
+    int n = snprintf(buf, cap,
         "HTTP/1.1 %s\r\n"
         "Content-Type: %s\r\n"
-        "Content-Length: %ld\r\n"
-        "Connection: close\r\n\r\n",
+        "Content-Length: %ld\r\n",
         status, ctype, content_length);
+    return (n < 0 || (size_t)n >= cap) ? -1 : n;
+}
+
+// -----------------------------------------------------------------------------
+// Fecha o bloco de cabeçalhos: "Connection" conforme a conexão + linha em branco.
+// -----------------------------------------------------------------------------
+void util_end_headers(Conn *c) {
+    if (c->keep_alive) conn_out_write(c, "Connection: keep-alive\r\n\r\n", 26);
+    else               conn_out_write(c, "Connection: close\r\n\r\n", 21);
+}
+
+// -----------------------------------------------------------------------------
+// Enfileira cabeçalhos HTTP básicos e a linha em branco final.
+// -----------------------------------------------------------------------------
+void util_send_headers(Conn *c, const char *status, const char *ctype, long content_length) {
+    char hdr[512];
+    int n = util_format_headers(hdr, sizeof(hdr), status, ctype, content_length);
+    if (n < 0) { c->state = CONN_CLOSING; return; }
+    conn_out_write(c, hdr, (size_t)n);
+    util_end_headers(c);
 }
 
 // -----------------------------------------------------------------------------
 // 400 Bad Request: request inicial inválido.
 // -----------------------------------------------------------------------------
-void util_send_400(int fd) {
+void util_send_400(Conn *c) {
     const char *body =
         "<!doctype html><meta charset='utf-8'><title>400</title>"
         "<h1>400 - Bad Request</h1>";
-    util_send_headers(fd, "400 Bad Request", "text/html; charset=utf-8", (long)strlen(body));
-    (void)send(fd, body, strlen(body), 0);
+    util_send_headers(c, "400 Bad Request", "text/html; charset=utf-8", (long)strlen(body));
+    conn_out_write(c, body, strlen(body));
 }
 
+// Página de erro simples (o corpo repete a linha de status).
+static void send_error_page(Conn *c, const char *status) {
+    char body[160];
+    int n = snprintf(body, sizeof(body),
+        "<!doctype html><meta charset='utf-8'><title>%.3s</title>"
+        "<h1>%.3s - %s</h1>", status, status, status + 4);
+    util_send_headers(c, status, "text/html; charset=utf-8", (long)n);
+    conn_out_write(c, body, (size_t)n);
+}
+
+// -----------------------------------------------------------------------------
+// 414 / 431 / 505: request recusado pelo parser (alvo longo demais, cabeçalhos
+// demais ou versão de HTTP desconhecida). A conexão fecha depois.
+// -----------------------------------------------------------------------------
+void util_send_414(Conn *c) { send_error_page(c, "414 URI Too Long"); }
+void util_send_431(Conn *c) { send_error_page(c, "431 Request Header Fields Too Large"); }
+void util_send_505(Conn *c) { send_error_page(c, "505 HTTP Version Not Supported"); }
+
 // -----------------------------------------------------------------------------
 // 404 Not Found: rota/caminho não encontrado.
 // -----------------------------------------------------------------------------
-void util_send_404(int fd) {
+void util_send_404(Conn *c) {
     const char *body =
         "<!doctype html><meta charset='utf-8'><title>404</title>"
         "<h1>404 - Not Found</h1><p>Recurso não encontrado.</p>";
-    util_send_headers(fd, "404 Not Found", "text/html; charset=utf-8", (long)strlen(body));
-    (void)send(fd, body, strlen(body), 0);
+    util_send_headers(c, "404 Not Found", "text/html; charset=utf-8", (long)strlen(body));
+    conn_out_write(c, body, strlen(body));
 }
 
 // -----------------------------------------------------------------------------
 // 405 Method Not Allowed
 // -----------------------------------------------------------------------------
-void util_send_405(int fd) {
+void util_send_405(Conn *c) {
     const char *body =
         "<!doctype html><meta charset='utf-8'><title>405</title>"
         "<h1>405 - Method Not Allowed</h1>";
-    sendf(fd,
+    conn_out_printf(c,
         "HTTP/1.1 405 Method Not Allowed\r\n"
         "Allow: GET\r\n"
         "Content-Type: text/html; charset=utf-8\r\n"
@@ -1,15 +1,55 @@
 // server_files/util.h
 #ifndef UTIL_H
 #define UTIL_H
+#include <stdbool.h>
 #include <stddef.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "conn.h"
+
+// Validadores de cache HTTP de um arquivo (ETag forte + Last-Modified).
+typedef struct {
+    char   etag[64];            // "\"<inode>-<tamanho>-<mtime ns>\"" em hexadecimal
+    char   last_modified[32];   // IMF-fixdate (RFC 9110)
+    time_t mtime;
+} Validators;
+
+// Faixa de bytes pedida via Range, com as duas pontas inclusivas.
+typedef struct {
+    off_t first, last;
+} ByteRange;
+
+#define RANGES_MAX 16   // mais faixas que isso: responde o arquivo inteiro
+
+// Codificações aceitas pelo cliente (Accept-Encoding), como máscara de bits.
+#define ENC_GZIP 1u
+#define ENC_BR   2u
 
 extern const char *g_root_dir;
 
 const char *util_mime_type(const char *path);
+bool util_mime_compressible(const char *ctype);
 void util_url_decode(char *s);
-void util_send_headers(int fd, const char *status, const char *ctype, long content_length);
-void util_send_404(int fd); 
-void util_send_400(int fd);
-void util_send_405(int fd);
+bool util_query_param(const char *query, const char *name, char *out, size_t cap);
+
+const char *util_find_header(const HttpRequest *req, const char *name, size_t *len);
+bool util_header_has_token(const char *v, size_t len, const char *token);
+unsigned util_accept_encoding(const HttpRequest *req);
+
+void util_validators(const struct stat *st, Validators *v);
+int  util_format_file_headers(char *buf, size_t cap, const Validators *v);
+bool util_not_modified(const HttpRequest *req, const Validators *v);
+int  util_parse_ranges(const HttpRequest *req, off_t size, const Validators *v, ByteRange *out, int max);
+void util_send_304(Conn *c, const Validators *v, bool vary);
+int  util_format_headers(char *buf, size_t cap, const char *status, const char *ctype,
+                         long content_length);
+void util_end_headers(Conn *c);
+void util_send_headers(Conn *c, const char *status, const char *ctype, long content_length);
+void util_send_404(Conn *c);
+void util_send_400(Conn *c);
+void util_send_405(Conn *c);
+void util_send_414(Conn *c);
+void util_send_431(Conn *c);
+void util_send_505(Conn *c);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+// Gera server_files/mime_table.h a partir de um arquivo mime.types:
+//
+//     ./tools/mime_gen server_files/mime.types > server_files/mime_table.h
+//
+// Usa o mesmo construtor de hash perfeito que o servidor usa na partida
+// (--mime-types), então a tabela compilada e a reconstruída são iguais.
+// A saída segue o formato do resto da árvore (CRLF, sem quebra no fim),
+// para que regenerar a tabela só mude as linhas que mudaram de fato.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../server_files/mime.h"
+
+// Escreve uma string C com escapes mínimos.
+static void put_cstr(const char *s) {
+    putchar('"');
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') putchar('\\');
+        putchar(*s);
+    }
+    putchar('"');
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Uso: %s mime.types > mime_table.h\n", argv[0]);
+        return 2;
+    }
+
+    MimeEntry *ents = NULL;
+    int n = mime_parse_file(argv[1], &ents);
+    if (n < 0) { perror(argv[1]); return 1; }
+
+    MimeTable t;
+    if (!mime_build(ents, (size_t)n, &t)) {
+        fprintf(stderr, "mime_gen: não foi possível montar a tabela\n");
+        return 1;
+    }
+
+    size_t ns = (size_t)1 << t.bits, nd = (size_t)1 << t.dbits, count = 0;
+    for (size_t i = 0; i < ns; i++) count += t.slots[i].type != NULL;
+
+    printf("// server_files/mime_table.h\r\n");
+    printf("// Gerado por tools/mime_gen.c a partir de server_files/mime.types\r\n");
+    printf("// (make mime-table). Não edite à mão.\r\n");
+    printf("#define MIME_TABLE_BITS  %u\r\n", t.bits);
+    printf("#define MIME_TABLE_DBITS %u\r\n", t.dbits);
+    printf("#define MIME_TABLE_COUNT %zu\r\n\r\n", count);
+
+    printf("static const uint16_t k_mime_disp[%zu] = {", nd);
+    for (size_t i = 0; i < nd; i++)
+        printf("%s%u,", (i % 12) ? " " : "\r\n    ", t.disp[i]);
+    printf("\r\n};\r\n\r\n");
+
+    printf("static const MimeSlot k_mime_slots[%zu] = {\r\n", ns);
+    for (size_t i = 0; i < ns; i++) {
+        if (!t.slots[i].type) continue;
+        printf("    [%zu] = { ", i);
+        put_cstr(t.slots[i].ext);
+        printf(", ");
+        put_cstr(t.slots[i].type);
+        printf(" },\r\n");
+    }
+    printf("};");
+    return 0;
+}
\ No newline at end of file
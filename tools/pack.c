@@ -0,0 +1,314 @@
+// Compila uma raiz de site num pacote para `server --bundle`:
+//
+//     ./tools/pack [-z] [--mime-types FILE] ./files site.pack
+//
+// Cada arquivo regular sob a raiz vira uma entrada da tabela (ordenada por
+// caminho) com Content-Type, ETag do conteúdo e Last-Modified já prontos.
+// Irmãos "<arquivo>.gz" / "<arquivo>.br" não mais antigos que o original
+// viram as variantes comprimidas dele (e continuam servidos pelo próprio
+// nome, do mesmo trecho do pacote); com -z, tipos de texto sem irmão .gz são
+// comprimidos aqui. Links simbólicos são ignorados.
+//
+// O pacote é gravado em "<saida>.tmp" e renomeado no fim: quem já serve o
+// antigo não vê um arquivo pela metade.
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../server_files/bundle.h"
+#include "../server_files/gzip.h"
+#include "../server_files/mime.h"
+
+#define COPY_BUF     (1 << 20)
+#define COMPRESS_MIN 256                // como no servidor: abaixo disso gzip não compensa
+#define COMPRESS_MAX (4 * 1024 * 1024)  // maior arquivo comprimido com -z
+
+typedef struct {
+    char       *rel;        // relativo à raiz, sem "/" inicial
+    struct stat st;
+    PackEntry   e;
+} Item;
+
+static Item  *g_items;
+static size_t g_n, g_cap;
+
+static char  *g_strs;       // tabela de strings
+static size_t g_strs_len, g_strs_cap;
+
+static void die(const char *what) {
+    perror(what);
+    exit(1);
+}
+
+static uint32_t add_str(const char *s) {
+    size_t n = strlen(s) + 1;
+    if (g_strs_len + n > g_strs_cap) {
+        g_strs_cap = (g_strs_len + n) * 2;
+        g_strs = (char *)realloc(g_strs, g_strs_cap);
+        if (!g_strs) die("realloc");
+    }
+    if (g_strs_len + n > UINT32_MAX) { fprintf(stderr, "pack: caminhos demais\n"); exit(1); }
+    memcpy(g_strs + g_strs_len, s, n);
+    uint32_t off = (uint32_t)g_strs_len;
+    g_strs_len += n;
+    return off;
+}
+
+// -----------------------------------------------------------------------------
+// Varredura da raiz
+// -----------------------------------------------------------------------------
+
+static void walk(const char *root, const char *rel) {
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s/%s", root, rel);
+    DIR *d = opendir(dir);
+    if (!d) die(dir);
+
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, "..")) continue;
+        char sub[PATH_MAX], path[PATH_MAX];
+        if (snprintf(sub, sizeof(sub), "%s%s%s", rel, *rel ? "/" : "", de->d_name) >= (int)sizeof(sub) ||
+            snprintf(path, sizeof(path), "%s/%s", root, sub) >= (int)sizeof(path)) {
+            fprintf(stderr, "pack: caminho longo demais, ignorado: %s\n", de->d_name);
+            continue;
+        }
+        struct stat st;
+        if (lstat(path, &st) < 0) die(path);
+        if (S_ISDIR(st.st_mode)) { walk(root, sub); continue; }
+        if (!S_ISREG(st.st_mode)) continue;
+
+        if (g_n == g_cap) {
+            g_cap = g_cap ? g_cap * 2 : 256;
+            g_items = (Item *)realloc(g_items, g_cap * sizeof(Item));
+            if (!g_items) die("realloc");
+        }
+        Item *it = &g_items[g_n++];
+        memset(it, 0, sizeof(*it));
+        it->rel = strdup(sub);
+        if (!it->rel) die("strdup");
+        it->st = st;
+    }
+    closedir(d);
+}
+
+static int cmp_item(const void *a, const void *b) {
+    return strcmp(((const Item *)a)->rel, ((const Item *)b)->rel);
+}
+
+static Item *find_item(const char *rel) {
+    Item key = { .rel = (char *)rel };
+    return (Item *)bsearch(&key, g_items, g_n, sizeof(Item), cmp_item);
+}
+
+// a é anterior a b (segundos, depois nanossegundos).
+static bool mtime_before(const struct timespec *a, const struct timespec *b) {
+    return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+// -----------------------------------------------------------------------------
+// Escrita
+// -----------------------------------------------------------------------------
+
+static int    g_out;
+static off_t  g_pos;        // fim dos corpos já gravados
+
+static void write_all(const void *p, size_t len) {
+    const char *b = (const char *)p;
+    while (len > 0) {
+        ssize_t w = write(g_out, b, len);
+        if (w < 0) { if (errno == EINTR) continue; die("write"); }
+        b += w;
+        len -= (size_t)w;
+    }
+    g_pos += (off_t)(b - (const char *)p);
+}
+
+// FNV-1a 64 bits, incremental.
+static uint64_t fnv(uint64_t h, const unsigned char *p, size_t n) {
+    for (size_t i = 0; i < n; i++) { h ^= p[i]; h *= 1099511628211ULL; }
+    return h;
+}
+
+// Copia o arquivo para o fim do pacote; devolve o trecho e o hash do conteúdo.
+static PackBlob copy_file(const char *path, uint64_t *hash) {
+    static char buf[COPY_BUF];
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) die(path);
+    PackBlob b = { (uint64_t)g_pos, 0 };
+    uint64_t h = 1469598103934665603ULL;
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0) { if (errno == EINTR) continue; die(path); }
+        if (n == 0) break;
+        h = fnv(h, (const unsigned char *)buf, (size_t)n);
+        write_all(buf, (size_t)n);
+        b.len += (uint64_t)n;
+    }
+    close(fd);
+    *hash = h;
+    return b;
+}
+
+static char *read_file(const char *path, size_t size) {
+    char *p = (char *)malloc(size ? size : 1);
+    if (!p) die("malloc");
+    FILE *f = fopen(path, "rb");
+    if (!f || fread(p, 1, size, f) != size) die(path);
+    fclose(f);
+    return p;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "Uso: %s [-z] [--mime-types FILE] <raiz> <saida.pack>\n"
+        "  -z                 comprime com gzip os tipos de texto sem irmão .gz\n"
+        "  --mime-types FILE  tipos extras, como no servidor\n",
+        prog);
+}
+
+int main(int argc, char **argv) {
+    bool gz = false;
+    const char *root = NULL, *out = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-z")) {
+            gz = true;
+        } else if (!strcmp(argv[i], "--mime-types") && i + 1 < argc) {
+            if (mime_load(argv[++i]) < 0) { fprintf(stderr, "pack: não abriu %s\n", argv[i]); return 1; }
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else if (!root) {
+            root = argv[i];
+        } else if (!out) {
+            out = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!root || !out) { usage(argv[0]); return 2; }
+
+    walk(root, "");
+    qsort(g_items, g_n, sizeof(Item), cmp_item);
+    if (g_n == 0) { fprintf(stderr, "pack: nenhum arquivo em %s\n", root); return 1; }
+    if (g_n > UINT32_MAX) { fprintf(stderr, "pack: arquivos demais\n"); return 1; }
+
+    // Strings primeiro: com elas o índice tem tamanho conhecido e os corpos
+    // começam logo depois, numa página nova
+    const char *ctypes[64];
+    uint32_t ctype_off[64];
+    size_t nctypes = 0;
+    for (size_t i = 0; i < g_n; i++) {
+        PackEntry *e = &g_items[i].e;
+        e->path = add_str(g_items[i].rel);
+        const char *t = mime_lookup(g_items[i].rel);
+        size_t k = 0;
+        while (k < nctypes && ctypes[k] != t) k++;
+        if (k == nctypes) {
+            if (nctypes == 64) { e->ctype = add_str(t); continue; }
+            ctypes[nctypes] = t;
+            ctype_off[nctypes++] = add_str(t);
+        }
+        e->ctype = ctype_off[k];
+    }
+
+    PackHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, PACK_MAGIC, sizeof(h.magic));
+    h.version = PACK_VERSION;
+    h.count = (uint32_t)g_n;
+    h.entries = (sizeof(h) + 7) & ~(uint64_t)7;
+    h.strings = h.entries + g_n * sizeof(PackEntry);
+    h.strings_len = g_strs_len;
+    uint64_t data = (h.strings + h.strings_len + 4095) & ~(uint64_t)4095;
+
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", out);
+    g_out = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (g_out < 0) die(tmp);
+    if (lseek(g_out, (off_t)data, SEEK_SET) < 0) die("lseek");
+    g_pos = (off_t)data;
+
+    // Corpos na ordem da tabela: arquivos vizinhos ficam vizinhos no disco
+    for (size_t i = 0; i < g_n; i++) {
+        Item *it = &g_items[i];
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", root, it->rel);
+        uint64_t hash;
+        it->e.body[PACK_IDENTITY] = copy_file(path, &hash);
+        if (it->e.body[PACK_IDENTITY].len != (uint64_t)it->st.st_size) {
+            fprintf(stderr, "pack: %s mudou durante a leitura\n", path);
+            return 1;
+        }
+        it->e.variants = 1u << PACK_IDENTITY;
+        it->e.mtime = (int64_t)it->st.st_mtim.tv_sec;
+        snprintf(it->e.etag, sizeof(it->e.etag), "\"%016llx\"", (unsigned long long)hash);
+        struct tm tm;
+        time_t mt = it->st.st_mtim.tv_sec;
+        gmtime_r(&mt, &tm);
+        strftime(it->e.last_modified, sizeof(it->e.last_modified), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    }
+
+    // Variantes: irmãos já gravados, ou gzip feito agora (-z)
+    size_t nsib = 0, nzip = 0;
+    for (size_t i = 0; i < g_n; i++) {
+        Item *it = &g_items[i];
+        static const struct { int v; const char *ext; } sib[] = {
+            { PACK_GZIP, ".gz" }, { PACK_BR, ".br" },
+        };
+        for (size_t k = 0; k < sizeof(sib) / sizeof(sib[0]); k++) {
+            char name[PATH_MAX];
+            snprintf(name, sizeof(name), "%s%s", it->rel, sib[k].ext);
+            Item *s = find_item(name);
+            if (!s || mtime_before(&s->st.st_mtim, &it->st.st_mtim)) continue;
+            it->e.body[sib[k].v] = s->e.body[PACK_IDENTITY];
+            it->e.variants |= 1u << sib[k].v;
+            nsib++;
+        }
+
+        size_t size = (size_t)it->st.st_size;
+        if (!gz || (it->e.variants & (1u << PACK_GZIP)) || size < COMPRESS_MIN || size > COMPRESS_MAX ||
+            !mime_compressible(g_strs + it->e.ctype))
+            continue;
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", root, it->rel);
+        char *raw = read_file(path, size);
+        size_t zlen = 0;
+        char *z = gzip_compress(raw, size, &zlen);
+        if (z && zlen < size) {
+            it->e.body[PACK_GZIP] = (PackBlob){ (uint64_t)g_pos, zlen };
+            it->e.variants |= 1u << PACK_GZIP;
+            write_all(z, zlen);
+            nzip++;
+        }
+        free(z);
+        free(raw);
+    }
+
+    // Índice por último, no espaço reservado no início
+    h.size = (uint64_t)g_pos;
+    PackEntry *ents = (PackEntry *)calloc(g_n ? g_n : 1, sizeof(PackEntry));
+    if (!ents) die("calloc");
+    for (size_t i = 0; i < g_n; i++) ents[i] = g_items[i].e;
+    if (pwrite(g_out, &h, sizeof(h), 0) != (ssize_t)sizeof(h) ||
+        pwrite(g_out, ents, g_n * sizeof(PackEntry), (off_t)h.entries) != (ssize_t)(g_n * sizeof(PackEntry)) ||
+        pwrite(g_out, g_strs, g_strs_len, (off_t)h.strings) != (ssize_t)g_strs_len)
+        die("pwrite");
+    if (fsync(g_out) < 0) die("fsync");
+    close(g_out);
+    if (rename(tmp, out) < 0) die("rename");
+
+    printf("%s: %zu arquivos, %zu variantes de irmãos, %zu comprimidos agora, %lld bytes\n",
+           out, g_n, nsib, nzip, (long long)h.size);
+    return 0;
+}
\ No newline at end of file